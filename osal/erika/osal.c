@@ -45,6 +45,22 @@ ec_timet osal_current_time(void)
    	return ret;
 }
 
+int64 osal_current_time_ns(void)
+{
+	return (int64)osEE_x86_64_tsc_read();
+}
+
+int osal_sleep_until_ns(int64 wakeup_ns)
+{
+	int64 delta;
+
+	/* no absolute sleep available, sleep for the remaining time */
+	delta = wakeup_ns - osal_current_time_ns();
+	if (delta <= 0)
+		return 0;
+	return osal_usleep((uint32)(delta / 1000));
+}
+
 void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
 {
    	if (end->usec < start->usec) {
@@ -56,39 +72,19 @@ void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
    	}
 }
 
-void osal_timer_start(osal_timert *self, uint32 timeout_usec)
+void osal_timer_start(osal_timert * self, uint32 timeout_usec)
 {
-   	struct timeval start_time;
-   	struct timeval timeout;
-   	struct timeval stop_time;
-
-   	osal_gettimeofday(&start_time, 0);
-   	timeout.tv_sec = timeout_usec / USECS_PER_SEC;
-   	timeout.tv_usec = timeout_usec % USECS_PER_SEC;
-   	timeradd(&start_time, &timeout, &stop_time);
-
-   	self->stop_time.sec = stop_time.tv_sec;
-   	self->stop_time.usec = stop_time.tv_usec;
+	osal_timer_start_ns(self, (int64)timeout_usec * 1000);
 }
 
-boolean osal_timer_is_expired (osal_timert *self)
+void osal_timer_start_ns(osal_timert * self, int64 timeout_ns)
 {
-   	struct timeval current_time;
-   	struct timeval stop_time;
-   	int is_not_yet_expired;
-
-   	osal_gettimeofday (&current_time, 0);
-   	stop_time.tv_sec = self->stop_time.sec;
-   	stop_time.tv_usec = self->stop_time.usec;
-   	is_not_yet_expired = timercmp (&current_time, &stop_time, <);
-/* 	OSEE_PRINT("current: %d:%d -- expire: %d:%d -- result: %d\n", */
-/* 			current_time.tv_sec, */
-/* 			current_time.tv_usec, */
-/* 			stop_time.tv_sec, */
-/* 			stop_time.tv_usec, */
-/* 			is_not_yet_expired); */
+	self->stop_time = osal_current_time_ns() + timeout_ns;
+}
 
-   	return is_not_yet_expired == FALSE;
+boolean osal_timer_is_expired(osal_timert * self)
+{
+	return osal_timer_is_expired_at(self, osal_current_time_ns());
 }
 
 void *osal_malloc(size_t size)
@@ -101,3 +97,56 @@ void osal_free(void *ptr)
    	free(ptr);
 }
 
+/* Single threaded, mutexes only need a valid handle */
+static uint8 osal_mtx_dummy;
+
+osal_mutex_t * osal_mtx_create(void)
+{
+	return (osal_mutex_t *)&osal_mtx_dummy;
+}
+
+void osal_mtx_lock(osal_mutex_t * mtx)
+{
+	(void)mtx;
+}
+
+void osal_mtx_unlock(osal_mutex_t * mtx)
+{
+	(void)mtx;
+}
+
+void osal_mtx_destroy(osal_mutex_t * mtx)
+{
+	(void)mtx;
+}
+
+/* Single threaded, semaphores only need a valid handle */
+static int osal_sem_dummy;
+
+osal_sem_t * osal_sem_create(int count)
+{
+	(void)count;
+	return (osal_sem_t *)&osal_sem_dummy;
+}
+
+void osal_sem_post(osal_sem_t * sem)
+{
+	(void)sem;
+}
+
+void osal_sem_wait(osal_sem_t * sem)
+{
+	(void)sem;
+}
+
+boolean osal_sem_timedwait(osal_sem_t * sem, uint32 timeout_usec)
+{
+	(void)sem;
+	(void)timeout_usec;
+	return TRUE;
+}
+
+void osal_sem_destroy(osal_sem_t * sem)
+{
+	(void)sem;
+}
@@ -11,6 +11,7 @@ static int64_t sysfrequency;
 static double qpc2usec;
 
 #define USECS_PER_SEC     1000000
+#define NSECS_PER_SEC     1000000000LL
 
 int osal_gettimeofday (struct timeval *tv, struct timezone *tz)
 {
@@ -28,33 +29,40 @@ ec_timet osal_current_time (void)
    return return_value;
 }
 
-void osal_timer_start (osal_timert * self, uint32 timeout_usec)
+int64 osal_current_time_ns(void)
 {
-   struct timeval start_time;
-   struct timeval timeout;
-   struct timeval stop_time;
+   struct timeval current_time;
 
-   osal_gettimeofday (&start_time, 0);
-   timeout.tv_sec = timeout_usec / USECS_PER_SEC;
-   timeout.tv_usec = timeout_usec % USECS_PER_SEC;
-   timeradd (&start_time, &timeout, &stop_time);
+   osal_gettimeofday(&current_time, 0);
+   return ((int64)current_time.tv_sec * NSECS_PER_SEC) + ((int64)current_time.tv_usec * 1000);
+}
 
-   self->stop_time.sec = stop_time.tv_sec;
-   self->stop_time.usec = stop_time.tv_usec;
+int osal_sleep_until_ns(int64 wakeup_ns)
+{
+   int64 delta;
+
+   /* no absolute sleep available, sleep for the remaining time */
+   delta = wakeup_ns - osal_current_time_ns();
+   if (delta <= 0)
+   {
+      return 0;
+   }
+   return osal_usleep((uint32)(delta / 1000));
 }
 
-boolean osal_timer_is_expired (osal_timert * self)
+void osal_timer_start(osal_timert * self, uint32 timeout_usec)
 {
-   struct timeval current_time;
-   struct timeval stop_time;
-   int is_not_yet_expired;
+   osal_timer_start_ns(self, (int64)timeout_usec * 1000);
+}
 
-   osal_gettimeofday (&current_time, 0);
-   stop_time.tv_sec = self->stop_time.sec;
-   stop_time.tv_usec = self->stop_time.usec;
-   is_not_yet_expired = timercmp (&current_time, &stop_time, <);
+void osal_timer_start_ns(osal_timert * self, int64 timeout_ns)
+{
+   self->stop_time = osal_current_time_ns() + timeout_ns;
+}
 
-   return is_not_yet_expired == FALSE;
+boolean osal_timer_is_expired(osal_timert * self)
+{
+   return osal_timer_is_expired_at(self, osal_current_time_ns());
 }
 
 int osal_usleep(uint32 usec)
@@ -86,3 +94,37 @@ osal_mutex_t * osal_mtx_create(void)
         /* return (void*)RtCreateMutex(NULL, FALSE, NULL); */
         return (void *)0;
 }
+
+void osal_mtx_destroy(osal_mutex_t * mtx)
+{
+        /* RtDeleteMutex((HANDLE)mtx); */
+}
+
+/* Semaphore is not needed when running single threaded */
+
+osal_sem_t * osal_sem_create(int count)
+{
+        /* return (void*)RtCreateSemaphore(NULL, count, 0x7fffffff, NULL); */
+        return (void *)0;
+}
+
+void osal_sem_post(osal_sem_t * sem)
+{
+        /* RtReleaseSemaphore((HANDLE)sem, 1, NULL); */
+}
+
+void osal_sem_wait(osal_sem_t * sem)
+{
+        /* RtWaitForSingleObject((HANDLE)sem, INFINITE); */
+}
+
+boolean osal_sem_timedwait(osal_sem_t * sem, uint32 timeout_usec)
+{
+        /* return (RtWaitForSingleObject((HANDLE)sem, (timeout_usec + 999) / 1000) == WAIT_OBJECT_0); */
+        return TRUE;
+}
+
+void osal_sem_destroy(osal_sem_t * sem)
+{
+        /* RtCloseHandle((HANDLE)sem); */
+}
@@ -3,14 +3,25 @@
  * LICENSE file in the project root for full license information
  */
 
+/* sem_clockwait() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <time.h>
 #include <sys/time.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <semaphore.h>
 #include <osal.h>
+#if defined(OSAL_USE_TSC) && defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
 
 #define USECS_PER_SEC     1000000
+#define NSECS_PER_SEC     1000000000LL
 
 int osal_usleep (uint32 usec)
 {
@@ -21,33 +32,110 @@ int osal_usleep (uint32 usec)
    return nanosleep(&ts, NULL);
 }
 
-int osal_gettimeofday(struct timeval *tv, struct timezone *tz)
+/* Monotonic clock in ns. CLOCK_MONOTONIC is served from the vDSO without a
+ * system call and is not affected by NTP steps. */
+static int64 osal_clock_ns(void)
 {
    struct timespec ts;
-   int return_value;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((int64)ts.tv_sec * NSECS_PER_SEC) + ts.tv_nsec;
+}
+
+#if defined(OSAL_USE_TSC) && defined(__x86_64__)
+/* Optional TSC fast path, build with -DOSAL_USE_TSC. The TSC is calibrated
+ * once against CLOCK_MONOTONIC and only used when it is invariant. */
+static pthread_once_t osal_tsc_once = PTHREAD_ONCE_INIT;
+static int osal_tsc_valid;
+static uint64 osal_tsc_base;
+static int64 osal_tsc_basens;
+/* ns per TSC tick, 32.32 fixed point */
+static uint64 osal_tsc_mult;
+
+static void osal_tsc_calibrate(void)
+{
+   unsigned int eax, ebx, ecx, edx;
+   uint64 tsc0, tsc1;
+   int64 ns0, ns1;
+
+   if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 8)))
+   {
+      return;
+   }
+   ns0 = osal_clock_ns();
+   tsc0 = __rdtsc();
+   osal_usleep(10000);
+   ns1 = osal_clock_ns();
+   tsc1 = __rdtsc();
+   if (tsc1 <= tsc0)
+   {
+      return;
+   }
+   osal_tsc_mult = (uint64)(((unsigned __int128)(ns1 - ns0) << 32) / (tsc1 - tsc0));
+   osal_tsc_base = tsc1;
+   osal_tsc_basens = ns1;
+   osal_tsc_valid = 1;
+}
+
+int64 osal_current_time_ns(void)
+{
+   pthread_once(&osal_tsc_once, osal_tsc_calibrate);
+   if (osal_tsc_valid)
+   {
+      return osal_tsc_basens +
+         (int64)(((unsigned __int128)(__rdtsc() - osal_tsc_base) * osal_tsc_mult) >> 32);
+   }
+   return osal_clock_ns();
+}
+#else
+int64 osal_current_time_ns(void)
+{
+   return osal_clock_ns();
+}
+#endif
+
+int osal_gettimeofday(struct timeval *tv, struct timezone *tz)
+{
+   int64 ns;
    (void)tz;       /* Not used */
 
-   /* Use clock_gettime to prevent possible live-lock.
-    * Gettimeofday uses CLOCK_REALTIME that can get NTP timeadjust.
-    * If this function preempts timeadjust and it uses vpage it live-locks.
-    * Also when using XENOMAI, only clock_gettime is RT safe */
-   return_value = clock_gettime(CLOCK_MONOTONIC, &ts);
-   tv->tv_sec = ts.tv_sec;
-   tv->tv_usec = ts.tv_nsec / 1000;
-   return return_value;
+   /* Monotonic time instead of CLOCK_REALTIME, see osal_clock_ns() */
+   ns = osal_current_time_ns();
+   tv->tv_sec = ns / NSECS_PER_SEC;
+   tv->tv_usec = (ns % NSECS_PER_SEC) / 1000;
+   return 0;
 }
 
 ec_timet osal_current_time(void)
 {
-   struct timeval current_time;
    ec_timet return_value;
+   int64 ns;
 
-   osal_gettimeofday(&current_time, 0);
-   return_value.sec = current_time.tv_sec;
-   return_value.usec = current_time.tv_usec;
+   ns = osal_current_time_ns();
+   return_value.sec = ns / NSECS_PER_SEC;
+   return_value.usec = (ns % NSECS_PER_SEC) / 1000;
    return return_value;
 }
 
+int osal_sleep_until_ns(int64 wakeup_ns)
+{
+   struct timespec ts;
+   int ret;
+
+#if defined(OSAL_USE_TSC) && defined(__x86_64__)
+   /* TSC time may drift from CLOCK_MONOTONIC, sleep on the clock offset now */
+   wakeup_ns += osal_clock_ns() - osal_current_time_ns();
+#endif
+   ts.tv_sec = wakeup_ns / NSECS_PER_SEC;
+   ts.tv_nsec = wakeup_ns % NSECS_PER_SEC;
+   /* absolute wakeup, restart with the same deadline when interrupted */
+   do
+   {
+      ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+   } while (ret == EINTR);
+   return ret;
+}
+
 void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
 {
    if (end->usec < start->usec) {
@@ -62,31 +150,17 @@ void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
 
 void osal_timer_start(osal_timert * self, uint32 timeout_usec)
 {
-   struct timeval start_time;
-   struct timeval timeout;
-   struct timeval stop_time;
-
-   osal_gettimeofday(&start_time, 0);
-   timeout.tv_sec = timeout_usec / USECS_PER_SEC;
-   timeout.tv_usec = timeout_usec % USECS_PER_SEC;
-   timeradd(&start_time, &timeout, &stop_time);
-
-   self->stop_time.sec = stop_time.tv_sec;
-   self->stop_time.usec = stop_time.tv_usec;
+   osal_timer_start_ns(self, (int64)timeout_usec * 1000);
 }
 
-boolean osal_timer_is_expired (osal_timert * self)
+void osal_timer_start_ns(osal_timert * self, int64 timeout_ns)
 {
-   struct timeval current_time;
-   struct timeval stop_time;
-   int is_not_yet_expired;
-
-   osal_gettimeofday(&current_time, 0);
-   stop_time.tv_sec = self->stop_time.sec;
-   stop_time.tv_usec = self->stop_time.usec;
-   is_not_yet_expired = timercmp(&current_time, &stop_time, <);
+   self->stop_time = osal_current_time_ns() + timeout_ns;
+}
 
-   return is_not_yet_expired == FALSE;
+boolean osal_timer_is_expired(osal_timert * self)
+{
+   return osal_timer_is_expired_at(self, osal_current_time_ns());
 }
 
 void *osal_malloc(size_t size)
@@ -142,3 +216,122 @@ int osal_thread_create_rt(void *thandle, int stacksize, void *func, void *param)
 
    return 1;
 }
+
+osal_mutex_t * osal_mtx_create(void)
+{
+   pthread_mutexattr_t  mutexattr;
+   pthread_mutex_t      *mtx;
+
+   mtx = malloc(sizeof(*mtx));
+   if (mtx)
+   {
+      pthread_mutexattr_init(&mutexattr);
+      pthread_mutexattr_setprotocol(&mutexattr, PTHREAD_PRIO_INHERIT);
+      pthread_mutex_init(mtx, &mutexattr);
+      pthread_mutexattr_destroy(&mutexattr);
+   }
+   return (osal_mutex_t *)mtx;
+}
+
+void osal_mtx_lock(osal_mutex_t * mtx)
+{
+   pthread_mutex_lock((pthread_mutex_t *)mtx);
+}
+
+void osal_mtx_unlock(osal_mutex_t * mtx)
+{
+   pthread_mutex_unlock((pthread_mutex_t *)mtx);
+}
+
+void osal_mtx_destroy(osal_mutex_t * mtx)
+{
+   pthread_mutex_destroy((pthread_mutex_t *)mtx);
+   free(mtx);
+}
+
+osal_sem_t * osal_sem_create(int count)
+{
+   sem_t *sem;
+
+   sem = malloc(sizeof(*sem));
+   if (sem && sem_init(sem, 0, (unsigned int)count))
+   {
+      free(sem);
+      sem = NULL;
+   }
+   return (osal_sem_t *)sem;
+}
+
+void osal_sem_post(osal_sem_t * sem)
+{
+   sem_post((sem_t *)sem);
+}
+
+void osal_sem_wait(osal_sem_t * sem)
+{
+   while (sem_wait((sem_t *)sem) && (errno == EINTR));
+}
+
+/* sem_timedwait() only takes a CLOCK_REALTIME deadline, wait in slices of at
+ * most this many ns so a time step can not stretch a wait by more */
+#define OSAL_SEMSLICE_NS  10000000LL
+
+static void osal_timespec_add_ns(struct timespec *ts, int64 ns)
+{
+   ts->tv_sec += (time_t)(ns / NSECS_PER_SEC);
+   ts->tv_nsec += (long)(ns % NSECS_PER_SEC);
+   if (ts->tv_nsec >= NSECS_PER_SEC)
+   {
+      ts->tv_sec++;
+      ts->tv_nsec -= NSECS_PER_SEC;
+   }
+}
+
+boolean osal_sem_timedwait(osal_sem_t * sem, uint32 timeout_usec)
+{
+   struct timespec ts;
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 30))
+   int rval;
+
+   /* deadline on the monotonic clock, not moved by steps of the system time */
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   osal_timespec_add_ns(&ts, (int64)timeout_usec * 1000);
+   while ((rval = sem_clockwait((sem_t *)sem, CLOCK_MONOTONIC, &ts)) && (errno == EINTR));
+
+   return (rval == 0);
+#else
+   osal_timert timer;
+   int64 left;
+
+   /* the deadline is kept on the monotonic clock of osal_current_time_ns() */
+   osal_timer_start(&timer, timeout_usec);
+   for (;;)
+   {
+      left = osal_timer_left_ns(&timer, osal_current_time_ns());
+      if (left <= 0)
+      {
+         return (sem_trywait((sem_t *)sem) == 0);
+      }
+      if (left > OSAL_SEMSLICE_NS)
+      {
+         left = OSAL_SEMSLICE_NS;
+      }
+      clock_gettime(CLOCK_REALTIME, &ts);
+      osal_timespec_add_ns(&ts, left);
+      if (!sem_timedwait((sem_t *)sem, &ts))
+      {
+         return TRUE;
+      }
+      if ((errno != ETIMEDOUT) && (errno != EINTR))
+      {
+         return FALSE;
+      }
+   }
+#endif
+}
+
+void osal_sem_destroy(osal_sem_t * sem)
+{
+   sem_destroy((sem_t *)sem);
+   free(sem);
+}
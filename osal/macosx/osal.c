@@ -11,6 +11,7 @@
 #include <osal.h>
 
 #define USECS_PER_SEC     1000000
+#define NSECS_PER_SEC     1000000000LL
 
 int osal_usleep (uint32 usec)
 {
@@ -48,6 +49,27 @@ ec_timet osal_current_time(void)
    return return_value;
 }
 
+int64 osal_current_time_ns(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((int64)ts.tv_sec * NSECS_PER_SEC) + ts.tv_nsec;
+}
+
+int osal_sleep_until_ns(int64 wakeup_ns)
+{
+   int64 delta;
+
+   /* no absolute sleep available, sleep for the remaining time */
+   delta = wakeup_ns - osal_current_time_ns();
+   if (delta <= 0)
+   {
+      return 0;
+   }
+   return osal_usleep((uint32)(delta / 1000));
+}
+
 void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
 {
    if (end->usec < start->usec) {
@@ -62,31 +84,17 @@ void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
 
 void osal_timer_start(osal_timert * self, uint32 timeout_usec)
 {
-   struct timeval start_time;
-   struct timeval timeout;
-   struct timeval stop_time;
-
-   osal_gettimeofday(&start_time, 0);
-   timeout.tv_sec = timeout_usec / USECS_PER_SEC;
-   timeout.tv_usec = timeout_usec % USECS_PER_SEC;
-   timeradd(&start_time, &timeout, &stop_time);
-
-   self->stop_time.sec = stop_time.tv_sec;
-   self->stop_time.usec = stop_time.tv_usec;
+   osal_timer_start_ns(self, (int64)timeout_usec * 1000);
 }
 
-boolean osal_timer_is_expired (osal_timert * self)
+void osal_timer_start_ns(osal_timert * self, int64 timeout_ns)
 {
-   struct timeval current_time;
-   struct timeval stop_time;
-   int is_not_yet_expired;
-
-   osal_gettimeofday(&current_time, 0);
-   stop_time.tv_sec = self->stop_time.sec;
-   stop_time.tv_usec = self->stop_time.usec;
-   is_not_yet_expired = timercmp(&current_time, &stop_time, <);
+   self->stop_time = osal_current_time_ns() + timeout_ns;
+}
 
-   return is_not_yet_expired == FALSE;
+boolean osal_timer_is_expired(osal_timert * self)
+{
+   return osal_timer_is_expired_at(self, osal_current_time_ns());
 }
 
 void *osal_malloc(size_t size)
@@ -142,3 +150,116 @@ int osal_thread_create_rt(void *thandle, int stacksize, void *func, void *param)
 
    return 1;
 }
+
+osal_mutex_t * osal_mtx_create(void)
+{
+   pthread_mutexattr_t  mutexattr;
+   pthread_mutex_t      *mtx;
+
+   mtx = malloc(sizeof(*mtx));
+   if (mtx)
+   {
+      pthread_mutexattr_init(&mutexattr);
+      pthread_mutexattr_setprotocol(&mutexattr, PTHREAD_PRIO_INHERIT);
+      pthread_mutex_init(mtx, &mutexattr);
+      pthread_mutexattr_destroy(&mutexattr);
+   }
+   return (osal_mutex_t *)mtx;
+}
+
+void osal_mtx_lock(osal_mutex_t * mtx)
+{
+   pthread_mutex_lock((pthread_mutex_t *)mtx);
+}
+
+void osal_mtx_unlock(osal_mutex_t * mtx)
+{
+   pthread_mutex_unlock((pthread_mutex_t *)mtx);
+}
+
+void osal_mtx_destroy(osal_mutex_t * mtx)
+{
+   pthread_mutex_destroy((pthread_mutex_t *)mtx);
+   free(mtx);
+}
+
+/* unnamed POSIX semaphores are not available, use a condition variable */
+typedef struct
+{
+   pthread_mutex_t   mtx;
+   pthread_cond_t    cond;
+   int               count;
+} osal_macsem_t;
+
+osal_sem_t * osal_sem_create(int count)
+{
+   osal_macsem_t *sem;
+
+   sem = malloc(sizeof(*sem));
+   if (sem)
+   {
+      pthread_mutex_init(&sem->mtx, NULL);
+      pthread_cond_init(&sem->cond, NULL);
+      sem->count = count;
+   }
+   return (osal_sem_t *)sem;
+}
+
+void osal_sem_post(osal_sem_t * sem)
+{
+   osal_macsem_t *s = (osal_macsem_t *)sem;
+
+   pthread_mutex_lock(&s->mtx);
+   s->count++;
+   pthread_cond_signal(&s->cond);
+   pthread_mutex_unlock(&s->mtx);
+}
+
+void osal_sem_wait(osal_sem_t * sem)
+{
+   osal_macsem_t *s = (osal_macsem_t *)sem;
+
+   pthread_mutex_lock(&s->mtx);
+   while (s->count <= 0)
+   {
+      pthread_cond_wait(&s->cond, &s->mtx);
+   }
+   s->count--;
+   pthread_mutex_unlock(&s->mtx);
+}
+
+boolean osal_sem_timedwait(osal_sem_t * sem, uint32 timeout_usec)
+{
+   osal_macsem_t *s = (osal_macsem_t *)sem;
+   struct timeval tv;
+   struct timespec ts;
+   boolean taken = FALSE;
+
+   gettimeofday(&tv, NULL);
+   ts.tv_sec = tv.tv_sec + timeout_usec / USECS_PER_SEC;
+   ts.tv_nsec = (tv.tv_usec + timeout_usec % USECS_PER_SEC) * 1000;
+   if (ts.tv_nsec >= NSECS_PER_SEC)
+   {
+      ts.tv_sec++;
+      ts.tv_nsec -= NSECS_PER_SEC;
+   }
+   pthread_mutex_lock(&s->mtx);
+   while ((s->count <= 0) && !pthread_cond_timedwait(&s->cond, &s->mtx, &ts));
+   if (s->count > 0)
+   {
+      s->count--;
+      taken = TRUE;
+   }
+   pthread_mutex_unlock(&s->mtx);
+
+   return taken;
+}
+
+void osal_sem_destroy(osal_sem_t * sem)
+{
+   osal_macsem_t *s = (osal_macsem_t *)sem;
+
+   pthread_cond_destroy(&s->cond);
+   pthread_mutex_destroy(&s->mtx);
+   free(s);
+}
@@ -41,17 +41,59 @@ typedef struct
 
 typedef struct osal_timer
 {
-    ec_timet stop_time;
+    int64 stop_time;    /*< Monotonic time in ns, see osal_current_time_ns() */
 } osal_timert;
 
+#ifndef OSAL_INLINE
+#define OSAL_INLINE static inline
+#endif
+
+/* Full memory barrier for data shared between threads without a lock */
+#ifndef OSAL_MEMBAR
+#define OSAL_MEMBAR() __sync_synchronize()
+#endif
+
 void osal_timer_start(osal_timert * self, uint32 timeout_us);
+void osal_timer_start_ns(osal_timert * self, int64 timeout_ns);
 boolean osal_timer_is_expired(osal_timert * self);
 int osal_usleep(uint32 usec);
 ec_timet osal_current_time(void);
+int64 osal_current_time_ns(void);
+int osal_sleep_until_ns(int64 wakeup_ns);
+
+/* Expiry check against a time already read with osal_current_time_ns(),
+ * for wait loops that need the current time anyway */
+OSAL_INLINE boolean osal_timer_is_expired_at(const osal_timert * self, int64 now_ns)
+{
+    return (now_ns >= self->stop_time) ? TRUE : FALSE;
+}
+
+/* Time in ns until expiry, negative when expired */
+OSAL_INLINE int64 osal_timer_left_ns(const osal_timert * self, int64 now_ns)
+{
+    return self->stop_time - now_ns;
+}
 void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff);
 int osal_thread_create(void *thandle, int stacksize, void *func, void *param);
 int osal_thread_create_rt(void *thandle, int stacksize, void *func, void *param);
 
+/* Opaque mutex, implemented per port */
+typedef struct osal_mutex osal_mutex_t;
+
+osal_mutex_t * osal_mtx_create(void);
+void osal_mtx_lock(osal_mutex_t * mtx);
+void osal_mtx_unlock(osal_mutex_t * mtx);
+void osal_mtx_destroy(osal_mutex_t * mtx);
+
+/* Opaque counting semaphore, implemented per port */
+typedef struct osal_sem osal_sem_t;
+
+osal_sem_t * osal_sem_create(int count);
+void osal_sem_post(osal_sem_t * sem);
+void osal_sem_wait(osal_sem_t * sem);
+boolean osal_sem_timedwait(osal_sem_t * sem, uint32 timeout_usec);
+void osal_sem_destroy(osal_sem_t * sem);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,9 +8,12 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <semaphore.h>
 #include <osal.h>
 
 #define USECS_PER_SEC     1000000
+#define NSECS_PER_SEC     1000000000LL
 
 int osal_usleep (uint32 usec)
 {
@@ -48,6 +51,29 @@ ec_timet osal_current_time(void)
    return return_value;
 }
 
+int64 osal_current_time_ns(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((int64)ts.tv_sec * NSECS_PER_SEC) + ts.tv_nsec;
+}
+
+int osal_sleep_until_ns(int64 wakeup_ns)
+{
+   struct timespec ts;
+   int ret;
+
+   ts.tv_sec = wakeup_ns / NSECS_PER_SEC;
+   ts.tv_nsec = wakeup_ns % NSECS_PER_SEC;
+   /* absolute wakeup, restart with the same deadline when interrupted */
+   do
+   {
+      ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+   } while (ret == EINTR);
+   return ret;
+}
+
 void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
 {
    if (end->usec < start->usec) {
@@ -62,31 +88,17 @@ void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
 
 void osal_timer_start(osal_timert * self, uint32 timeout_usec)
 {
-   struct timeval start_time;
-   struct timeval timeout;
-   struct timeval stop_time;
-
-   osal_gettimeofday(&start_time, 0);
-   timeout.tv_sec = timeout_usec / USECS_PER_SEC;
-   timeout.tv_usec = timeout_usec % USECS_PER_SEC;
-   timeradd(&start_time, &timeout, &stop_time);
-
-   self->stop_time.sec = stop_time.tv_sec;
-   self->stop_time.usec = stop_time.tv_usec;
+   osal_timer_start_ns(self, (int64)timeout_usec * 1000);
 }
 
-boolean osal_timer_is_expired (osal_timert * self)
+void osal_timer_start_ns(osal_timert * self, int64 timeout_ns)
 {
-   struct timeval current_time;
-   struct timeval stop_time;
-   int is_not_yet_expired;
-
-   osal_gettimeofday(&current_time, 0);
-   stop_time.tv_sec = self->stop_time.sec;
-   stop_time.tv_usec = self->stop_time.usec;
-   is_not_yet_expired = timercmp(&current_time, &stop_time, <);
+   self->stop_time = osal_current_time_ns() + timeout_ns;
+}
 
-   return is_not_yet_expired == FALSE;
+boolean osal_timer_is_expired(osal_timert * self)
+{
+   return osal_timer_is_expired_at(self, osal_current_time_ns());
 }
 
 void *osal_malloc(size_t size)
@@ -142,3 +154,111 @@ int osal_thread_create_rt(void *thandle, int stacksize, void *func, void *param)
 
    return 1;
 }
+
+osal_mutex_t * osal_mtx_create(void)
+{
+   pthread_mutexattr_t  mutexattr;
+   pthread_mutex_t      *mtx;
+
+   mtx = malloc(sizeof(*mtx));
+   if (mtx)
+   {
+      pthread_mutexattr_init(&mutexattr);
+      pthread_mutexattr_setprotocol(&mutexattr, PTHREAD_PRIO_INHERIT);
+      pthread_mutex_init(mtx, &mutexattr);
+      pthread_mutexattr_destroy(&mutexattr);
+   }
+   return (osal_mutex_t *)mtx;
+}
+
+void osal_mtx_lock(osal_mutex_t * mtx)
+{
+   pthread_mutex_lock((pthread_mutex_t *)mtx);
+}
+
+void osal_mtx_unlock(osal_mutex_t * mtx)
+{
+   pthread_mutex_unlock((pthread_mutex_t *)mtx);
+}
+
+void osal_mtx_destroy(osal_mutex_t * mtx)
+{
+   pthread_mutex_destroy((pthread_mutex_t *)mtx);
+   free(mtx);
+}
+
+osal_sem_t * osal_sem_create(int count)
+{
+   sem_t *sem;
+
+   sem = malloc(sizeof(*sem));
+   if (sem && sem_init(sem, 0, (unsigned int)count))
+   {
+      free(sem);
+      sem = NULL;
+   }
+   return (osal_sem_t *)sem;
+}
+
+void osal_sem_post(osal_sem_t * sem)
+{
+   sem_post((sem_t *)sem);
+}
+
+void osal_sem_wait(osal_sem_t * sem)
+{
+   while (sem_wait((sem_t *)sem) && (errno == EINTR));
+}
+
+/* sem_timedwait() only takes a CLOCK_REALTIME deadline, wait in slices of at
+ * most this many ns so a time step can not stretch a wait by more */
+#define OSAL_SEMSLICE_NS  10000000LL
+
+static void osal_timespec_add_ns(struct timespec *ts, int64 ns)
+{
+   ts->tv_sec += (time_t)(ns / NSECS_PER_SEC);
+   ts->tv_nsec += (long)(ns % NSECS_PER_SEC);
+   if (ts->tv_nsec >= NSECS_PER_SEC)
+   {
+      ts->tv_sec++;
+      ts->tv_nsec -= NSECS_PER_SEC;
+   }
+}
+
+boolean osal_sem_timedwait(osal_sem_t * sem, uint32 timeout_usec)
+{
+   struct timespec ts;
+   osal_timert timer;
+   int64 left;
+
+   /* the deadline is kept on the monotonic clock of osal_current_time_ns() */
+   osal_timer_start(&timer, timeout_usec);
+   for (;;)
+   {
+      left = osal_timer_left_ns(&timer, osal_current_time_ns());
+      if (left <= 0)
+      {
+         return (sem_trywait((sem_t *)sem) == 0);
+      }
+      if (left > OSAL_SEMSLICE_NS)
+      {
+         left = OSAL_SEMSLICE_NS;
+      }
+      clock_gettime(CLOCK_REALTIME, &ts);
+      osal_timespec_add_ns(&ts, left);
+      if (!sem_timedwait((sem_t *)sem, &ts))
+      {
+         return TRUE;
+      }
+      if ((errno != ETIMEDOUT) && (errno != EINTR))
+      {
+         return FALSE;
+      }
+   }
+}
+
+void osal_sem_destroy(osal_sem_t * sem)
+{
+   sem_destroy((sem_t *)sem);
+   free(sem);
+}
@@ -34,6 +34,7 @@
   } while (0)
 
 #define USECS_PER_SEC   1000000
+#define NSECS_PER_SEC   1000000000LL
 #define USECS_PER_TICK  (USECS_PER_SEC / CFG_TICKS_PER_SECOND)
 
 
@@ -85,33 +86,40 @@ ec_timet osal_current_time (void)
    return return_value;
 }
 
-void osal_timer_start (osal_timert * self, uint32 timeout_usec)
+int64 osal_current_time_ns(void)
 {
-   struct timeval start_time;
-   struct timeval timeout;
-   struct timeval stop_time;
+   struct timeval current_time;
 
-   gettimeofday (&start_time, 0);
-   timeout.tv_sec = timeout_usec / USECS_PER_SEC;
-   timeout.tv_usec = timeout_usec % USECS_PER_SEC;
-   timeradd (&start_time, &timeout, &stop_time);
+   osal_gettimeofday(&current_time, 0);
+   return ((int64)current_time.tv_sec * NSECS_PER_SEC) + ((int64)current_time.tv_usec * 1000);
+}
 
-   self->stop_time.sec = stop_time.tv_sec;
-   self->stop_time.usec = stop_time.tv_usec;
+int osal_sleep_until_ns(int64 wakeup_ns)
+{
+   int64 delta;
+
+   /* no absolute sleep available, sleep for the remaining time */
+   delta = wakeup_ns - osal_current_time_ns();
+   if (delta <= 0)
+   {
+      return 0;
+   }
+   return osal_usleep((uint32)(delta / 1000));
 }
 
-boolean osal_timer_is_expired (osal_timert * self)
+void osal_timer_start(osal_timert * self, uint32 timeout_usec)
 {
-   struct timeval current_time;
-   struct timeval stop_time;
-   int is_not_yet_expired;
+   osal_timer_start_ns(self, (int64)timeout_usec * 1000);
+}
 
-   gettimeofday (&current_time, 0);
-   stop_time.tv_sec = self->stop_time.sec;
-   stop_time.tv_usec = self->stop_time.usec;
-   is_not_yet_expired = timercmp (&current_time, &stop_time, <);
+void osal_timer_start_ns(osal_timert * self, int64 timeout_ns)
+{
+   self->stop_time = osal_current_time_ns() + timeout_ns;
+}
 
-   return is_not_yet_expired == false;
+boolean osal_timer_is_expired(osal_timert * self)
+{
+   return osal_timer_is_expired_at(self, osal_current_time_ns());
 }
 
 void *osal_malloc(size_t size)
@@ -143,3 +151,48 @@ int osal_thread_create_rt(void *thandle, int stacksize, void *func, void *param)
    }
    return 1;
 }
+
+osal_mutex_t * osal_mtx_create(void)
+{
+   return (osal_mutex_t *)mtx_create();
+}
+
+void osal_mtx_lock(osal_mutex_t * mtx)
+{
+   mtx_lock((mtx_t *)mtx);
+}
+
+void osal_mtx_unlock(osal_mutex_t * mtx)
+{
+   mtx_unlock((mtx_t *)mtx);
+}
+
+void osal_mtx_destroy(osal_mutex_t * mtx)
+{
+   mtx_destroy((mtx_t *)mtx);
+}
+
+osal_sem_t * osal_sem_create(int count)
+{
+   return (osal_sem_t *)sem_create(count);
+}
+
+void osal_sem_post(osal_sem_t * sem)
+{
+   sem_signal((sem_t *)sem);
+}
+
+void osal_sem_wait(osal_sem_t * sem)
+{
+   sem_wait((sem_t *)sem);
+}
+
+boolean osal_sem_timedwait(osal_sem_t * sem, uint32 timeout_usec)
+{
+   return (sem_wait_tmo((sem_t *)sem, tick_from_ms((timeout_usec + 999) / 1000)) == 0);
+}
+
+void osal_sem_destroy(osal_sem_t * sem)
+{
+   sem_destroy((sem_t *)sem);
+}
@@ -12,6 +12,8 @@
 #include <osal.h>
 #include <vxWorks.h>
 #include <taskLib.h>
+#include <semLib.h>
+#include <sysLib.h>
 
 
 #define  timercmp(a, b, CMP)                                \
@@ -39,6 +41,7 @@
   } while (0)
 
 #define USECS_PER_SEC     1000000
+#define NSECS_PER_SEC     1000000000LL
 
 /* OBS! config worker threads must have higher prio that task running ec_configuration */
 #define ECAT_TASK_PRIO_HIGH      20     /* Priority for high performance network task */
@@ -94,6 +97,27 @@ ec_timet osal_current_time(void)
    return return_value;
 }
 
+int64 osal_current_time_ns(void)
+{
+   struct timeval current_time;
+
+   osal_gettimeofday(&current_time, 0);
+   return ((int64)current_time.tv_sec * NSECS_PER_SEC) + ((int64)current_time.tv_usec * 1000);
+}
+
+int osal_sleep_until_ns(int64 wakeup_ns)
+{
+   int64 delta;
+
+   /* no absolute sleep available, sleep for the remaining time */
+   delta = wakeup_ns - osal_current_time_ns();
+   if (delta <= 0)
+   {
+      return 0;
+   }
+   return osal_usleep((uint32)(delta / 1000));
+}
+
 void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
 {
    if (end->usec < start->usec) {
@@ -108,31 +132,17 @@ void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
 
 void osal_timer_start(osal_timert * self, uint32 timeout_usec)
 {
-   struct timeval start_time;
-   struct timeval timeout;
-   struct timeval stop_time;
-
-   osal_gettimeofday(&start_time, 0);
-   timeout.tv_sec = timeout_usec / USECS_PER_SEC;
-   timeout.tv_usec = timeout_usec % USECS_PER_SEC;
-   timeradd(&start_time, &timeout, &stop_time);
-
-   self->stop_time.sec = stop_time.tv_sec;
-   self->stop_time.usec = stop_time.tv_usec;
+   osal_timer_start_ns(self, (int64)timeout_usec * 1000);
 }
 
-boolean osal_timer_is_expired (osal_timert * self)
+void osal_timer_start_ns(osal_timert * self, int64 timeout_ns)
 {
-   struct timeval current_time;
-   struct timeval stop_time;
-   int is_not_yet_expired;
-
-   osal_gettimeofday(&current_time, 0);
-   stop_time.tv_sec = self->stop_time.sec;
-   stop_time.tv_usec = self->stop_time.usec;
-   is_not_yet_expired = timercmp(&current_time, &stop_time, <);
+   self->stop_time = osal_current_time_ns() + timeout_ns;
+}
 
-   return is_not_yet_expired == FALSE;
+boolean osal_timer_is_expired(osal_timert * self)
+{
+   return osal_timer_is_expired_at(self, osal_current_time_ns());
 }
 
 void *osal_malloc(size_t size)
@@ -185,3 +195,50 @@ int osal_thread_create_rt(void *thandle, int stacksize, void *func, void *param)
    return 1;
 }
 
+osal_mutex_t * osal_mtx_create(void)
+{
+   return (osal_mutex_t *)semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE);
+}
+
+void osal_mtx_lock(osal_mutex_t * mtx)
+{
+   semTake((SEM_ID)mtx, WAIT_FOREVER);
+}
+
+void osal_mtx_unlock(osal_mutex_t * mtx)
+{
+   semGive((SEM_ID)mtx);
+}
+
+void osal_mtx_destroy(osal_mutex_t * mtx)
+{
+   semDelete((SEM_ID)mtx);
+}
+
+osal_sem_t * osal_sem_create(int count)
+{
+   return (osal_sem_t *)semCCreate(SEM_Q_PRIORITY, count);
+}
+
+void osal_sem_post(osal_sem_t * sem)
+{
+   semGive((SEM_ID)sem);
+}
+
+void osal_sem_wait(osal_sem_t * sem)
+{
+   semTake((SEM_ID)sem, WAIT_FOREVER);
+}
+
+boolean osal_sem_timedwait(osal_sem_t * sem, uint32 timeout_usec)
+{
+   int ticks;
+
+   ticks = (int)(((uint64)timeout_usec * sysClkRateGet() + USECS_PER_SEC - 1) / USECS_PER_SEC);
+   return (semTake((SEM_ID)sem, ticks) == OK);
+}
+
+void osal_sem_destroy(osal_sem_t * sem)
+{
+   semDelete((SEM_ID)sem);
+}
@@ -11,6 +11,7 @@ static int64_t sysfrequency;
 static double qpc2usec;
 
 #define USECS_PER_SEC     1000000
+#define NSECS_PER_SEC     1000000000LL
 
 int osal_getrelativetime(struct timeval *tv, struct timezone *tz)
 {
@@ -67,6 +68,27 @@ ec_timet osal_current_time (void)
    return return_value;
 }
 
+int64 osal_current_time_ns(void)
+{
+   struct timeval current_time;
+
+   osal_getrelativetime(&current_time, 0);
+   return ((int64)current_time.tv_sec * NSECS_PER_SEC) + ((int64)current_time.tv_usec * 1000);
+}
+
+int osal_sleep_until_ns(int64 wakeup_ns)
+{
+   int64 delta;
+
+   /* no absolute sleep available, sleep for the remaining time */
+   delta = wakeup_ns - osal_current_time_ns();
+   if (delta <= 0)
+   {
+      return 0;
+   }
+   return osal_usleep((uint32)(delta / 1000));
+}
+
 void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
 {
    if (end->usec < start->usec) {
@@ -79,33 +101,19 @@ void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
    }
 }
 
-void osal_timer_start (osal_timert *self, uint32 timeout_usec)
+void osal_timer_start(osal_timert * self, uint32 timeout_usec)
 {
-   struct timeval start_time;
-   struct timeval timeout;
-   struct timeval stop_time;
-
-   osal_getrelativetime (&start_time, 0);
-   timeout.tv_sec = timeout_usec / USECS_PER_SEC;
-   timeout.tv_usec = timeout_usec % USECS_PER_SEC;
-   timeradd (&start_time, &timeout, &stop_time);
-
-   self->stop_time.sec = stop_time.tv_sec;
-   self->stop_time.usec = stop_time.tv_usec;
+   osal_timer_start_ns(self, (int64)timeout_usec * 1000);
 }
 
-boolean osal_timer_is_expired (osal_timert *self)
+void osal_timer_start_ns(osal_timert * self, int64 timeout_ns)
 {
-   struct timeval current_time;
-   struct timeval stop_time;
-   int is_not_yet_expired;
-
-   osal_getrelativetime (&current_time, 0);
-   stop_time.tv_sec = self->stop_time.sec;
-   stop_time.tv_usec = self->stop_time.usec;
-   is_not_yet_expired = timercmp (&current_time, &stop_time, <);
+   self->stop_time = osal_current_time_ns() + timeout_ns;
+}
 
-   return is_not_yet_expired == FALSE;
+boolean osal_timer_is_expired(osal_timert * self)
+{
+   return osal_timer_is_expired_at(self, osal_current_time_ns());
 }
 
 int osal_usleep(uint32 usec)
@@ -150,3 +158,56 @@ int osal_thread_create_rt(void **thandle, int stacksize, void *func, void *param
    }
    return ret;
 }
+
+osal_mutex_t * osal_mtx_create(void)
+{
+   CRITICAL_SECTION *mtx;
+
+   mtx = malloc(sizeof(*mtx));
+   if (mtx)
+   {
+      InitializeCriticalSection(mtx);
+   }
+   return (osal_mutex_t *)mtx;
+}
+
+void osal_mtx_lock(osal_mutex_t * mtx)
+{
+   EnterCriticalSection((CRITICAL_SECTION *)mtx);
+}
+
+void osal_mtx_unlock(osal_mutex_t * mtx)
+{
+   LeaveCriticalSection((CRITICAL_SECTION *)mtx);
+}
+
+void osal_mtx_destroy(osal_mutex_t * mtx)
+{
+   DeleteCriticalSection((CRITICAL_SECTION *)mtx);
+   free(mtx);
+}
+
+osal_sem_t * osal_sem_create(int count)
+{
+   return (osal_sem_t *)CreateSemaphore(NULL, count, 0x7fffffff, NULL);
+}
+
+void osal_sem_post(osal_sem_t * sem)
+{
+   ReleaseSemaphore((HANDLE)sem, 1, NULL);
+}
+
+void osal_sem_wait(osal_sem_t * sem)
+{
+   WaitForSingleObject((HANDLE)sem, INFINITE);
+}
+
+boolean osal_sem_timedwait(osal_sem_t * sem, uint32 timeout_usec)
+{
+   return (WaitForSingleObject((HANDLE)sem, (timeout_usec + 999) / 1000) == WAIT_OBJECT_0);
+}
+
+void osal_sem_destroy(osal_sem_t * sem)
+{
+   CloseHandle((HANDLE)sem);
+}
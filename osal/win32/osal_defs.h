@@ -30,6 +30,9 @@ extern "C"
 #define OSAL_THREAD_FUNC void
 #define OSAL_THREAD_FUNC_RT void
 
+#define OSAL_INLINE static __inline
+#define OSAL_MEMBAR() MemoryBarrier()
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,8 +28,48 @@
  * packets. The software layer will detect the possible failure modes and
  * compensate. If needed the packets from interface A are resent through interface B.
  * This layer if fully transparent for the higher layers.
+ *
+ * Optionally (ecx_portt.nicmode = ECT_NIC_RING) the socket is set up with
+ * PACKET_MMAP TX and RX rings. Received frames are then picked up from shared
+ * memory without a recv() syscall and copied once into the indexed rx buffer.
+ * Transmit frames are placed in the TX ring and the kernel is kicked with a
+ * zero length send(). When the kernel does not support the rings the driver
+ * falls back to the plain socket mode.
+ *
+ * With ecx_portt.nicmode = ECT_NIC_XDP frames are exchanged through an
+ * AF_XDP socket instead, see nicdrv_xdp.c. The packet socket is then only
+ * used to configure the NIC.
+ *
+ * How the receive functions wait for a frame is selected per port with
+ * ecx_setwaitmode(). The legacy mode spins on recv() with a 1us receive
+ * timeout. The other modes use non blocking reads combined with kernel busy
+ * polling, ppoll() with the frame deadline, or a short spin followed by
+ * ppoll(). The time spent waiting is collected in ecx_portt.waitstat.
+ *
+ * With ecx_portt.tsmode set, SO_TIMESTAMPING is enabled on the sockets and
+ * every frame gets a transmit and receive timestamp, taken by the NIC if it
+ * supports hardware timestamping and by the kernel otherwise. Transmit
+ * timestamps are read from the socket error queue. Timestamps are not
+ * available in AF_XDP mode.
+ *
+ * Process data frames can be given a zero copy receive target with
+ * ecx_setrxdirect(). The data of the first datagram then goes straight into
+ * the IOmap instead of through the rx buffer. In socket mode the batched
+ * recvmmsg() scatters each frame with an iovec laid out for the frame expected
+ * in that position, so the kernel writes the process data in place. In ring
+ * and AF_XDP mode the data is copied once from shared memory into the IOmap.
+ * A frame that lands in the layout of another index is reassembled and the
+ * overwritten IOmap part is restored from the transmit buffer, which holds the
+ * same bytes as sent.
+ *
+ * In the same way ecx_settxdirect() lets the outputs of a frame be sent
+ * straight from the IOmap. The frame is then gathered from the header in the
+ * transmit buffer, the IOmap and the rest of the transmit buffer, by sendmsg()
+ * in socket mode or while placing it in the TX ring or AF_XDP UMEM.
  */
 
+#define _GNU_SOURCE
+
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <net/if.h>
@@ -41,8 +81,13 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <string.h>
-#include <netpacket/packet.h>
+#include <linux/if_packet.h>
+#include <sys/mman.h>
+#include <poll.h>
 #include <pthread.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include <linux/sockios.h>
 
 #include "oshw.h"
 #include "osal.h"
@@ -72,6 +117,21 @@ const uint16 secMAC[3] = { 0x0404, 0x0404, 0x0404 };
 /** second MAC word is used for identification */
 #define RX_SEC secMAC[1]
 
+/** size of one PACKET_MMAP frame slot, holds tpacket header and max frame */
+#define EC_RINGFRAMESIZE  2048
+/** minimum number of RX ring frame slots */
+#define EC_RINGRXFRAMES   (EC_MAXBUF * 4)
+/** minimum number of TX ring frame slots */
+#define EC_RINGTXFRAMES   (EC_MAXBUF * 2)
+/** offset of frame data in TX ring slot */
+#define EC_RINGTXDATA     (TPACKET2_HDRLEN - sizeof(struct sockaddr_ll))
+/** timestamp flags in TX ring slot status */
+#define EC_RINGTSFLAGS    (TP_STATUS_TS_SOFTWARE | TP_STATUS_TS_SYS_HARDWARE | TP_STATUS_TS_RAW_HARDWARE)
+/** default SO_BUSY_POLL budget in us for ECT_WAIT_BUSYPOLL */
+#define EC_BUSYPOLLTIME   50
+/** size of control buffer for SCM_TIMESTAMPING */
+#define EC_TSCTRLSIZE     CMSG_SPACE(sizeof(struct scm_timestamping))
+
 static void ecx_clear_rxbufstat(int *rxbufstat)
 {
    int i;
@@ -81,6 +141,340 @@ static void ecx_clear_rxbufstat(int *rxbufstat)
    }
 }
 
+/** Unmap PACKET_MMAP rings.
+ * @param[in] ring        = ring state
+ */
+static void ecx_ring_release(ec_ringT *ring)
+{
+   if (ring->map)
+   {
+      munmap(ring->map, ring->mapsize);
+   }
+   memset(ring, 0, sizeof(*ring));
+   ring->rxheld = -1;
+}
+
+/** Setup TPACKET_V2 TX and RX rings on socket and map them in memory.
+ * TPACKET_V2 is used rather than V3 because V3 only hands over RX blocks on
+ * block full or block retire timeout, which adds up to a ms of latency.
+ * Must be called before the socket is bound.
+ * @param[in] ring        = ring state
+ * @param[in] sock        = packet socket
+ * @return >0 if succeeded
+ */
+static int ecx_ring_setup(ec_ringT *ring, int sock)
+{
+   struct tpacket_req req;
+   int val, blocksize, perblock;
+   size_t rxsize;
+
+   ecx_ring_release(ring);
+   val = TPACKET_V2;
+   if (setsockopt(sock, SOL_PACKET, PACKET_VERSION, &val, sizeof(val)) < 0)
+   {
+      return 0;
+   }
+   /* drop malformed TX frames instead of stalling the ring */
+   val = 1;
+   setsockopt(sock, SOL_PACKET, PACKET_LOSS, &val, sizeof(val));
+   blocksize = sysconf(_SC_PAGESIZE);
+   if (blocksize < EC_RINGFRAMESIZE)
+   {
+      blocksize = EC_RINGFRAMESIZE;
+   }
+   perblock = blocksize / EC_RINGFRAMESIZE;
+   req.tp_block_size = blocksize;
+   req.tp_frame_size = EC_RINGFRAMESIZE;
+   req.tp_block_nr = (EC_RINGRXFRAMES + perblock - 1) / perblock;
+   req.tp_frame_nr = req.tp_block_nr * perblock;
+   ring->rxframes = req.tp_frame_nr;
+   rxsize = (size_t)req.tp_block_nr * blocksize;
+   if (setsockopt(sock, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)
+   {
+      return 0;
+   }
+   req.tp_block_nr = (EC_RINGTXFRAMES + perblock - 1) / perblock;
+   req.tp_frame_nr = req.tp_block_nr * perblock;
+   ring->txframes = req.tp_frame_nr;
+   if (setsockopt(sock, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req)) < 0)
+   {
+      return 0;
+   }
+   ring->mapsize = rxsize + (size_t)req.tp_block_nr * blocksize;
+   ring->map = mmap(NULL, ring->mapsize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_LOCKED, sock, 0);
+   if (ring->map == MAP_FAILED)
+   {
+      /* locked memory may be limited, try again unlocked */
+      ring->map = mmap(NULL, ring->mapsize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, sock, 0);
+   }
+   if (ring->map == MAP_FAILED)
+   {
+      ring->map = NULL;
+      return 0;
+   }
+   ring->rx = ring->map;
+   ring->tx = ring->map + rxsize;
+   ring->framesize = EC_RINGFRAMESIZE;
+#ifdef PACKET_QDISC_BYPASS
+   /* frames go straight to the driver, failure is not fatal */
+   val = 1;
+   setsockopt(sock, SOL_PACKET, PACKET_QDISC_BYPASS, &val, sizeof(val));
+#endif
+
+   return 1;
+}
+
+/** Send frame over socket, or place it in the TX ring or AF_XDP socket.
+ * Caller must hold tx_mutex when the ring or AF_XDP socket is used.
+ * @param[in] stack       = stack to send on
+ * @param[in] iov         = parts of frame incl. ethernet header
+ * @param[in] iovcnt      = number of parts
+ * @param[in] kick        = kick kernel to transmit ring frames, if 0 the frame
+ *                          stays in the ring until ecx_kickpkt()
+ * @return number of bytes sent or -1
+ */
+static int ecx_sendpkt(ec_stackT *stack, const struct iovec *iov, int iovcnt, int kick)
+{
+   ec_ringT *ring;
+   struct tpacket2_hdr *hdr;
+   struct msghdr msg;
+   uint8 *dst;
+   int i, len;
+
+   if (stack->xdp->umem)
+   {
+      return ecx_xdp_send(stack->xdp, iov, iovcnt, kick);
+   }
+   ring = stack->ring;
+   if (!ring->map)
+   {
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = (struct iovec *)iov;
+      msg.msg_iovlen = iovcnt;
+      return sendmsg(*stack->sock, &msg, 0);
+   }
+   hdr = (struct tpacket2_hdr *)(ring->tx + ring->txpos * ring->framesize);
+   __sync_synchronize();
+   if (hdr->tp_status == TP_STATUS_WRONG_FORMAT)
+   {
+      hdr->tp_status = TP_STATUS_AVAILABLE;
+   }
+   /* sent slots may carry timestamp flags */
+   if ((hdr->tp_status & ~EC_RINGTSFLAGS) != TP_STATUS_AVAILABLE)
+   {
+      /* ring full, kick kernel to drain it and report failure */
+      send(*stack->sock, NULL, 0, MSG_DONTWAIT);
+      return -1;
+   }
+   dst = (uint8 *)hdr + EC_RINGTXDATA;
+   len = 0;
+   for (i = 0; i < iovcnt; i++)
+   {
+      memcpy(dst + len, iov[i].iov_base, iov[i].iov_len);
+      len += iov[i].iov_len;
+   }
+   hdr->tp_len = len;
+   __sync_synchronize();
+   hdr->tp_status = TP_STATUS_SEND_REQUEST;
+   ring->txpos++;
+   if (ring->txpos >= ring->txframes)
+   {
+      ring->txpos = 0;
+   }
+   if (kick && (send(*stack->sock, NULL, 0, MSG_DONTWAIT) < 0))
+   {
+      return -1;
+   }
+
+   return len;
+}
+
+/** Kick kernel to transmit frames left in the TX ring or AF_XDP socket.
+ * @param[in] stack       = stack to kick
+ */
+static void ecx_kickpkt(ec_stackT *stack)
+{
+   if (stack->xdp->umem)
+   {
+      ecx_xdp_kick(stack->xdp);
+   }
+   else if (stack->ring->map)
+   {
+      send(*stack->sock, NULL, 0, MSG_DONTWAIT);
+   }
+}
+
+/** Set up iovec to send the frame of an index. With a zero copy source set
+ * for the index the outputs are taken from the source, the headers and the
+ * rest of the frame from the transmit buffer.
+ * @param[in] port        = port context struct
+ * @param[in] stack       = stack to send on
+ * @param[in] idx         = index in tx buffer array
+ * @param[out] iov        = iovec of 3 elements
+ * @return number of iovec elements used
+ */
+static int ecx_txiov(ecx_portt *port, ec_stackT *stack, int idx, struct iovec *iov)
+{
+   uint8 *txbuf;
+   int len, dlen;
+
+   txbuf = (*stack->txbuf)[idx];
+   len = (*stack->txbuflength)[idx];
+   if (!port->txdirect[idx] || (stack != &(port->stack)))
+   {
+      iov[0].iov_base = txbuf;
+      iov[0].iov_len = len;
+      return 1;
+   }
+   dlen = port->txdirectlen[idx];
+   iov[0].iov_base = txbuf;
+   iov[0].iov_len = ETH_HEADERSIZE + EC_HEADERSIZE;
+   iov[1].iov_base = port->txdirect[idx];
+   iov[1].iov_len = dlen;
+   iov[2].iov_base = txbuf + ETH_HEADERSIZE + EC_HEADERSIZE + dlen;
+   iov[2].iov_len = len - (ETH_HEADERSIZE + EC_HEADERSIZE + dlen);
+
+   return 3;
+}
+
+/** Set SO_BUSY_POLL on socket according to port wait mode.
+ * @param[in] sock        = socket
+ * @param[in] port        = port context struct
+ */
+static void ecx_setbusypoll(int sock, ecx_portt *port)
+{
+   int val;
+
+   val = 0;
+   if (port->waitmode == ECT_WAIT_BUSYPOLL)
+   {
+      val = (port->waittime > 0) ? port->waittime : EC_BUSYPOLLTIME;
+   }
+   /* raising the budget above net.core.busy_read needs CAP_NET_ADMIN */
+   setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &val, sizeof(val));
+#ifdef SO_PREFER_BUSY_POLL
+   val = (val > 0);
+   setsockopt(sock, SOL_SOCKET, SO_PREFER_BUSY_POLL, &val, sizeof(val));
+#endif
+}
+
+/** Enable SO_TIMESTAMPING on socket. Hardware timestamping is switched on
+ * in the NIC if requested and supported, else software timestamps are used.
+ * Transmit timestamps are only enabled on the primary socket.
+ * @param[in] port        = port context struct
+ * @param[in] stack       = stack of socket
+ * @param[in] ifname      = Name of NIC device
+ * @param[in] secondary   = if >0 then secondary socket
+ * @return active timestamping mode
+ */
+static int ecx_setuptimestamp(ecx_portt *port, ec_stackT *stack, const char *ifname, int secondary)
+{
+   struct ifreq ifr;
+   struct hwtstamp_config cfg;
+   int flags, active;
+
+   active = ECT_TS_SOFTWARE;
+   flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+   if (!secondary)
+   {
+      flags |= SOF_TIMESTAMPING_TX_SOFTWARE;
+   }
+   if (port->tsmode == ECT_TS_HARDWARE)
+   {
+      memset(&cfg, 0, sizeof(cfg));
+      cfg.tx_type = HWTSTAMP_TX_ON;
+      cfg.rx_filter = HWTSTAMP_FILTER_ALL;
+      memset(&ifr, 0, sizeof(ifr));
+      strncpy(ifr.ifr_name, ifname, sizeof(ifr.ifr_name) - 1);
+      ifr.ifr_data = (void *)&cfg;
+      if ((ioctl(*stack->sock, SIOCSHWTSTAMP, &ifr) == 0) && (cfg.rx_filter != HWTSTAMP_FILTER_NONE))
+      {
+         active = ECT_TS_HARDWARE;
+         flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+         if (!secondary)
+         {
+            flags |= SOF_TIMESTAMPING_TX_HARDWARE;
+         }
+      }
+   }
+   if (setsockopt(*stack->sock, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0)
+   {
+      return ECT_TS_NONE;
+   }
+   if (stack->ring->map)
+   {
+      /* select timestamp source written to RX ring slots */
+      flags = (active == ECT_TS_HARDWARE) ? SOF_TIMESTAMPING_RAW_HARDWARE : SOF_TIMESTAMPING_SOFTWARE;
+      setsockopt(*stack->sock, SOL_PACKET, PACKET_TIMESTAMP, &flags, sizeof(flags));
+   }
+
+   return active;
+}
+
+/** Get timestamp from SCM_TIMESTAMPING control message.
+ * @param[in] msg         = received message
+ * @return timestamp in ns, hardware if available else software, 0 if none
+ */
+static int64 ecx_cmsgtime(struct msghdr *msg)
+{
+   struct cmsghdr *cmsg;
+   struct scm_timestamping *sts;
+   struct timespec *ts;
+
+   for (cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg))
+   {
+      if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_TIMESTAMPING))
+      {
+         sts = (struct scm_timestamping *)CMSG_DATA(cmsg);
+         ts = &(sts->ts[2]);
+         if (!ts->tv_sec && !ts->tv_nsec)
+         {
+            ts = &(sts->ts[0]);
+         }
+         return (int64)ts->tv_sec * 1000000000 + ts->tv_nsec;
+      }
+   }
+
+   return 0;
+}
+
+/** Read transmit timestamps from primary socket error queue and store them
+ * with the index of the looped back frame.
+ * @param[in] port        = port context struct
+ */
+static void ecx_readtxtime(ecx_portt *port)
+{
+   struct msghdr msg;
+   struct iovec iov;
+   uint8 frame[ETH_HEADERSIZE + sizeof(ec_comt)];
+   uint8 ctrl[EC_TSCTRLSIZE + 64];
+   ec_comt *ecp;
+   int cnt;
+
+   for (cnt = 0; cnt < (EC_MAXBUF * 2); cnt++)
+   {
+      memset(&msg, 0, sizeof(msg));
+      iov.iov_base = frame;
+      iov.iov_len = sizeof(frame);
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = ctrl;
+      msg.msg_controllen = sizeof(ctrl);
+      /* looped back frame is truncated, only the datagram index is needed */
+      if (recvmsg(port->sockhandle, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < (int)sizeof(frame))
+      {
+         break;
+      }
+      ecp = (ec_comt *)&frame[ETH_HEADERSIZE];
+      if (ecp->index < EC_MAXBUF)
+      {
+         port->txtime[ecp->index] = ecx_cmsgtime(&msg);
+      }
+   }
+}
+
 /** Basic setup to connect NIC to socket.
  * @param[in] port        = port context struct
  * @param[in] ifname      = Name of NIC device, f.e. "eth0"
@@ -95,6 +489,9 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
    struct ifreq ifr;
    struct sockaddr_ll sll;
    int *psock;
+   ec_ringT *ring;
+   ec_xdpT *xdp;
+   ec_stackT *stack;
    pthread_mutexattr_t mutexattr;
 
    rval = 0;
@@ -114,6 +511,11 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
          port->redport->stack.rxbuf       = &(port->redport->rxbuf);
          port->redport->stack.rxbufstat   = &(port->redport->rxbufstat);
          port->redport->stack.rxsa        = &(port->redport->rxsa);
+         port->redport->stack.ring        = &(port->redport->ring);
+         port->redport->stack.xdp         = &(port->redport->xdp);
+         port->redport->stack.tsactive    = &(port->redport->tsactive);
+         port->redport->stack.rxtime      = &(port->redport->rxtime);
+         port->redport->tsactive          = ECT_TS_NONE;
          ecx_clear_rxbufstat(&(port->redport->rxbufstat[0]));
       }
       else
@@ -126,7 +528,6 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
    {
       pthread_mutexattr_init(&mutexattr);
       pthread_mutexattr_setprotocol(&mutexattr  , PTHREAD_PRIO_INHERIT);
-      pthread_mutex_init(&(port->getindex_mutex), &mutexattr);
       pthread_mutex_init(&(port->tx_mutex)      , &mutexattr);
       pthread_mutex_init(&(port->rx_mutex)      , &mutexattr);
       port->sockhandle        = -1;
@@ -139,11 +540,29 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
       port->stack.rxbuf       = &(port->rxbuf);
       port->stack.rxbufstat   = &(port->rxbufstat);
       port->stack.rxsa        = &(port->rxsa);
+      port->stack.ring        = &(port->ring);
+      port->stack.xdp         = &(port->xdp);
+      port->stack.tsactive    = &(port->tsactive);
+      port->stack.rxtime      = &(port->rxtime);
+      port->tsactive          = ECT_TS_NONE;
+      port->cyclertt          = -1;
       ecx_clear_rxbufstat(&(port->rxbufstat[0]));
       psock = &(port->sockhandle);
    }
+   ring = secondary ? &(port->redport->ring) : &(port->ring);
+   xdp = secondary ? &(port->redport->xdp) : &(port->xdp);
+   memset(xdp, 0, sizeof(*xdp));
+   memset(ring, 0, sizeof(*ring));
+   ring->rxheld = -1;
    /* we use RAW packet socket, with packet type ETH_P_ECAT */
    *psock = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_ECAT));
+   if ((port->nicmode == ECT_NIC_RING) && !ecx_ring_setup(ring, *psock))
+   {
+      /* rings not available, start over with a plain socket */
+      ecx_ring_release(ring);
+      close(*psock);
+      *psock = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_ECAT));
+   }
 
    timeout.tv_sec =  0;
    timeout.tv_usec = 1;
@@ -151,6 +570,7 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
    r = setsockopt(*psock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
    i = 1;
    r = setsockopt(*psock, SOL_SOCKET, SO_DONTROUTE, &i, sizeof(i));
+   ecx_setbusypoll(*psock, port);
    /* connect socket to NIC by name */
    strcpy(ifr.ifr_name, ifname);
    r = ioctl(*psock, SIOCGIFINDEX, &ifr);
@@ -175,6 +595,17 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
    }
    ec_setupheader(&(port->txbuf2));
    if (r == 0) rval = 1;
+   /* AF_XDP socket takes over frame traffic, packet socket stays as fallback */
+   if (rval && (port->nicmode == ECT_NIC_XDP) && ecx_xdp_setup(xdp, ifindex, port->xdpqueue))
+   {
+      ecx_setbusypoll(xdp->fd, port);
+   }
+   /* no timestamps on AF_XDP socket */
+   if (rval && (port->tsmode != ECT_TS_NONE) && !xdp->umem)
+   {
+      stack = secondary ? &(port->redport->stack) : &(port->stack);
+      *stack->tsactive = ecx_setuptimestamp(port, stack, ifname, secondary);
+   }
 
    return rval;
 }
@@ -185,10 +616,19 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
  */
 int ecx_closenic(ecx_portt *port)
 {
+   ecx_ring_release(&(port->ring));
+   if (port->xdp.umem)
+      ecx_xdp_close(&(port->xdp));
    if (port->sockhandle >= 0)
       close(port->sockhandle);
-   if ((port->redport) && (port->redport->sockhandle >= 0))
-      close(port->redport->sockhandle);
+   if (port->redport)
+   {
+      ecx_ring_release(&(port->redport->ring));
+      if (port->redport->xdp.umem)
+         ecx_xdp_close(&(port->redport->xdp));
+      if (port->redport->sockhandle >= 0)
+         close(port->redport->sockhandle);
+   }
 
    return 0;
 }
@@ -219,32 +659,54 @@ int ecx_getindex(ecx_portt *port)
 {
    int idx;
    int cnt;
+   int expected;
+   int last;
 
-   pthread_mutex_lock( &(port->getindex_mutex) );
-
-   idx = port->lastidx + 1;
-   /* index can't be larger than buffer array */
-   if (idx >= EC_MAXBUF)
-   {
-      idx = 0;
-   }
-   cnt = 0;
-   /* try to find unused index */
-   while ((port->rxbufstat[idx] != EC_BUF_EMPTY) && (cnt < EC_MAXBUF))
+   last = __atomic_load_n(&(port->lastidx), __ATOMIC_RELAXED);
+   idx = last;
+   /* try to find unused index, claim it by moving it from empty to allocated
+      so concurrent callers never get the same index */
+   for (cnt = 0; cnt < EC_MAXBUF; cnt++)
    {
       idx++;
-      cnt++;
+      /* index can't be larger than buffer array */
       if (idx >= EC_MAXBUF)
       {
          idx = 0;
       }
+      expected = EC_BUF_EMPTY;
+      if (__atomic_compare_exchange_n(&(port->rxbufstat[idx]), &expected, EC_BUF_ALLOC,
+                                      FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      {
+         break;
+      }
+   }
+   /* all in use, reuse the oldest index after the last allocated one as
+      before, never the last one which is the most recent frame in flight.
+      The index is claimed by advancing lastidx, so concurrent callers falling
+      back at the same time each get another index */
+   if (cnt == EC_MAXBUF)
+   {
+      last = __atomic_load_n(&(port->lastidx), __ATOMIC_RELAXED);
+      do
+      {
+         idx = last + 1;
+         if (idx >= EC_MAXBUF)
+         {
+            idx = 0;
+         }
+      } while (!__atomic_compare_exchange_n(&(port->lastidx), &last, idx,
+                                            FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+      __atomic_store_n(&(port->rxbufstat[idx]), EC_BUF_ALLOC, __ATOMIC_RELAXED);
+   }
+   else
+   {
+      __atomic_store_n(&(port->lastidx), idx, __ATOMIC_RELAXED);
    }
-   port->rxbufstat[idx] = EC_BUF_ALLOC;
    if (port->redstate != ECT_RED_NONE)
       port->redport->rxbufstat[idx] = EC_BUF_ALLOC;
-   port->lastidx = idx;
-
-   pthread_mutex_unlock( &(port->getindex_mutex) );
+   port->txdirect[idx] = NULL;
+   port->rxdirect[idx] = NULL;
 
    return idx;
 }
@@ -256,9 +718,10 @@ int ecx_getindex(ecx_portt *port)
  */
 void ecx_setbufstat(ecx_portt *port, int idx, int bufstat)
 {
-   port->rxbufstat[idx] = bufstat;
    if (port->redstate != ECT_RED_NONE)
       port->redport->rxbufstat[idx] = bufstat;
+   /* release, freeing the index makes it available to ecx_getindex() */
+   __atomic_store_n(&(port->rxbufstat[idx]), bufstat, __ATOMIC_RELEASE);
 }
 
 /** Transmit buffer over socket (non blocking).
@@ -269,8 +732,9 @@ void ecx_setbufstat(ecx_portt *port, int idx, int bufstat)
  */
 int ecx_outframe(ecx_portt *port, int idx, int stacknumber)
 {
-   int lp, rval;
+   int iovcnt, rval;
    ec_stackT *stack;
+   struct iovec iov[3];
 
    if (!stacknumber)
    {
@@ -280,9 +744,24 @@ int ecx_outframe(ecx_portt *port, int idx, int stacknumber)
    {
       stack = &(port->redport->stack);
    }
-   lp = (*stack->txbuflength)[idx];
+   iovcnt = ecx_txiov(port, stack, idx, iov);
    (*stack->rxbufstat)[idx] = EC_BUF_TX;
-   rval = send(*stack->sock, (*stack->txbuf)[idx], lp, 0);
+   if (!stacknumber)
+   {
+      port->txtime[idx] = 0;
+      port->rxtime[idx] = 0;
+   }
+   if (stack->ring->map || stack->xdp->umem)
+   {
+      /* TX ring position is shared with the secondary transmit */
+      pthread_mutex_lock( &(port->tx_mutex) );
+      rval = ecx_sendpkt(stack, iov, iovcnt, 1);
+      pthread_mutex_unlock( &(port->tx_mutex) );
+   }
+   else
+   {
+      rval = ecx_sendpkt(stack, iov, iovcnt, 1);
+   }
    if (rval == -1)
    {
       (*stack->rxbufstat)[idx] = EC_BUF_EMPTY;
@@ -300,6 +779,7 @@ int ecx_outframe_red(ecx_portt *port, int idx)
 {
    ec_comt *datagramP;
    ec_etherheadert *ehp;
+   struct iovec iov;
    int rval;
 
    ehp = (ec_etherheadert *)&(port->txbuf[idx]);
@@ -319,7 +799,9 @@ int ecx_outframe_red(ecx_portt *port, int idx)
       ehp->sa1 = htons(secMAC[1]);
       /* transmit over secondary socket */
       port->redport->rxbufstat[idx] = EC_BUF_TX;
-      if (send(port->redport->sockhandle, &(port->txbuf2), port->txbuflength2 , 0) == -1)
+      iov.iov_base = &(port->txbuf2);
+      iov.iov_len = port->txbuflength2;
+      if (ecx_sendpkt(&(port->redport->stack), &iov, 1, 1) == -1)
       {
          port->redport->rxbufstat[idx] = EC_BUF_EMPTY;
       }
@@ -329,15 +811,23 @@ int ecx_outframe_red(ecx_portt *port, int idx)
    return rval;
 }
 
-/** Non blocking read of socket. Put frame in temporary buffer.
+/** Non blocking read of socket. Put frame in temporary buffer, or in ring
+ * and AF_XDP mode point to the frame in shared memory. A frame stays held until
+ * ecx_recvpkt_release() is called.
  * @param[in] port        = port context struct
  * @param[in] stacknumber = 0=primary 1=secondary stack
+ * @param[out] frame      = received frame incl. ethernet header
  * @return >0 if frame is available and read
  */
-static int ecx_recvpkt(ecx_portt *port, int stacknumber)
+static int ecx_recvpkt(ecx_portt *port, int stacknumber, uint8 **frame)
 {
    int lp, bytesrx;
    ec_stackT *stack;
+   ec_ringT *ring;
+   struct tpacket2_hdr *hdr;
+   struct msghdr msg;
+   struct iovec iov;
+   uint8 ctrl[EC_TSCTRLSIZE];
 
    if (!stacknumber)
    {
@@ -347,13 +837,332 @@ static int ecx_recvpkt(ecx_portt *port, int stacknumber)
    {
       stack = &(port->redport->stack);
    }
-   lp = sizeof(port->tempinbuf);
-   bytesrx = recv(*stack->sock, (*stack->tempbuf), lp, 0);
+   ring = stack->ring;
+   port->tempints = 0;
+   if (stack->xdp->umem)
+   {
+      bytesrx = ecx_xdp_recv(stack->xdp, frame);
+   }
+   else if (ring->map)
+   {
+      bytesrx = 0;
+      hdr = (struct tpacket2_hdr *)(ring->rx + ring->rxpos * ring->framesize);
+      if (hdr->tp_status & TP_STATUS_USER)
+      {
+         __sync_synchronize();
+         *frame = (uint8 *)hdr + hdr->tp_mac;
+         bytesrx = hdr->tp_snaplen;
+         if (*stack->tsactive)
+         {
+            port->tempints = (int64)hdr->tp_sec * 1000000000 + hdr->tp_nsec;
+         }
+         ring->rxheld = ring->rxpos;
+         ring->rxpos++;
+         if (ring->rxpos >= ring->rxframes)
+         {
+            ring->rxpos = 0;
+         }
+      }
+   }
+   else if (*stack->tsactive)
+   {
+      memset(&msg, 0, sizeof(msg));
+      iov.iov_base = *stack->tempbuf;
+      iov.iov_len = sizeof(port->tempinbuf);
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = ctrl;
+      msg.msg_controllen = sizeof(ctrl);
+      bytesrx = recvmsg(*stack->sock, &msg,
+                        (port->waitmode == ECT_WAIT_SPIN) ? 0 : MSG_DONTWAIT);
+      if (bytesrx > 0)
+      {
+         port->tempints = ecx_cmsgtime(&msg);
+      }
+      *frame = *stack->tempbuf;
+   }
+   else
+   {
+      lp = sizeof(port->tempinbuf);
+      bytesrx = recv(*stack->sock, (*stack->tempbuf), lp,
+                     (port->waitmode == ECT_WAIT_SPIN) ? 0 : MSG_DONTWAIT);
+      *frame = *stack->tempbuf;
+   }
    port->tempinbufs = bytesrx;
 
    return (bytesrx > 0);
 }
 
+/** Hand RX ring slot or AF_XDP frame of last received frame back to the kernel.
+ * @param[in] port        = port context struct
+ * @param[in] stacknumber = 0=primary 1=secondary stack
+ */
+static void ecx_recvpkt_release(ecx_portt *port, int stacknumber)
+{
+   ec_ringT *ring;
+   ec_xdpT *xdp;
+   struct tpacket2_hdr *hdr;
+
+   xdp = stacknumber ? &(port->redport->xdp) : &(port->xdp);
+   if (xdp->umem)
+   {
+      ecx_xdp_release(xdp);
+      return;
+   }
+   ring = stacknumber ? &(port->redport->ring) : &(port->ring);
+   if (ring->map && (ring->rxheld >= 0))
+   {
+      hdr = (struct tpacket2_hdr *)(ring->rx + ring->rxheld * ring->framesize);
+      __sync_synchronize();
+      hdr->tp_status = TP_STATUS_KERNEL;
+      ring->rxheld = -1;
+   }
+}
+
+/** Copy received frame to the rx buffer of its index, without ethernet
+ * header. With a zero copy target set for the index its part of the data of
+ * the first datagram is copied to the target instead.
+ * @param[in] port        = port context struct
+ * @param[in] stack       = stack the frame was received on
+ * @param[in] idx         = index of frame
+ * @param[in] frame       = received frame incl. ethernet header
+ */
+static void ecx_copyframe(ecx_portt *port, ec_stackT *stack, int idx, const uint8 *frame)
+{
+   uint8 *rxbuf;
+   int len, hlen, dlen;
+
+   rxbuf = (*stack->rxbuf)[idx];
+   len = (*stack->txbuflength)[idx] - ETH_HEADERSIZE;
+   hlen = EC_HEADERSIZE + port->rxdirectoff[idx];
+   dlen = port->rxdirectlen[idx];
+   frame += ETH_HEADERSIZE;
+   if (port->rxdirect[idx] && (stack == &(port->stack)))
+   {
+      memcpy(rxbuf, frame, hlen);
+      memcpy(port->rxdirect[idx], frame + hlen, dlen);
+      memcpy(rxbuf + hlen + dlen, frame + hlen + dlen, len - hlen - dlen);
+   }
+   else
+   {
+      memcpy(rxbuf, frame, len);
+   }
+}
+
+/** Store received frame in the buffer of its index if someone is waiting
+ * for it, and mark it as received.
+ * @param[in] port        = port context struct
+ * @param[in] stack       = stack the frame was received on
+ * @param[in] frame       = received frame incl. ethernet header
+ * @param[in] rxtime      = receive timestamp of frame
+ */
+static void ecx_storeframe(ecx_portt *port, ec_stackT *stack, uint8 *frame, int64 rxtime)
+{
+   int idxf;
+   ec_etherheadert *ehp;
+   ec_comt *ecp;
+
+   ehp = (ec_etherheadert *)frame;
+   /* check if it is an EtherCAT frame */
+   if (ehp->etype != htons(ETH_P_ECAT))
+   {
+      return;
+   }
+   ecp = (ec_comt *)(&frame[ETH_HEADERSIZE]);
+   idxf = ecp->index;
+   /* check if index exist and someone is waiting for it */
+   if (idxf < EC_MAXBUF && (*stack->rxbufstat)[idxf] == EC_BUF_TX)
+   {
+      /* put it in the buffer array (strip ethernet header) */
+      ecx_copyframe(port, stack, idxf, frame);
+      /* mark as received */
+      (*stack->rxbufstat)[idxf] = EC_BUF_RCVD;
+      (*stack->rxsa)[idxf] = ntohs(ehp->sa1);
+      (*stack->rxtime)[idxf] = rxtime;
+   }
+   else
+   {
+      /* strange things happened */
+   }
+}
+
+/** Set up iovec to receive the frame of an index with zero copy target.
+ * The ethernet header goes to buf, the part of the first datagram data
+ * selected with ecx_setrxdirect() to the target and everything before and
+ * after it to the rx buffer.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index of expected frame
+ * @param[in] buf         = buffer for ethernet header
+ * @param[out] iov        = iovec of 4 elements
+ */
+static void ecx_directiov(ecx_portt *port, int idx, uint8 *buf, struct iovec *iov)
+{
+   int hlen, dlen;
+
+   hlen = EC_HEADERSIZE + port->rxdirectoff[idx];
+   dlen = port->rxdirectlen[idx];
+   iov[0].iov_base = buf;
+   iov[0].iov_len = ETH_HEADERSIZE;
+   iov[1].iov_base = &(port->rxbuf[idx]);
+   iov[1].iov_len = hlen;
+   iov[2].iov_base = port->rxdirect[idx];
+   iov[2].iov_len = dlen;
+   iov[3].iov_base = &(port->rxbuf[idx][hlen + dlen]);
+   iov[3].iov_len = sizeof(port->rxbuf[idx]) - hlen - dlen;
+}
+
+/** Check frame received with the iovec of ecx_directiov(). If it is the
+ * expected frame it is marked as received. Otherwise the frame is reassembled
+ * in buf and the target is restored from the transmit buffer. The caller
+ * stores the reassembled frame after all frames of the batch are checked, as
+ * its own layout may be in use by a later frame of the batch.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index of expected frame
+ * @param[in] buf         = buffer holding the ethernet header, room for a full frame
+ * @param[in] len         = received length
+ * @param[in] rxtime      = receive timestamp of frame
+ * @return 1 if buf holds a reassembled frame to store
+ */
+static int ecx_directframe(ecx_portt *port, int idx, uint8 *buf, int len, int64 rxtime)
+{
+   ec_etherheadert *ehp;
+   ec_comt *ecp;
+   int hlen, dlen, n;
+
+   ehp = (ec_etherheadert *)buf;
+   ecp = (ec_comt *)&(port->rxbuf[idx]);
+   hlen = EC_HEADERSIZE + port->rxdirectoff[idx];
+   dlen = port->rxdirectlen[idx];
+   if ((len >= (int)ETH_HEADERSIZE + hlen + dlen) && (ehp->etype == htons(ETH_P_ECAT)) &&
+       (ecp->index == idx) && (port->rxbufstat[idx] == EC_BUF_TX))
+   {
+      port->rxbufstat[idx] = EC_BUF_RCVD;
+      port->rxsa[idx] = ntohs(ehp->sa1);
+      port->rxtime[idx] = rxtime;
+      return 0;
+   }
+   /* another frame, gather its parts and put back what it overwrote */
+   n = len - ETH_HEADERSIZE;
+   if (n > 0)
+   {
+      memcpy(buf + ETH_HEADERSIZE, &(port->rxbuf[idx]), (n < hlen) ? n : hlen);
+   }
+   n -= hlen;
+   if (n > 0)
+   {
+      memcpy(buf + ETH_HEADERSIZE + hlen, port->rxdirect[idx], (n < dlen) ? n : dlen);
+   }
+   n -= dlen;
+   if (n > 0)
+   {
+      memcpy(buf + ETH_HEADERSIZE + hlen + dlen, &(port->rxbuf[idx][hlen + dlen]), n);
+   }
+   memcpy(port->rxdirect[idx], &(port->txbuf[idx][ETH_HEADERSIZE + hlen]), dlen);
+
+   return (len > (int)ETH_HEADERSIZE);
+}
+
+/** Non blocking receive of all frames available on a stack. Frames are
+ * stored in the buffer of their index, see ecx_storeframe(). In socket mode
+ * the frames are read with a single recvmmsg() call, where the n-th frame
+ * is read with the zero copy layout of the n-th index still waiting.
+ * @param[in] port        = port context struct
+ * @param[in] stacknumber = 0=primary 1=secondary stack
+ * @param[in] idx         = indexes of frames waited for, in transmit order
+ * @param[in] cnt         = number of indexes
+ * @return number of frames read
+ */
+static int ecx_inframes(ecx_portt *port, int stacknumber, const uint8 *idx, int cnt)
+{
+   struct mmsghdr msgs[EC_MAXBUF];
+   struct iovec iov[EC_MAXBUF][4];
+   uint8 ctrl[EC_MAXBUF][EC_TSCTRLSIZE];
+   int expect[EC_MAXBUF];
+   ec_stackT *stack;
+   uint8 *frame;
+   int i, n, cnt2;
+
+   if (!stacknumber)
+   {
+      stack = &(port->stack);
+   }
+   else
+   {
+      stack = &(port->redport->stack);
+   }
+   cnt2 = 0;
+   pthread_mutex_lock(&(port->rx_mutex));
+   if (stack->xdp->umem || stack->ring->map)
+   {
+      /* frames are in shared memory, no syscall needed */
+      while ((cnt2 < EC_MAXBUF) && ecx_recvpkt(port, stacknumber, &frame))
+      {
+         ecx_storeframe(port, stack, frame, port->tempints);
+         ecx_recvpkt_release(port, stacknumber);
+         cnt2++;
+      }
+   }
+   else
+   {
+      /* frames normally return in transmit order */
+      n = 0;
+      for (i = 0; !stacknumber && (i < cnt); i++)
+      {
+         if ((*stack->rxbufstat)[idx[i]] == EC_BUF_TX)
+         {
+            expect[n++] = idx[i];
+         }
+      }
+      memset(msgs, 0, sizeof(msgs));
+      for (i = 0; i < EC_MAXBUF; i++)
+      {
+         if ((i < n) && port->rxdirect[expect[i]])
+         {
+            ecx_directiov(port, expect[i], port->rxbatch[i], iov[i]);
+            msgs[i].msg_hdr.msg_iovlen = 4;
+         }
+         else
+         {
+            iov[i][0].iov_base = port->rxbatch[i];
+            iov[i][0].iov_len = sizeof(port->rxbatch[i]);
+            msgs[i].msg_hdr.msg_iovlen = 1;
+         }
+         msgs[i].msg_hdr.msg_iov = iov[i];
+         if (*stack->tsactive)
+         {
+            msgs[i].msg_hdr.msg_control = ctrl[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(ctrl[i]);
+         }
+      }
+      cnt2 = recvmmsg(*stack->sock, msgs, EC_MAXBUF, MSG_DONTWAIT, NULL);
+      /* frames in the layout of another index are reassembled first,
+       * msg_iovlen is left at 1 for each frame that still has to be stored */
+      for (i = 0; i < cnt2; i++)
+      {
+         if (msgs[i].msg_hdr.msg_iovlen == 4)
+         {
+            msgs[i].msg_hdr.msg_iovlen = ecx_directframe(port, expect[i], port->rxbatch[i], msgs[i].msg_len,
+                                           *stack->tsactive ? ecx_cmsgtime(&msgs[i].msg_hdr) : 0);
+         }
+      }
+      for (i = 0; i < cnt2; i++)
+      {
+         if ((msgs[i].msg_hdr.msg_iovlen == 1) && (msgs[i].msg_len > ETH_HEADERSIZE))
+         {
+            ecx_storeframe(port, stack, port->rxbatch[i],
+                           *stack->tsactive ? ecx_cmsgtime(&msgs[i].msg_hdr) : 0);
+         }
+      }
+      if (cnt2 < 0)
+      {
+         cnt2 = 0;
+      }
+   }
+   pthread_mutex_unlock(&(port->rx_mutex));
+
+   return cnt2;
+}
+
 /** Non blocking receive frame function. Uses RX buffer and index to combine
  * read frame with transmitted frame. To compensate for received frames that
  * are out-of-order all frames are stored in their respective indexed buffer.
@@ -379,6 +1188,7 @@ int ecx_inframe(ecx_portt *port, int idx, int stacknumber)
    ec_comt *ecp;
    ec_stackT *stack;
    ec_bufT *rxbuf;
+   uint8   *frame;
 
    if (!stacknumber)
    {
@@ -403,46 +1213,40 @@ int ecx_inframe(ecx_portt *port, int idx, int stacknumber)
    {
       pthread_mutex_lock(&(port->rx_mutex));
       /* non blocking call to retrieve frame from socket */
-      if (ecx_recvpkt(port, stacknumber))
+      if (ecx_recvpkt(port, stacknumber, &frame))
       {
          rval = EC_OTHERFRAME;
-         ehp =(ec_etherheadert*)(stack->tempbuf);
+         ehp =(ec_etherheadert*)frame;
          /* check if it is an EtherCAT frame */
          if (ehp->etype == htons(ETH_P_ECAT))
          {
-            ecp =(ec_comt*)(&(*stack->tempbuf)[ETH_HEADERSIZE]);
+            ecp =(ec_comt*)(&frame[ETH_HEADERSIZE]);
             l = etohs(ecp->elength) & 0x0fff;
             idxf = ecp->index;
             /* found index equals requested index ? */
             if (idxf == idx)
             {
                /* yes, put it in the buffer array (strip ethernet header) */
-               memcpy(rxbuf, &(*stack->tempbuf)[ETH_HEADERSIZE], (*stack->txbuflength)[idx] - ETH_HEADERSIZE);
+               ecx_copyframe(port, stack, idx, frame);
                /* return WKC */
                rval = ((*rxbuf)[l] + ((uint16)((*rxbuf)[l + 1]) << 8));
                /* mark as completed */
                (*stack->rxbufstat)[idx] = EC_BUF_COMPLETE;
                /* store MAC source word 1 for redundant routing info */
                (*stack->rxsa)[idx] = ntohs(ehp->sa1);
+               (*stack->rxtime)[idx] = port->tempints;
+               /* transmit timestamp is in error queue by now */
+               if (!stacknumber && port->tsactive)
+               {
+                  ecx_readtxtime(port);
+               }
             }
             else
             {
-               /* check if index exist and someone is waiting for it */
-               if (idxf < EC_MAXBUF && (*stack->rxbufstat)[idxf] == EC_BUF_TX)
-               {
-                  rxbuf = &(*stack->rxbuf)[idxf];
-                  /* put it in the buffer array (strip ethernet header) */
-                  memcpy(rxbuf, &(*stack->tempbuf)[ETH_HEADERSIZE], (*stack->txbuflength)[idxf] - ETH_HEADERSIZE);
-                  /* mark as received */
-                  (*stack->rxbufstat)[idxf] = EC_BUF_RCVD;
-                  (*stack->rxsa)[idxf] = ntohs(ehp->sa1);
-               }
-               else
-               {
-                  /* strange things happened */
-               }
+               ecx_storeframe(port, stack, frame, port->tempints);
             }
          }
+         ecx_recvpkt_release(port, stacknumber);
       }
       pthread_mutex_unlock( &(port->rx_mutex) );
 
@@ -452,6 +1256,106 @@ int ecx_inframe(ecx_portt *port, int idx, int stacknumber)
    return rval;
 }
 
+/** Descriptor to wait on for received frames of a stack.
+ * @param[in] stack       = stack
+ * @return file descriptor
+ */
+static int ecx_rxfd(ec_stackT *stack)
+{
+   if (stack->xdp->umem)
+   {
+      return stack->xdp->fd;
+   }
+   return *stack->sock;
+}
+
+/** Wait for receive activity according to the port wait mode. In poll mode
+ * the caller sleeps until a frame is available or the deadline passes, in
+ * hybrid mode only after it has spun for waittime us. Other modes return at
+ * once and the caller keeps spinning.
+ * @param[in] port        = port context struct
+ * @param[in] timer       = absolute timeout time
+ * @param[in] start       = start of wait from osal_current_time_ns()
+ * @param[in] primary     = wait on primary stack
+ * @param[in] secondary   = wait on secondary stack
+ */
+static void ecx_waitrx(ecx_portt *port, osal_timert *timer, int64 start,
+                       int primary, int secondary)
+{
+   struct pollfd fds[2];
+   struct timespec ts;
+   int64 now, left;
+   int n;
+
+   if ((port->waitmode != ECT_WAIT_POLL) && (port->waitmode != ECT_WAIT_HYBRID))
+   {
+      return;
+   }
+   now = osal_current_time_ns();
+   if ((port->waitmode == ECT_WAIT_HYBRID) &&
+       ((now - start) < ((int64)port->waittime * 1000)))
+   {
+      return;
+   }
+   left = osal_timer_left_ns(timer, now);
+   if (left <= 0)
+   {
+      return;
+   }
+   ts.tv_sec = left / 1000000000;
+   ts.tv_nsec = left % 1000000000;
+   n = 0;
+   if (primary)
+   {
+      fds[n].fd = ecx_rxfd(&(port->stack));
+      fds[n].events = POLLIN;
+      n++;
+   }
+   if (secondary && (port->redstate != ECT_RED_NONE))
+   {
+      fds[n].fd = ecx_rxfd(&(port->redport->stack));
+      fds[n].events = POLLIN;
+      n++;
+   }
+   if (n && (ppoll(fds, n, &ts, NULL) > 0))
+   {
+      /* pending tx timestamps wake up poll, fetch them */
+      if (primary && (fds[0].revents & POLLERR))
+      {
+         ecx_readtxtime(port);
+      }
+   }
+}
+
+/** Add duration of a receive wait to port statistics.
+ * @param[in] port        = port context struct
+ * @param[in] start       = start of wait from osal_current_time_ns()
+ * @param[in] wkc         = result of wait
+ */
+static void ecx_updwaitstat(ecx_portt *port, int64 start, int wkc)
+{
+   ec_waitstatT *stat;
+   uint32 us;
+
+   us = (uint32)((osal_current_time_ns() - start) / 1000);
+   stat = &(port->waitstat);
+   stat->last = us;
+   if (!stat->count || (us < stat->min))
+   {
+      stat->min = us;
+   }
+   if (us > stat->max)
+   {
+      stat->max = us;
+   }
+   stat->total += us;
+   stat->count++;
+   if (wkc <= EC_NOFRAME)
+   {
+      stat->timeouts++;
+   }
+}
+
 /** Blocking redundant receive frame function. If redundant mode is not active then
  * it skips the secondary stack and redundancy functions. In redundant mode it waits
  * for both (primary and secondary) frames to come in. The result goes in an decision
@@ -467,10 +1371,12 @@ int ecx_inframe(ecx_portt *port, int idx, int stacknumber)
 static int ecx_waitinframe_red(ecx_portt *port, int idx, osal_timert *timer)
 {
    osal_timert timer2;
+   int64 start;
    int wkc  = EC_NOFRAME;
    int wkc2 = EC_NOFRAME;
    int primrx, secrx;
 
+   start = osal_current_time_ns();
    /* if not in redundant mode then always assume secondary is OK */
    if (port->redstate == ECT_RED_NONE)
       wkc2 = 0;
@@ -486,6 +1392,8 @@ static int ecx_waitinframe_red(ecx_portt *port, int idx, osal_timert *timer)
          if (wkc2 <= EC_NOFRAME)
             wkc2 = ecx_inframe(port, idx, 1);
       }
+      if ((wkc <= EC_NOFRAME) || (wkc2 <= EC_NOFRAME))
+         ecx_waitrx(port, timer, start, (wkc <= EC_NOFRAME), (wkc2 <= EC_NOFRAME));
    /* wait for both frames to arrive or timeout */
    } while (((wkc <= EC_NOFRAME) || (wkc2 <= EC_NOFRAME)) && !osal_timer_is_expired(timer));
    /* only do redundant functions when in redundant mode */
@@ -526,6 +1434,8 @@ static int ecx_waitinframe_red(ecx_portt *port, int idx, osal_timert *timer)
          {
             /* retrieve frame */
             wkc2 = ecx_inframe(port, idx, 1);
+            if (wkc2 <= EC_NOFRAME)
+               ecx_waitrx(port, &timer2, start, 0, 1);
          } while ((wkc2 <= EC_NOFRAME) && !osal_timer_is_expired(&timer2));
          if (wkc2 > EC_NOFRAME)
          {
@@ -536,6 +1446,8 @@ static int ecx_waitinframe_red(ecx_portt *port, int idx, osal_timert *timer)
       }
    }
 
+   ecx_updwaitstat(port, start, wkc);
+
    /* return WKC or EC_NOFRAME */
    return wkc;
 }
@@ -597,6 +1509,332 @@ int ecx_srconfirm(ecx_portt *port, int idx, int timeout)
    return wkc;
 }
 
+/** Queue frame for transmission by ecx_flushframes(). The frame is marked
+ * as transmitted so its answer is accepted as soon as it is flushed.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index in tx buffer array
+ * @return >0 if frame is queued
+ */
+int ecx_queueframe_red(ecx_portt *port, int idx)
+{
+   ec_etherheadert *ehp;
+
+   if (port->txqueued >= EC_MAXBUF)
+   {
+      ecx_flushframes(port);
+   }
+   ehp = (ec_etherheadert *)&(port->txbuf[idx]);
+   /* rewrite MAC source address 1 to primary */
+   ehp->sa1 = htons(priMAC[1]);
+   pthread_mutex_lock( &(port->tx_mutex) );
+   port->rxbufstat[idx] = EC_BUF_TX;
+   port->txtime[idx] = 0;
+   port->rxtime[idx] = 0;
+   if (port->redstate != ECT_RED_NONE)
+   {
+      port->redport->rxbufstat[idx] = EC_BUF_TX;
+   }
+   port->txqueue[port->txqueued++] = idx;
+   pthread_mutex_unlock( &(port->tx_mutex) );
+
+   return 1;
+}
+
+/** Transmit all frames queued by ecx_queueframe_red(). In socket mode the
+ * primary frames go out with a single sendmmsg() call, in ring and AF_XDP
+ * mode with a single kick. In redundant mode a dummy frame per queued index
+ * is sent on the secondary port.
+ * @param[in] port        = port context struct
+ * @return number of primary frames transmitted
+ */
+int ecx_flushframes(ecx_portt *port)
+{
+   struct mmsghdr msgs[EC_MAXBUF];
+   struct iovec iov[EC_MAXBUF][3];
+   ec_comt *datagramP;
+   ec_etherheadert *ehp;
+   int i, idx, sent;
+
+   pthread_mutex_lock( &(port->tx_mutex) );
+   sent = 0;
+   if (port->txqueued)
+   {
+      if (port->stack.xdp->umem || port->stack.ring->map)
+      {
+         for (i = 0; i < port->txqueued; i++)
+         {
+            idx = port->txqueue[i];
+            if (ecx_sendpkt(&(port->stack), iov[i], ecx_txiov(port, &(port->stack), idx, iov[i]), 0) == -1)
+            {
+               port->rxbufstat[idx] = EC_BUF_EMPTY;
+            }
+            else
+            {
+               sent++;
+            }
+         }
+         ecx_kickpkt(&(port->stack));
+      }
+      else
+      {
+         memset(msgs, 0, sizeof(msgs));
+         for (i = 0; i < port->txqueued; i++)
+         {
+            idx = port->txqueue[i];
+            msgs[i].msg_hdr.msg_iov = iov[i];
+            msgs[i].msg_hdr.msg_iovlen = ecx_txiov(port, &(port->stack), idx, iov[i]);
+         }
+         sent = sendmmsg(port->sockhandle, msgs, port->txqueued, 0);
+         if (sent < 0)
+         {
+            sent = 0;
+         }
+         /* frames not sent will not return */
+         for (i = sent; i < port->txqueued; i++)
+         {
+            port->rxbufstat[port->txqueue[i]] = EC_BUF_EMPTY;
+         }
+      }
+      if (port->redstate != ECT_RED_NONE)
+      {
+         ehp = (ec_etherheadert *)&(port->txbuf2);
+         /* rewrite MAC source address 1 to secondary */
+         ehp->sa1 = htons(secMAC[1]);
+         datagramP = (ec_comt*)&(port->txbuf2[ETH_HEADERSIZE]);
+         for (i = 0; i < port->txqueued; i++)
+         {
+            idx = port->txqueue[i];
+            /* write index to dummy frame, ring modes copy it on send */
+            datagramP->index = idx;
+            iov[0][0].iov_base = &(port->txbuf2);
+            iov[0][0].iov_len = port->txbuflength2;
+            if (ecx_sendpkt(&(port->redport->stack), iov[0], 1, 0) == -1)
+            {
+               port->redport->rxbufstat[idx] = EC_BUF_EMPTY;
+            }
+         }
+         ecx_kickpkt(&(port->redport->stack));
+      }
+      port->txqueued = 0;
+   }
+   pthread_mutex_unlock( &(port->tx_mutex) );
+
+   return sent;
+}
+
+/** Blocking receive of several frames. Waits until all frames with the
+ * given indexes have arrived, also on the secondary port in redundant mode,
+ * or the timeout passes. Available frames are read in batches and stored
+ * in the buffer of their index. Collect each result afterwards with
+ * ecx_waitinframe(), which then finds the frame in its buffer.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = indexes of frames to wait for
+ * @param[in] cnt         = number of indexes
+ * @param[in] timeout     = timeout in us
+ * @return number of frames received on primary port
+ */
+int ecx_waitinframes(ecx_portt *port, const uint8 *idx, int cnt, int timeout)
+{
+   osal_timert timer;
+   int64 start;
+   int i, primwait, secwait;
+   int64 txfirst, rxlast;
+
+   start = osal_current_time_ns();
+   osal_timer_start(&timer, timeout);
+   do
+   {
+      ecx_inframes(port, 0, idx, cnt);
+      if (port->redstate != ECT_RED_NONE)
+      {
+         ecx_inframes(port, 1, idx, cnt);
+      }
+      primwait = 0;
+      secwait = 0;
+      for (i = 0; i < cnt; i++)
+      {
+         if (port->rxbufstat[idx[i]] == EC_BUF_TX)
+         {
+            primwait++;
+         }
+         if ((port->redstate != ECT_RED_NONE) && (port->redport->rxbufstat[idx[i]] == EC_BUF_TX))
+         {
+            secwait++;
+         }
+      }
+      if (!primwait && !secwait)
+      {
+         break;
+      }
+      ecx_waitrx(port, &timer, start, primwait, secwait);
+   } while (!osal_timer_is_expired(&timer));
+   ecx_updwaitstat(port, start, (primwait || secwait) ? EC_NOFRAME : 0);
+   /* round trip from first frame on the wire to last frame back */
+   port->cyclertt = -1;
+   if (port->tsactive && cnt && !primwait)
+   {
+      ecx_readtxtime(port);
+      txfirst = 0;
+      rxlast = 0;
+      for (i = 0; i < cnt; i++)
+      {
+         if (!port->txtime[idx[i]] || !port->rxtime[idx[i]])
+         {
+            break;
+         }
+         if (!txfirst || (port->txtime[idx[i]] < txfirst))
+         {
+            txfirst = port->txtime[idx[i]];
+         }
+         if (port->rxtime[idx[i]] > rxlast)
+         {
+            rxlast = port->rxtime[idx[i]];
+         }
+      }
+      if (i == cnt)
+      {
+         port->cyclertt = rxlast - txfirst;
+      }
+   }
+
+   return cnt - primwait;
+}
+
+/** Set zero copy transmit source of a frame. The first bytes of the first
+ * datagram data are then sent from the source, the transmit buffer only has
+ * to hold the headers and the rest of the frame. The source must stay valid
+ * until the frame is sent. Call after the frame is set up, the source is
+ * cleared when the index is allocated again.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index of frame
+ * @param[in] data        = source, normally the outputs in the IOmap
+ * @param[in] length      = number of bytes sent from source
+ * @return >0 if the data will be sent from the source, 0 if the caller has to copy it
+ */
+int ecx_settxdirect(ecx_portt *port, int idx, void *data, int length)
+{
+   /* the redundant path resends frames from the transmit buffer */
+   if ((idx < 0) || (idx >= EC_MAXBUF) || (port->redstate != ECT_RED_NONE) || (length < 0) ||
+       ((int)(ETH_HEADERSIZE + EC_HEADERSIZE) + length > port->txbuflength[idx]))
+   {
+      return 0;
+   }
+   port->txdirect[idx] = data;
+   port->txdirectlen[idx] = length;
+
+   return 1;
+}
+
+/** Set zero copy receive target of a frame. The bytes offset to offset +
+ * length of the first datagram data of the answer are then placed in the
+ * target instead of in the rx buffer, the rest of the frame is in the rx buffer
+ * as usual. The target must hold the same bytes as the transmit buffer until
+ * the answer is in, it is used as scratch when another frame arrives in its
+ * place, so it can not overlap the part sent with ecx_settxdirect(). Call after
+ * the frame is set up and before it is sent, the target is cleared when the
+ * index is allocated again.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index of frame
+ * @param[in] offset      = offset in first datagram data
+ * @param[in] data        = target, normally the IOmap part the datagram was set up from
+ * @param[in] length      = number of bytes placed in target
+ * @return >0 if the data will be placed in the target, 0 if the caller has to copy it
+ */
+int ecx_setrxdirect(ecx_portt *port, int idx, int offset, void *data, int length)
+{
+   /* the redundant path combines frames of both ports in the rx buffer */
+   if ((idx < 0) || (idx >= EC_MAXBUF) || (port->redstate != ECT_RED_NONE) ||
+       (offset < 0) || (length < 0) ||
+       ((int)(ETH_HEADERSIZE + EC_HEADERSIZE) + offset + length > port->txbuflength[idx]) ||
+       (port->txdirect[idx] && (offset < port->txdirectlen[idx])))
+   {
+      return 0;
+   }
+   port->rxdirect[idx] = data;
+   port->rxdirectoff[idx] = offset;
+   port->rxdirectlen[idx] = length;
+
+   return 1;
+}
+
+/** Select how the receive functions wait for frames.
+ * Can be called before or after ecx_setupnic().
+ * @param[in] port        = port context struct
+ * @param[in] waitmode    = ECT_WAIT_SPIN, ECT_WAIT_BUSYPOLL, ECT_WAIT_POLL or ECT_WAIT_HYBRID
+ * @param[in] waittime    = busy poll budget (ECT_WAIT_BUSYPOLL, 0 = default) or
+ *                          spin time before sleeping (ECT_WAIT_HYBRID) in us
+ * @return >0 if succeeded
+ */
+int ecx_setwaitmode(ecx_portt *port, int waitmode, int waittime)
+{
+   if ((waitmode < ECT_WAIT_SPIN) || (waitmode > ECT_WAIT_HYBRID) || (waittime < 0))
+   {
+      return 0;
+   }
+   port->waitmode = waitmode;
+   port->waittime = waittime;
+   /* sockets already open? */
+   if (port->stack.sock)
+   {
+      ecx_setbusypoll(port->sockhandle, port);
+      if (port->xdp.umem)
+         ecx_setbusypoll(port->xdp.fd, port);
+      if (port->redstate != ECT_RED_NONE)
+      {
+         ecx_setbusypoll(port->redport->sockhandle, port);
+         if (port->redport->xdp.umem)
+            ecx_setbusypoll(port->redport->xdp.fd, port);
+      }
+   }
+
+   return 1;
+}
+
+/** Reset receive wait statistics.
+ * @param[in] port        = port context struct
+ */
+void ecx_clearwaitstat(ecx_portt *port)
+{
+   memset(&(port->waitstat), 0, sizeof(port->waitstat));
+}
+
+/** Get transmit and receive timestamp of last frame sent with index.
+ * Requires ecx_portt.tsmode to be set before ecx_setupnic().
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index of frame
+ * @param[out] txtime     = transmit timestamp in ns, 0 if unknown
+ * @param[out] rxtime     = receive timestamp in ns, 0 if unknown
+ * @return >0 if both timestamps are known
+ */
+int ecx_getframetimes(ecx_portt *port, int idx, int64 *txtime, int64 *rxtime)
+{
+   if ((idx < 0) || (idx >= EC_MAXBUF))
+   {
+      return 0;
+   }
+   if (port->tsactive && !port->txtime[idx])
+   {
+      pthread_mutex_lock(&(port->rx_mutex));
+      ecx_readtxtime(port);
+      pthread_mutex_unlock(&(port->rx_mutex));
+   }
+   *txtime = port->txtime[idx];
+   *rxtime = port->rxtime[idx];
+
+   return (*txtime && *rxtime);
+}
+
+/** Get round trip time of the last process data cycle, measured from the
+ * transmit timestamp of the first frame to the receive timestamp of the
+ * last frame collected by ecx_waitinframes().
+ * @param[in] port        = port context struct
+ * @return round trip time in ns, -1 if unknown
+ */
+int64 ecx_getcyclertt(ecx_portt *port)
+{
+   return port->cyclertt;
+}
+
 #ifdef EC_VER1
 int ec_setupnic(const char *ifname, int secondary)
 {
@@ -642,4 +1880,49 @@ int ec_srconfirm(int idx, int timeout)
 {
    return ecx_srconfirm(&ecx_port, idx, timeout);
 }
+
+int ec_queueframe_red(int idx)
+{
+   return ecx_queueframe_red(&ecx_port, idx);
+}
+
+int ec_flushframes(void)
+{
+   return ecx_flushframes(&ecx_port);
+}
+
+int ec_waitinframes(const uint8 *idx, int cnt, int timeout)
+{
+   return ecx_waitinframes(&ecx_port, idx, cnt, timeout);
+}
+
+int ec_settxdirect(int idx, void *data, int length)
+{
+   return ecx_settxdirect(&ecx_port, idx, data, length);
+}
+
+int ec_setrxdirect(int idx, int offset, void *data, int length)
+{
+   return ecx_setrxdirect(&ecx_port, idx, offset, data, length);
+}
+
+int ec_setwaitmode(int waitmode, int waittime)
+{
+   return ecx_setwaitmode(&ecx_port, waitmode, waittime);
+}
+
+void ec_clearwaitstat(void)
+{
+   ecx_clearwaitstat(&ecx_port);
+}
+
+int ec_getframetimes(int idx, int64 *txtime, int64 *rxtime)
+{
+   return ecx_getframetimes(&ecx_port, idx, txtime, rxtime);
+}
+
+int64 ec_getcyclertt(void)
+{
+   return ecx_getcyclertt(&ecx_port);
+}
 #endif
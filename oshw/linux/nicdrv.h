@@ -17,6 +17,86 @@ extern "C"
 #endif
 
 #include <pthread.h>
+#include <stddef.h>
+#include "nicdrv_xdp.h"
+
+/** NIC transport modes, select with ecx_portt.nicmode before ecx_setupnic() */
+enum
+{
+   /** plain SOCK_RAW packet socket, one syscall per frame (default) */
+   ECT_NIC_SOCKET,
+   /** PACKET_MMAP TX/RX rings, falls back to socket mode if not supported */
+   ECT_NIC_RING,
+   /** AF_XDP socket, falls back to socket mode if not supported */
+   ECT_NIC_XDP
+};
+
+/** frame timestamping modes, select with ecx_portt.tsmode before ecx_setupnic() */
+enum
+{
+   /** no timestamps (default) */
+   ECT_TS_NONE,
+   /** kernel software timestamps, CLOCK_REALTIME */
+   ECT_TS_SOFTWARE,
+   /** NIC hardware timestamps, falls back to software if not supported */
+   ECT_TS_HARDWARE
+};
+
+/** receive wait strategies, select with ecx_setwaitmode() */
+enum
+{
+   /** spin on blocking recv() with 1us SO_RCVTIMEO (default) */
+   ECT_WAIT_SPIN,
+   /** spin on non blocking recv() with SO_BUSY_POLL driver polling */
+   ECT_WAIT_BUSYPOLL,
+   /** sleep in ppoll() until a frame arrives or the deadline passes */
+   ECT_WAIT_POLL,
+   /** spin for waittime us, then sleep in ppoll() */
+   ECT_WAIT_HYBRID
+};
+
+/** receive wait statistics, times in us. Updated without locking so values
+ * are approximate when several threads receive on the same port. */
+typedef struct
+{
+   /** duration of last wait */
+   uint32      last;
+   /** shortest wait */
+   uint32      min;
+   /** longest wait */
+   uint32      max;
+   /** sum of all waits */
+   uint64      total;
+   /** number of waits */
+   uint32      count;
+   /** number of waits that ended without a frame */
+   uint32      timeouts;
+} ec_waitstatT;
+
+/** PACKET_MMAP ring state for one socket, map == NULL when not in use */
+typedef struct
+{
+   /** mapped memory, RX ring followed by TX ring */
+   uint8       *map;
+   /** total size of mapped memory */
+   size_t      mapsize;
+   /** start of RX ring */
+   uint8       *rx;
+   /** start of TX ring */
+   uint8       *tx;
+   /** size of one ring frame slot */
+   int         framesize;
+   /** number of frame slots in RX ring */
+   int         rxframes;
+   /** number of frame slots in TX ring */
+   int         txframes;
+   /** next RX slot to inspect */
+   int         rxpos;
+   /** next TX slot to fill */
+   int         txpos;
+   /** RX slot held by the caller, -1 if none */
+   int         rxheld;
+} ec_ringT;
 
 /** pointer structure to Tx and Rx stacks */
 typedef struct
@@ -35,6 +115,14 @@ typedef struct
    int         (*rxbufstat)[EC_MAXBUF];
    /** received MAC source address (middle word) */
    int         (*rxsa)[EC_MAXBUF];
+   /** PACKET_MMAP rings of socket */
+   ec_ringT    *ring;
+   /** AF_XDP socket */
+   ec_xdpT     *xdp;
+   /** active timestamping mode of socket */
+   int         *tsactive;
+   /** rx timestamps in ns */
+   int64       (*rxtime)[EC_MAXBUF];
 } ec_stackT;
 
 /** pointer structure to buffers for redundant port */
@@ -50,6 +138,14 @@ typedef struct
    int rxsa[EC_MAXBUF];
    /** temporary rx buffer */
    ec_bufT tempinbuf;
+   /** PACKET_MMAP rings */
+   ec_ringT ring;
+   /** AF_XDP socket */
+   ec_xdpT xdp;
+   /** active timestamping mode */
+   int tsactive;
+   /** rx timestamps in ns */
+   int64 rxtime[EC_MAXBUF];
 } ecx_redportt;
 
 /** pointer structure to buffers, vars and mutexes for port instantiation */
@@ -81,7 +177,48 @@ typedef struct
    int redstate;
    /** pointer to redundancy port and buffers */
    ecx_redportt *redport;
-   pthread_mutex_t getindex_mutex;
+   /** requested NIC transport mode, ECT_NIC_SOCKET, ECT_NIC_RING or ECT_NIC_XDP */
+   int nicmode;
+   /** NIC queue used in ECT_NIC_XDP mode */
+   int xdpqueue;
+   /** receive wait strategy, ECT_WAIT_SPIN, ECT_WAIT_BUSYPOLL, ECT_WAIT_POLL or ECT_WAIT_HYBRID */
+   int waitmode;
+   /** busy poll budget (ECT_WAIT_BUSYPOLL) or spin time (ECT_WAIT_HYBRID) in us */
+   int waittime;
+   /** receive wait statistics */
+   ec_waitstatT waitstat;
+   /** frame indexes queued for ecx_flushframes() */
+   int txqueue[EC_MAXBUF];
+   /** number of queued frames */
+   int txqueued;
+   /** receive buffers for batched socket reads */
+   ec_bufT rxbatch[EC_MAXBUF];
+   /** zero copy transmit source of the first datagram data per index, NULL if none */
+   uint8 *txdirect[EC_MAXBUF];
+   /** number of bytes sent from zero copy transmit source */
+   int txdirectlen[EC_MAXBUF];
+   /** zero copy receive target of the first datagram data per index, NULL if none */
+   uint8 *rxdirect[EC_MAXBUF];
+   /** offset of zero copy receive target in the first datagram data */
+   int rxdirectoff[EC_MAXBUF];
+   /** length of zero copy receive target */
+   int rxdirectlen[EC_MAXBUF];
+   /** requested timestamping mode, ECT_TS_NONE, ECT_TS_SOFTWARE or ECT_TS_HARDWARE */
+   int tsmode;
+   /** active timestamping mode */
+   int tsactive;
+   /** rx timestamp of temporary rx buffer in ns */
+   int64 tempints;
+   /** tx timestamps in ns, 0 if not (yet) known */
+   int64 txtime[EC_MAXBUF];
+   /** rx timestamps in ns, 0 if not (yet) known */
+   int64 rxtime[EC_MAXBUF];
+   /** round trip time of last cycle collected by ecx_waitinframes() in ns, -1 if unknown */
+   int64 cyclertt;
+   /** PACKET_MMAP rings */
+   ec_ringT ring;
+   /** AF_XDP socket */
+   ec_xdpT xdp;
    pthread_mutex_t tx_mutex;
    pthread_mutex_t rx_mutex;
 } ecx_portt;
@@ -101,6 +238,15 @@ int ec_outframe(int idx, int sock);
 int ec_outframe_red(int idx);
 int ec_waitinframe(int idx, int timeout);
 int ec_srconfirm(int idx,int timeout);
+int ec_queueframe_red(int idx);
+int ec_flushframes(void);
+int ec_waitinframes(const uint8 *idx, int cnt, int timeout);
+int ec_settxdirect(int idx, void *data, int length);
+int ec_setrxdirect(int idx, int offset, void *data, int length);
+int ec_setwaitmode(int waitmode, int waittime);
+void ec_clearwaitstat(void);
+int ec_getframetimes(int idx, int64 *txtime, int64 *rxtime);
+int64 ec_getcyclertt(void);
 #endif
 
 void ec_setupheader(void *p);
@@ -112,6 +258,15 @@ int ecx_outframe(ecx_portt *port, int idx, int sock);
 int ecx_outframe_red(ecx_portt *port, int idx);
 int ecx_waitinframe(ecx_portt *port, int idx, int timeout);
 int ecx_srconfirm(ecx_portt *port, int idx,int timeout);
+int ecx_queueframe_red(ecx_portt *port, int idx);
+int ecx_flushframes(ecx_portt *port);
+int ecx_waitinframes(ecx_portt *port, const uint8 *idx, int cnt, int timeout);
+int ecx_settxdirect(ecx_portt *port, int idx, void *data, int length);
+int ecx_setrxdirect(ecx_portt *port, int idx, int offset, void *data, int length);
+int ecx_setwaitmode(ecx_portt *port, int waitmode, int waittime);
+void ecx_clearwaitstat(ecx_portt *port);
+int ecx_getframetimes(ecx_portt *port, int idx, int64 *txtime, int64 *rxtime);
+int64 ecx_getcyclertt(ecx_portt *port);
 
 #ifdef __cplusplus
 }
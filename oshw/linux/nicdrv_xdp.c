@@ -0,0 +1,465 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * EtherCAT AF_XDP socket backend, used by nicdrv.c when
+ * ecx_portt.nicmode = ECT_NIC_XDP.
+ *
+ * A small XDP program is loaded on the NIC that redirects every EtherCAT
+ * frame (ethertype 0x88A4) arriving on the selected RX queue to an AF_XDP
+ * socket, all other traffic continues to the kernel stack. Frames live in a
+ * UMEM area shared with the driver. The socket is bound in zero-copy mode
+ * when the driver supports it and in copy mode otherwise. The program is
+ * attached in native driver mode if possible, else in generic (SKB) mode.
+ *
+ * The core addresses txbuf/rxbuf as fixed arrays in ecx_portt, so UMEM is
+ * used as staging memory: a frame is copied once into UMEM for transmit and
+ * once from UMEM into rxbuf on receive. Process data with a zero copy target
+ * is gathered from and copied to the IOmap instead. No frame passes the
+ * kernel network stack.
+ *
+ * Requirements: Linux 5.9 or newer (bpf link for XDP), CAP_NET_ADMIN and
+ * CAP_BPF (or root). EtherCAT frames must arrive on the selected queue, on
+ * multi queue NICs use f.e. "ethtool -L eth0 combined 1".
+ *
+ * Testing without EtherCAT hardware can be done on a veth pair, the program
+ * then runs in generic mode with a copy mode socket:
+ *
+ *   ip link add ecat0 type veth peer name ecat1
+ *   ip link set ecat0 up; ip link set ecat1 up
+ *
+ * and run the master on ecat0 with a slave simulator or loopback on ecat1.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+
+#include "oshw.h"
+#include "osal.h"
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+/** number of XSKMAP entries, covers the queue index range of common NICs */
+#define EC_XDPMAXQUEUES   64
+
+/** bpf() syscall, there is no libc wrapper */
+static int ecx_xdp_bpf(int cmd, union bpf_attr *attr)
+{
+   return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+/** Build one eBPF instruction.
+ * @param[in] code   = opcode
+ * @param[in] dst    = destination register
+ * @param[in] src    = source register
+ * @param[in] off    = offset
+ * @param[in] imm    = immediate value
+ * @return instruction
+ */
+static struct bpf_insn ecx_xdp_insn(uint8 code, uint8 dst, uint8 src, int16 off, int32 imm)
+{
+   struct bpf_insn insn;
+
+   insn.code = code;
+   insn.dst_reg = dst;
+   insn.src_reg = src;
+   insn.off = off;
+   insn.imm = imm;
+   return insn;
+}
+
+/** Load XDP program that redirects EtherCAT frames to the XSKMAP entry of
+ * the receiving queue and passes all other frames.
+ * @param[in] mapfd  = XSKMAP file descriptor
+ * @return program file descriptor or -1
+ */
+static int ecx_xdp_loadprog(int mapfd)
+{
+   struct bpf_insn prog[16];
+   union bpf_attr attr;
+   const char license[] = "GPL";
+   int n = 0;
+
+   /* r6 = ctx */
+   prog[n++] = ecx_xdp_insn(BPF_ALU64 | BPF_MOV | BPF_X, 6, 1, 0, 0);
+   /* r2 = data, r3 = data_end */
+   prog[n++] = ecx_xdp_insn(BPF_LDX | BPF_MEM | BPF_W, 2, 6, offsetof(struct xdp_md, data), 0);
+   prog[n++] = ecx_xdp_insn(BPF_LDX | BPF_MEM | BPF_W, 3, 6, offsetof(struct xdp_md, data_end), 0);
+   /* if data + ethernet header > data_end goto pass */
+   prog[n++] = ecx_xdp_insn(BPF_ALU64 | BPF_MOV | BPF_X, 4, 2, 0, 0);
+   prog[n++] = ecx_xdp_insn(BPF_ALU64 | BPF_ADD | BPF_K, 4, 0, 0, ETH_HEADERSIZE);
+   prog[n++] = ecx_xdp_insn(BPF_JMP | BPF_JGT | BPF_X, 4, 3, 8, 0);
+   /* if ethertype != ETH_P_ECAT goto pass */
+   prog[n++] = ecx_xdp_insn(BPF_LDX | BPF_MEM | BPF_H, 4, 2, 12, 0);
+   prog[n++] = ecx_xdp_insn(BPF_JMP | BPF_JNE | BPF_K, 4, 0, 6, htons(ETH_P_ECAT));
+   /* return bpf_redirect_map(map, ctx->rx_queue_index, XDP_PASS) */
+   prog[n++] = ecx_xdp_insn(BPF_LDX | BPF_MEM | BPF_W, 2, 6, offsetof(struct xdp_md, rx_queue_index), 0);
+   prog[n++] = ecx_xdp_insn(BPF_LD | BPF_DW | BPF_IMM, 1, BPF_PSEUDO_MAP_FD, 0, mapfd);
+   prog[n++] = ecx_xdp_insn(0, 0, 0, 0, 0);
+   prog[n++] = ecx_xdp_insn(BPF_ALU64 | BPF_MOV | BPF_K, 3, 0, 0, XDP_PASS);
+   prog[n++] = ecx_xdp_insn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map);
+   prog[n++] = ecx_xdp_insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+   /* pass: return XDP_PASS */
+   prog[n++] = ecx_xdp_insn(BPF_ALU64 | BPF_MOV | BPF_K, 0, 0, 0, XDP_PASS);
+   prog[n++] = ecx_xdp_insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+   memset(&attr, 0, sizeof(attr));
+   attr.prog_type = BPF_PROG_TYPE_XDP;
+   attr.insn_cnt = n;
+   attr.insns = (uint64)(size_t)prog;
+   attr.license = (uint64)(size_t)license;
+   attr.expected_attach_type = BPF_XDP;
+   return ecx_xdp_bpf(BPF_PROG_LOAD, &attr);
+}
+
+/** Map one XSK ring in memory.
+ * @param[in] ring      = ring to fill in
+ * @param[in] fd        = AF_XDP socket
+ * @param[in] off       = ring offsets from XDP_MMAP_OFFSETS
+ * @param[in] entsize   = size of one ring entry
+ * @param[in] pgoff     = mmap offset selecting the ring
+ * @return >0 if succeeded
+ */
+static int ecx_xdp_mapring(ec_xskringT *ring, int fd, struct xdp_ring_offset *off,
+                           size_t entsize, off_t pgoff)
+{
+   uint8 *map;
+
+   ring->mapsize = off->desc + EC_XDPRINGSIZE * entsize;
+   map = mmap(NULL, ring->mapsize, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE, fd, pgoff);
+   if (map == MAP_FAILED)
+   {
+      ring->map = NULL;
+      return 0;
+   }
+   ring->map = map;
+   ring->producer = (uint32 *)(map + off->producer);
+   ring->consumer = (uint32 *)(map + off->consumer);
+   ring->flags = (uint32 *)(map + off->flags);
+   ring->desc = map + off->desc;
+   return 1;
+}
+
+/** Setup AF_XDP socket with UMEM and XDP redirect program on NIC.
+ * @param[in] xdp       = XDP state
+ * @param[in] ifindex   = interface index of NIC
+ * @param[in] queue     = RX/TX queue of NIC to bind to
+ * @return >0 if succeeded
+ */
+int ecx_xdp_setup(ec_xdpT *xdp, int ifindex, int queue)
+{
+   struct xdp_umem_reg mr;
+   struct xdp_mmap_offsets off;
+   struct sockaddr_xdp sxdp;
+   union bpf_attr attr;
+   socklen_t optlen;
+   uint64 *fill;
+   uint32 key, val;
+   int i, ringsize;
+
+   memset(xdp, 0, sizeof(*xdp));
+   xdp->fd = -1;
+   xdp->progfd = -1;
+   xdp->mapfd = -1;
+   xdp->linkfd = -1;
+
+   xdp->fd = socket(AF_XDP, SOCK_RAW, 0);
+   if (xdp->fd < 0)
+   {
+      goto fail;
+   }
+   /* UMEM, RX frames first, TX frames second */
+   xdp->umemsize = EC_XDPFRAMES * EC_XDPFRAMESIZE;
+   xdp->umem = mmap(NULL, xdp->umemsize, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+   if (xdp->umem == MAP_FAILED)
+   {
+      xdp->umem = NULL;
+      goto fail;
+   }
+   memset(&mr, 0, sizeof(mr));
+   mr.addr = (uint64)(size_t)xdp->umem;
+   mr.len = xdp->umemsize;
+   mr.chunk_size = EC_XDPFRAMESIZE;
+   if (setsockopt(xdp->fd, SOL_XDP, XDP_UMEM_REG, &mr, sizeof(mr)) < 0)
+   {
+      goto fail;
+   }
+   ringsize = EC_XDPRINGSIZE;
+   if ((setsockopt(xdp->fd, SOL_XDP, XDP_UMEM_FILL_RING, &ringsize, sizeof(ringsize)) < 0) ||
+       (setsockopt(xdp->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ringsize, sizeof(ringsize)) < 0) ||
+       (setsockopt(xdp->fd, SOL_XDP, XDP_RX_RING, &ringsize, sizeof(ringsize)) < 0) ||
+       (setsockopt(xdp->fd, SOL_XDP, XDP_TX_RING, &ringsize, sizeof(ringsize)) < 0))
+   {
+      goto fail;
+   }
+   optlen = sizeof(off);
+   if (getsockopt(xdp->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0)
+   {
+      goto fail;
+   }
+   if (!ecx_xdp_mapring(&xdp->fill, xdp->fd, &off.fr, sizeof(uint64), XDP_UMEM_PGOFF_FILL_RING) ||
+       !ecx_xdp_mapring(&xdp->comp, xdp->fd, &off.cr, sizeof(uint64), XDP_UMEM_PGOFF_COMPLETION_RING) ||
+       !ecx_xdp_mapring(&xdp->rx, xdp->fd, &off.rx, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) ||
+       !ecx_xdp_mapring(&xdp->tx, xdp->fd, &off.tx, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING))
+   {
+      goto fail;
+   }
+   /* hand all RX frames to the kernel */
+   fill = xdp->fill.desc;
+   for (i = 0; i < EC_XDPRINGSIZE; i++)
+   {
+      fill[i] = (uint64)i * EC_XDPFRAMESIZE;
+   }
+   __sync_synchronize();
+   *xdp->fill.producer = EC_XDPRINGSIZE;
+   for (i = 0; i < EC_XDPRINGSIZE; i++)
+   {
+      xdp->txfree[i] = (uint64)(EC_XDPRINGSIZE + i) * EC_XDPFRAMESIZE;
+   }
+   xdp->txfreecnt = EC_XDPRINGSIZE;
+   /* bind, zero-copy if the driver supports it */
+   memset(&sxdp, 0, sizeof(sxdp));
+   sxdp.sxdp_family = AF_XDP;
+   sxdp.sxdp_ifindex = ifindex;
+   sxdp.sxdp_queue_id = queue;
+   sxdp.sxdp_flags = XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP;
+   xdp->zerocopy = 1;
+   if (bind(xdp->fd, (struct sockaddr *)&sxdp, sizeof(sxdp)) < 0)
+   {
+      sxdp.sxdp_flags = XDP_COPY | XDP_USE_NEED_WAKEUP;
+      xdp->zerocopy = 0;
+      if (bind(xdp->fd, (struct sockaddr *)&sxdp, sizeof(sxdp)) < 0)
+      {
+         goto fail;
+      }
+   }
+   /* XSKMAP with socket at queue index */
+   memset(&attr, 0, sizeof(attr));
+   attr.map_type = BPF_MAP_TYPE_XSKMAP;
+   attr.key_size = sizeof(uint32);
+   attr.value_size = sizeof(uint32);
+   attr.max_entries = EC_XDPMAXQUEUES;
+   xdp->mapfd = ecx_xdp_bpf(BPF_MAP_CREATE, &attr);
+   if (xdp->mapfd < 0)
+   {
+      goto fail;
+   }
+   key = queue;
+   val = xdp->fd;
+   memset(&attr, 0, sizeof(attr));
+   attr.map_fd = xdp->mapfd;
+   attr.key = (uint64)(size_t)&key;
+   attr.value = (uint64)(size_t)&val;
+   attr.flags = BPF_ANY;
+   if (ecx_xdp_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0)
+   {
+      goto fail;
+   }
+   xdp->progfd = ecx_xdp_loadprog(xdp->mapfd);
+   if (xdp->progfd < 0)
+   {
+      goto fail;
+   }
+   /* attach in native driver mode, else in generic mode */
+   memset(&attr, 0, sizeof(attr));
+   attr.link_create.prog_fd = xdp->progfd;
+   attr.link_create.target_ifindex = ifindex;
+   attr.link_create.attach_type = BPF_XDP;
+   attr.link_create.flags = XDP_FLAGS_DRV_MODE;
+   xdp->native = 1;
+   xdp->linkfd = ecx_xdp_bpf(BPF_LINK_CREATE, &attr);
+   if (xdp->linkfd < 0)
+   {
+      attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+      xdp->native = 0;
+      xdp->linkfd = ecx_xdp_bpf(BPF_LINK_CREATE, &attr);
+   }
+   if (xdp->linkfd < 0)
+   {
+      goto fail;
+   }
+
+   return 1;
+
+fail:
+   ecx_xdp_close(xdp);
+   return 0;
+}
+
+/** Detach XDP program and release socket, rings and UMEM.
+ * @param[in] xdp       = XDP state
+ */
+void ecx_xdp_close(ec_xdpT *xdp)
+{
+   ec_xskringT *rings[4];
+   int i;
+
+   /* closing the link detaches the program from the NIC */
+   if (xdp->linkfd >= 0) close(xdp->linkfd);
+   if (xdp->progfd >= 0) close(xdp->progfd);
+   if (xdp->mapfd >= 0) close(xdp->mapfd);
+   rings[0] = &xdp->fill;
+   rings[1] = &xdp->comp;
+   rings[2] = &xdp->rx;
+   rings[3] = &xdp->tx;
+   for (i = 0; i < 4; i++)
+   {
+      if (rings[i]->map)
+      {
+         munmap(rings[i]->map, rings[i]->mapsize);
+      }
+   }
+   if (xdp->fd >= 0) close(xdp->fd);
+   if (xdp->umem)
+   {
+      munmap(xdp->umem, xdp->umemsize);
+   }
+   memset(xdp, 0, sizeof(*xdp));
+   xdp->fd = -1;
+   xdp->progfd = -1;
+   xdp->mapfd = -1;
+   xdp->linkfd = -1;
+}
+
+/** Copy frame into a free UMEM frame and put it on the TX ring.
+ * Caller must serialise calls for the same socket.
+ * @param[in] xdp       = XDP state
+ * @param[in] iov       = parts of frame incl. ethernet header
+ * @param[in] iovcnt    = number of parts
+ * @param[in] kick      = wake up kernel to transmit, else leave frame queued
+ * @return number of bytes queued or -1
+ */
+int ecx_xdp_send(ec_xdpT *xdp, const struct iovec *iov, int iovcnt, int kick)
+{
+   uint32 cons, prod;
+   uint64 *comp;
+   struct xdp_desc *desc;
+   uint8 *dst;
+   int i, len;
+
+   /* reclaim frames the kernel has finished sending */
+   comp = xdp->comp.desc;
+   cons = *xdp->comp.consumer;
+   prod = *xdp->comp.producer;
+   __sync_synchronize();
+   while ((cons != prod) && (xdp->txfreecnt < EC_XDPRINGSIZE))
+   {
+      xdp->txfree[xdp->txfreecnt++] = comp[cons & (EC_XDPRINGSIZE - 1)];
+      cons++;
+   }
+   __sync_synchronize();
+   *xdp->comp.consumer = cons;
+   len = 0;
+   for (i = 0; i < iovcnt; i++)
+   {
+      len += iov[i].iov_len;
+   }
+   if ((xdp->txfreecnt == 0) || (len > EC_XDPFRAMESIZE))
+   {
+      sendto(xdp->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+      return -1;
+   }
+   prod = *xdp->tx.producer;
+   desc = (struct xdp_desc *)xdp->tx.desc + (prod & (EC_XDPRINGSIZE - 1));
+   desc->addr = xdp->txfree[--xdp->txfreecnt];
+   desc->len = len;
+   desc->options = 0;
+   dst = xdp->umem + desc->addr;
+   for (i = 0; i < iovcnt; i++)
+   {
+      memcpy(dst, iov[i].iov_base, iov[i].iov_len);
+      dst += iov[i].iov_len;
+   }
+   __sync_synchronize();
+   *xdp->tx.producer = prod + 1;
+   if (kick)
+   {
+      ecx_xdp_kick(xdp);
+   }
+
+   return len;
+}
+
+/** Wake up kernel to transmit frames on the TX ring, if it needs it.
+ * @param[in] xdp       = XDP state
+ */
+void ecx_xdp_kick(ec_xdpT *xdp)
+{
+   __sync_synchronize();
+   if (*xdp->tx.flags & XDP_RING_NEED_WAKEUP)
+   {
+      sendto(xdp->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+   }
+}
+
+/** Non blocking check of RX ring. The frame stays owned by the caller until
+ * ecx_xdp_release() is called.
+ * @param[in] xdp       = XDP state
+ * @param[out] frame    = received frame incl. ethernet header
+ * @return frame length, 0 if no frame available
+ */
+int ecx_xdp_recv(ec_xdpT *xdp, uint8 **frame)
+{
+   uint32 cons, prod;
+   struct xdp_desc *desc;
+
+   cons = *xdp->rx.consumer;
+   prod = *xdp->rx.producer;
+   __sync_synchronize();
+   if (cons == prod)
+   {
+      if (*xdp->fill.flags & XDP_RING_NEED_WAKEUP)
+      {
+         recvfrom(xdp->fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+      }
+      return 0;
+   }
+   desc = (struct xdp_desc *)xdp->rx.desc + (cons & (EC_XDPRINGSIZE - 1));
+   *frame = xdp->umem + desc->addr;
+   xdp->rxheld = 1;
+
+   return desc->len;
+}
+
+/** Return held RX frame to the fill ring.
+ * @param[in] xdp       = XDP state
+ */
+void ecx_xdp_release(ec_xdpT *xdp)
+{
+   uint32 cons, prod;
+   struct xdp_desc *desc;
+   uint64 *fill;
+
+   if (!xdp->rxheld)
+   {
+      return;
+   }
+   cons = *xdp->rx.consumer;
+   desc = (struct xdp_desc *)xdp->rx.desc + (cons & (EC_XDPRINGSIZE - 1));
+   fill = xdp->fill.desc;
+   prod = *xdp->fill.producer;
+   /* headroom is part of addr, hand back the frame start */
+   fill[prod & (EC_XDPRINGSIZE - 1)] = desc->addr - (desc->addr % EC_XDPFRAMESIZE);
+   __sync_synchronize();
+   *xdp->rx.consumer = cons + 1;
+   *xdp->fill.producer = prod + 1;
+   xdp->rxheld = 0;
+}
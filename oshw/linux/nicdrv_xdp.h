@@ -0,0 +1,82 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Headerfile for nicdrv_xdp.c
+ */
+
+#ifndef _nicdrv_xdph_
+#define _nicdrv_xdph_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+/** number of UMEM frames, first half used for RX, second half for TX */
+#define EC_XDPFRAMES      64
+/** size of one UMEM frame */
+#define EC_XDPFRAMESIZE   2048
+/** number of entries in each XSK ring */
+#define EC_XDPRINGSIZE    (EC_XDPFRAMES / 2)
+
+/** user space view of one XSK ring */
+typedef struct
+{
+   uint32      *producer;
+   uint32      *consumer;
+   uint32      *flags;
+   /** ring entries, struct xdp_desc for RX/TX, uint64 for fill/completion */
+   void        *desc;
+   /** mapped memory of ring */
+   void        *map;
+   size_t      mapsize;
+} ec_xskringT;
+
+/** AF_XDP socket state for one NIC, umem == NULL when not in use */
+typedef struct
+{
+   /** AF_XDP socket */
+   int         fd;
+   /** XDP program redirecting EtherCAT frames to the socket */
+   int         progfd;
+   /** XSKMAP used by the program */
+   int         mapfd;
+   /** bpf link of program to NIC, closing it detaches the program */
+   int         linkfd;
+   /** UMEM area holding all frames */
+   uint8       *umem;
+   size_t      umemsize;
+   ec_xskringT fill;
+   ec_xskringT comp;
+   ec_xskringT rx;
+   ec_xskringT tx;
+   /** free TX frame addresses in UMEM */
+   uint64      txfree[EC_XDPRINGSIZE];
+   int         txfreecnt;
+   /** 1 if an RX descriptor is held by the caller */
+   int         rxheld;
+   /** 1 if bound in zero-copy mode, 0 for copy mode */
+   int         zerocopy;
+   /** 1 if program runs in driver (native) mode, 0 for generic SKB mode */
+   int         native;
+} ec_xdpT;
+
+int ecx_xdp_setup(ec_xdpT *xdp, int ifindex, int queue);
+void ecx_xdp_close(ec_xdpT *xdp);
+int ecx_xdp_send(ec_xdpT *xdp, const struct iovec *iov, int iovcnt, int kick);
+void ecx_xdp_kick(ec_xdpT *xdp);
+int ecx_xdp_recv(ec_xdpT *xdp, uint8 **frame);
+void ecx_xdp_release(ec_xdpT *xdp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
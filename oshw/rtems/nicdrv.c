@@ -648,6 +648,80 @@ int ecx_srconfirm(ecx_portt *port, int idx, int timeout)
    return wkc;
 }
 
+/** Queue frame for transmission by ecx_flushframes(). This driver has no
+ * batched transmit, the frame is sent at once.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index in tx buffer array
+ * @return socket send result
+ */
+int ecx_queueframe_red(ecx_portt *port, int idx)
+{
+   return ecx_outframe_red(port, idx);
+}
+
+/** Transmit queued frames. Nothing to do, frames are sent when queued.
+ * @param[in] port        = port context struct
+ * @return 0
+ */
+int ecx_flushframes(ecx_portt *port)
+{
+   (void)port;
+   return 0;
+}
+
+/** Wait for several frames at once. Not supported by this driver, the caller
+ * waits for each frame with ecx_waitinframe().
+ * @param[in] port        = port context struct
+ * @param[in] idx         = indexes of frames to wait for
+ * @param[in] cnt         = number of indexes
+ * @param[in] timeout     = timeout in us
+ * @return -1
+ */
+int ecx_waitinframes(ecx_portt *port, const uint8 *idx, int cnt, int timeout)
+{
+   (void)port;
+   (void)idx;
+   (void)cnt;
+   (void)timeout;
+   return -1;
+}
+
+/** Set zero copy transmit source of a frame. Not supported by this driver,
+ * the caller copies the data into the tx buffer.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index of frame
+ * @param[in] data        = source
+ * @param[in] length      = number of bytes sent from source
+ * @return 0
+ */
+int ecx_settxdirect(ecx_portt *port, int idx, void *data, int length)
+{
+   (void)port;
+   (void)idx;
+   (void)data;
+   (void)length;
+   return 0;
+}
+
+/** Set zero copy receive target of a frame. Not supported by this driver,
+ * the caller copies the data from the rx buffer.
+ * @param[in] port        = port context struct
+ * @param[in] idx         = index of frame
+ * @param[in] offset      = offset in first datagram data
+ * @param[in] data        = target
+ * @param[in] length      = number of bytes placed in target
+ * @return 0
+ */
+int ecx_setrxdirect(ecx_portt *port, int idx, int offset, void *data, int length)
+{
+   (void)port;
+   (void)idx;
+   (void)offset;
+   (void)data;
+   (void)length;
+   return 0;
+}
+
 #ifdef EC_VER1
 int ec_setupnic(const char *ifname, int secondary)
 {
@@ -693,4 +767,29 @@ int ec_srconfirm(int idx, int timeout)
 {
    return ecx_srconfirm(&ecx_port, idx, timeout);
 }
+
+int ec_queueframe_red(int idx)
+{
+   return ecx_queueframe_red(&ecx_port, idx);
+}
+
+int ec_flushframes(void)
+{
+   return ecx_flushframes(&ecx_port);
+}
+
+int ec_waitinframes(const uint8 *idx, int cnt, int timeout)
+{
+   return ecx_waitinframes(&ecx_port, idx, cnt, timeout);
+}
+
+int ec_settxdirect(int idx, void *data, int length)
+{
+   return ecx_settxdirect(&ecx_port, idx, data, length);
+}
+
+int ec_setrxdirect(int idx, int offset, void *data, int length)
+{
+   return ecx_setrxdirect(&ecx_port, idx, offset, data, length);
+}
 #endif
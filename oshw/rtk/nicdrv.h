@@ -94,6 +94,11 @@ int ec_outframe(int idx, int stacknumber);
 int ec_outframe_red(int idx);
 int ec_waitinframe(int idx, int timeout);
 int ec_srconfirm(int idx,int timeout);
+int ec_queueframe_red(int idx);
+int ec_flushframes(void);
+int ec_waitinframes(const uint8 *idx, int cnt, int timeout);
+int ec_settxdirect(int idx, void *data, int length);
+int ec_setrxdirect(int idx, int offset, void *data, int length);
 #endif
 
 void ec_setupheader(void *p);
@@ -105,5 +110,10 @@ int ecx_outframe(ecx_portt *port, int idx, int stacknumber);
 int ecx_outframe_red(ecx_portt *port, int idx);
 int ecx_waitinframe(ecx_portt *port, int idx, int timeout);
 int ecx_srconfirm(ecx_portt *port, int idx,int timeout);
+int ecx_queueframe_red(ecx_portt *port, int idx);
+int ecx_flushframes(ecx_portt *port);
+int ecx_waitinframes(ecx_portt *port, const uint8 *idx, int cnt, int timeout);
+int ecx_settxdirect(ecx_portt *port, int idx, void *data, int length);
+int ecx_setrxdirect(ecx_portt *port, int idx, int offset, void *data, int length);
 
 #endif
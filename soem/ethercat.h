@@ -16,10 +16,12 @@
 #include "ethercatbase.h"
 #include "ethercatmain.h"
 #include "ethercatdc.h"
+#include "ethercatcyclic.h"
 #include "ethercatcoe.h"
 #include "ethercatfoe.h"
 #include "ethercatsoe.h"
 #include "ethercateoe.h"
+#include "ethercatasync.h"
 #include "ethercatconfig.h"
 #include "ethercatprint.h"
 
@@ -0,0 +1,401 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Asynchronous mailbox service.
+ *
+ * The application submits CoE, FoE, SoE and EoE requests and continues, the
+ * service executes them in worker threads and reports completion by callback
+ * or through ecx_async_done() / ecx_async_wait(). A slave has at most one
+ * request active so its mailbox sequence is kept, requests to different slaves
+ * run in parallel on the available workers.
+ */
+#include <string.h>
+#include "oshw.h"
+#include "osal.h"
+#include "ethercattype.h"
+#include "ethercatbase.h"
+#include "ethercatmain.h"
+#include "ethercatcoe.h"
+#include "ethercatfoe.h"
+#include "ethercatsoe.h"
+#include "ethercateoe.h"
+#include "ethercatasync.h"
+
+/** Take first queued request of a slave that has no active request.
+ * Called with the service locked.
+ *
+ * @param[in] svc = mailbox service
+ * @return request or NULL if none is ready
+ */
+static ec_asyncreqt *ecx_async_next(ec_asynct *svc)
+{
+   ec_asyncreqt *req, *prev;
+
+   prev = NULL;
+   for (req = svc->head; req; req = req->next)
+   {
+      if (!svc->busy[req->slave])
+      {
+         if (prev)
+         {
+            prev->next = req->next;
+         }
+         else
+         {
+            svc->head = req->next;
+         }
+         if (svc->tail == req)
+         {
+            svc->tail = prev;
+         }
+         req->next = NULL;
+         req->state = ECT_ASYNC_ACTIVE;
+         svc->busy[req->slave] = 1;
+         return req;
+      }
+      prev = req;
+   }
+   return NULL;
+}
+
+/** Wake all threads blocked on the done semaphore. Called with the service
+ * locked. A waiter that timed out may still be counted, its token only causes
+ * one extra check of the next waiter.
+ *
+ * @param[in] svc = mailbox service
+ */
+static void ecx_async_notify(ec_asynct *svc)
+{
+   while (svc->waiters > 0)
+   {
+      svc->waiters--;
+      osal_sem_post(svc->done);
+   }
+}
+
+/** Execute request with the blocking mailbox function of its type.
+ *
+ * @param[in] context = context struct
+ * @param[in] req     = request
+ * @return result of mailbox function
+ */
+static int ecx_async_exec(ecx_contextt *context, ec_asyncreqt *req)
+{
+   switch (req->type)
+   {
+      case ECT_ASYNC_SDOREAD:
+         return ecx_SDOread(context, req->slave, req->index, req->subindex, req->CA,
+                            &req->size, req->data, req->timeout);
+      case ECT_ASYNC_SDOWRITE:
+         return ecx_SDOwrite(context, req->slave, req->index, req->subindex, req->CA,
+                             req->size, req->data, req->timeout);
+      case ECT_ASYNC_FOEREAD:
+         return ecx_FOEread(context, req->slave, req->filename, req->password,
+                            &req->size, req->data, req->timeout);
+      case ECT_ASYNC_FOEWRITE:
+         return ecx_FOEwrite(context, req->slave, req->filename, req->password,
+                             req->size, req->data, req->timeout);
+      case ECT_ASYNC_SOEREAD:
+         return ecx_SoEread(context, req->slave, req->driveNo, req->elementflags, req->idn,
+                            &req->size, req->data, req->timeout);
+      case ECT_ASYNC_SOEWRITE:
+         return ecx_SoEwrite(context, req->slave, req->driveNo, req->elementflags, req->idn,
+                             req->size, req->data, req->timeout);
+      case ECT_ASYNC_EOESEND:
+         return ecx_EOEsend(context, req->slave, req->port, req->size, req->data, req->timeout);
+      case ECT_ASYNC_EOERECV:
+         return ecx_EOErecv(context, req->slave, req->port, &req->size, req->data, req->timeout);
+      default:
+         return EC_ERROR;
+   }
+}
+
+/** Call callback of request and mark it done. The callback runs before the
+ * request is done, so a caller of ecx_async_wait() or ecx_async_done() can
+ * not reuse or free it while the callback still uses it.
+ *
+ * @param[in] svc     = mailbox service
+ * @param[in] req     = request
+ * @param[in] result  = result of request
+ */
+static void ecx_async_complete(ec_asynct *svc, ec_asyncreqt *req, int result)
+{
+   osal_mtx_lock(svc->mtx);
+   req->result = result;
+   osal_mtx_unlock(svc->mtx);
+   if (req->callback)
+   {
+      req->callback(req);
+   }
+   osal_mtx_lock(svc->mtx);
+   req->state = ECT_ASYNC_DONE;
+   ecx_async_notify(svc);
+   osal_mtx_unlock(svc->mtx);
+}
+
+static OSAL_THREAD_FUNC ecx_async_worker(void *param)
+{
+   ec_asynct *svc;
+   ec_asyncreqt *req;
+   uint16 slave;
+   int result;
+   boolean run;
+
+   svc = param;
+   do
+   {
+      osal_sem_wait(svc->work);
+      /* a finished request may free its slave for the next one queued, so
+       * keep serving until nothing is ready */
+      osal_mtx_lock(svc->mtx);
+      while (svc->run && ((req = ecx_async_next(svc)) != NULL))
+      {
+         osal_mtx_unlock(svc->mtx);
+         slave = req->slave;
+         result = ecx_async_exec(svc->context, req);
+         osal_mtx_lock(svc->mtx);
+         svc->busy[slave] = 0;
+         osal_mtx_unlock(svc->mtx);
+         ecx_async_complete(svc, req, result);
+         osal_mtx_lock(svc->mtx);
+      }
+      run = svc->run;
+      osal_mtx_unlock(svc->mtx);
+   } while (run);
+   osal_mtx_lock(svc->mtx);
+   svc->running--;
+   ecx_async_notify(svc);
+   osal_mtx_unlock(svc->mtx);
+}
+
+/** Destroy the locks of the service.
+ *
+ * @param[in] svc = mailbox service
+ */
+static void ecx_async_release(ec_asynct *svc)
+{
+   if (svc->done)
+   {
+      osal_sem_destroy(svc->done);
+      svc->done = NULL;
+   }
+   if (svc->work)
+   {
+      osal_sem_destroy(svc->work);
+      svc->work = NULL;
+   }
+   if (svc->mtx)
+   {
+      osal_mtx_destroy(svc->mtx);
+      svc->mtx = NULL;
+   }
+}
+
+/** Start asynchronous mailbox service.
+ *
+ * @param[out] svc     = mailbox service
+ * @param[in]  context = context struct
+ * @param[out] busy    = busy flag table with context->maxslave entries
+ * @param[in]  workers = number of worker threads, 1 to EC_ASYNC_MAXWORKERS.
+ * More workers let more slaves be served at the same time.
+ * @return number of started workers, 0 on failure
+ */
+int ecx_async_start(ec_asynct *svc, ecx_contextt *context, uint8 *busy, int workers)
+{
+   int i;
+
+   memset(svc, 0, sizeof(*svc));
+   if (!busy)
+   {
+      return 0;
+   }
+   memset(busy, 0, sizeof(uint8) * context->maxslave);
+   svc->busy = busy;
+   if (workers < 1)
+   {
+      workers = 1;
+   }
+   if (workers > EC_ASYNC_MAXWORKERS)
+   {
+      workers = EC_ASYNC_MAXWORKERS;
+   }
+   svc->mtx = osal_mtx_create();
+   svc->work = osal_sem_create(0);
+   svc->done = osal_sem_create(0);
+   if (!svc->mtx || !svc->work || !svc->done)
+   {
+      ecx_async_release(svc);
+      return 0;
+   }
+   svc->context = context;
+   svc->run = TRUE;
+   for (i = 0; i < workers; i++)
+   {
+      osal_mtx_lock(svc->mtx);
+      svc->running++;
+      osal_mtx_unlock(svc->mtx);
+      if (!osal_thread_create(&(svc->thread[i]), 128000, &ecx_async_worker, svc))
+      {
+         osal_mtx_lock(svc->mtx);
+         svc->running--;
+         osal_mtx_unlock(svc->mtx);
+         break;
+      }
+   }
+   svc->workers = i;
+   if (!i)
+   {
+      svc->run = FALSE;
+      ecx_async_release(svc);
+   }
+
+   return i;
+}
+
+/** Stop asynchronous mailbox service. Waits for active requests to finish,
+ * requests still queued complete with result EC_ERROR. No thread may be in
+ * ecx_async_wait() when the service is released.
+ *
+ * @param[in] svc = mailbox service
+ */
+void ecx_async_stop(ec_asynct *svc)
+{
+   ec_asyncreqt *req, *next;
+   int i;
+
+   if (!svc->mtx)
+   {
+      return;
+   }
+   osal_mtx_lock(svc->mtx);
+   svc->run = FALSE;
+   osal_mtx_unlock(svc->mtx);
+   for (i = 0; i < svc->workers; i++)
+   {
+      osal_sem_post(svc->work);
+   }
+   osal_mtx_lock(svc->mtx);
+   while (svc->running)
+   {
+      svc->waiters++;
+      osal_mtx_unlock(svc->mtx);
+      osal_sem_wait(svc->done);
+      osal_mtx_lock(svc->mtx);
+   }
+   /* take the queue, callbacks run without the lock */
+   req = svc->head;
+   svc->head = NULL;
+   svc->tail = NULL;
+   osal_mtx_unlock(svc->mtx);
+   while (req)
+   {
+      next = req->next;
+      req->next = NULL;
+      ecx_async_complete(svc, req, EC_ERROR);
+      req = next;
+   }
+   ecx_async_release(svc);
+}
+
+/** Queue mailbox request. The request fields must be set by the caller and
+ * the request must not be modified until it is done.
+ *
+ * @param[in] svc = mailbox service
+ * @param[in] req = request
+ * @return 1 if queued, 0 if the service is not running or the request is in use
+ */
+int ecx_async_submit(ec_asynct *svc, ec_asyncreqt *req)
+{
+   int rval = 0;
+
+   if (!svc->mtx || (req->slave >= svc->context->maxslave))
+   {
+      return 0;
+   }
+   osal_mtx_lock(svc->mtx);
+   if (svc->run && (req->state != ECT_ASYNC_QUEUED) && (req->state != ECT_ASYNC_ACTIVE))
+   {
+      req->next = NULL;
+      req->result = 0;
+      req->state = ECT_ASYNC_QUEUED;
+      if (svc->tail)
+      {
+         svc->tail->next = req;
+      }
+      else
+      {
+         svc->head = req;
+      }
+      svc->tail = req;
+      rval = 1;
+   }
+   osal_mtx_unlock(svc->mtx);
+   if (rval)
+   {
+      osal_sem_post(svc->work);
+   }
+
+   return rval;
+}
+
+/** Check if request is done.
+ *
+ * @param[in] svc = mailbox service
+ * @param[in] req = request
+ * @return TRUE if done, req->result then holds the result
+ */
+boolean ecx_async_done(ec_asynct *svc, ec_asyncreqt *req)
+{
+   boolean done;
+
+   osal_mtx_lock(svc->mtx);
+   done = (req->state == ECT_ASYNC_DONE);
+   osal_mtx_unlock(svc->mtx);
+
+   return done;
+}
+
+/** Wait for request to be done.
+ *
+ * @param[in] svc     = mailbox service
+ * @param[in] req     = request
+ * @param[in] timeout = timeout in us
+ * @return result of request, EC_TIMEOUT if not done within timeout
+ */
+int ecx_async_wait(ec_asynct *svc, ec_asyncreqt *req, int timeout)
+{
+   osal_timert timer;
+   int64 left;
+   int result;
+
+   osal_timer_start(&timer, timeout);
+   osal_mtx_lock(svc->mtx);
+   while (req->state != ECT_ASYNC_DONE)
+   {
+      left = osal_timer_left_ns(&timer, osal_current_time_ns());
+      if (left <= 0)
+      {
+         osal_mtx_unlock(svc->mtx);
+         return EC_TIMEOUT;
+      }
+      svc->waiters++;
+      osal_mtx_unlock(svc->mtx);
+      osal_sem_timedwait(svc->done, (uint32)((left + 999) / 1000));
+      osal_mtx_lock(svc->mtx);
+   }
+   result = req->result;
+   osal_mtx_unlock(svc->mtx);
+
+   return result;
+}
+
+#ifdef EC_VER1
+int ec_async_start(ec_asynct *svc, uint8 *busy, int workers)
+{
+   return ecx_async_start(svc, &ecx_context, busy, workers);
+}
+#endif
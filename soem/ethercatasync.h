@@ -0,0 +1,129 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Headerfile for ethercatasync.c
+ */
+
+#ifndef _EC_ECATASYNC_H
+#define _EC_ECATASYNC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** max number of mailbox workers, each serves one slave at a time */
+#ifndef EC_ASYNC_MAXWORKERS
+#define EC_ASYNC_MAXWORKERS   4
+#endif
+
+/** Asynchronous mailbox request types */
+enum
+{
+   ECT_ASYNC_SDOREAD,
+   ECT_ASYNC_SDOWRITE,
+   ECT_ASYNC_FOEREAD,
+   ECT_ASYNC_FOEWRITE,
+   ECT_ASYNC_SOEREAD,
+   ECT_ASYNC_SOEWRITE,
+   ECT_ASYNC_EOESEND,
+   ECT_ASYNC_EOERECV
+};
+
+/** Asynchronous mailbox request states */
+enum
+{
+   ECT_ASYNC_IDLE,
+   ECT_ASYNC_QUEUED,
+   ECT_ASYNC_ACTIVE,
+   ECT_ASYNC_DONE
+};
+
+typedef struct ec_asyncreq ec_asyncreqt;
+
+/** Completion callback, called from the worker thread with req->result set.
+ * The request is done when the callback returns, it must not be submitted
+ * again from the callback.
+ */
+typedef void (*ec_asynccbt)(ec_asyncreqt *req);
+
+/** Asynchronous mailbox request. Owned by the caller and must stay valid
+ * until it is done. Fields not used by the request type are ignored.
+ */
+struct ec_asyncreq
+{
+   /** ECT_ASYNC_SDOREAD etc. */
+   int            type;
+   uint16         slave;
+   /** CoE object index and subindex */
+   uint16         index;
+   uint8          subindex;
+   /** CoE complete access */
+   boolean        CA;
+   /** SoE drive number, element flags and IDN */
+   uint8          driveNo;
+   uint8          elementflags;
+   uint16         idn;
+   /** FoE file name and password */
+   char           *filename;
+   uint32         password;
+   /** EoE port */
+   uint8          port;
+   /** data size in bytes, for reads buffer size in and received size out */
+   int            size;
+   void           *data;
+   /** timeout in us passed to the mailbox function */
+   int            timeout;
+   /** completion callback or NULL */
+   ec_asynccbt    callback;
+   /** user argument for callback */
+   void           *arg;
+   /** result of the mailbox function, workcounter or error */
+   int            result;
+   /** ECT_ASYNC_IDLE, ECT_ASYNC_QUEUED, ECT_ASYNC_ACTIVE or ECT_ASYNC_DONE */
+   volatile int   state;
+   ec_asyncreqt   *next;
+};
+
+/** Asynchronous mailbox service */
+typedef struct
+{
+   ecx_contextt   *context;
+   osal_mutex_t   *mtx;
+   /** queued requests in submit order */
+   ec_asyncreqt   *head;
+   ec_asyncreqt   *tail;
+   /** posted per submitted request, workers block on it when idle */
+   osal_sem_t     *work;
+   /** posted per waiter when a request is done or a worker exits */
+   osal_sem_t     *done;
+   /** number of threads blocked on done */
+   int            waiters;
+   /** 1 if a request of the slave is active, table set by ecx_async_start() */
+   uint8          *busy;
+   OSAL_THREAD_HANDLE thread[EC_ASYNC_MAXWORKERS];
+   int            workers;
+   /** number of running workers */
+   volatile int   running;
+   volatile boolean run;
+} ec_asynct;
+
+#ifdef EC_VER1
+int ec_async_start(ec_asynct *svc, uint8 *busy, int workers);
+#endif
+
+int ecx_async_start(ec_asynct *svc, ecx_contextt *context, uint8 *busy, int workers);
+void ecx_async_stop(ec_asynct *svc);
+int ecx_async_submit(ec_asynct *svc, ec_asyncreqt *req);
+boolean ecx_async_done(ec_asynct *svc, ec_asyncreqt *req);
+int ecx_async_wait(ec_asynct *svc, ec_asyncreqt *req, int timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EC_ECATASYNC_H */
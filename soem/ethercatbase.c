@@ -26,7 +26,8 @@
  * @param[out] datagramdata   = data part of datagram
  * @param[in]  com            = command
  * @param[in]  length         = length of databuffer
- * @param[in]  data           = databuffer to be copied into datagram
+ * @param[in]  data           = databuffer to be copied into datagram, NULL to
+ *                              leave the data of a write command to the caller
  */
 static void ecx_writedatagramdata(void *datagramdata, ec_cmdtype com, uint16 length, const void * data)
 {
@@ -47,7 +48,10 @@ static void ecx_writedatagramdata(void *datagramdata, ec_cmdtype com, uint16 len
             memset(datagramdata, 0, length);
             break;
          default:
-            memcpy(datagramdata, data, length);
+            if (data)
+            {
+               memcpy(datagramdata, data, length);
+            }
             break;
       }
    }
@@ -62,7 +66,8 @@ static void ecx_writedatagramdata(void *datagramdata, ec_cmdtype com, uint16 len
  * @param[in]  ADP         = Address Position
  * @param[in]  ADO         = Address Offset
  * @param[in]  length      = length of datagram excluding EtherCAT header
- * @param[in]  data        = databuffer to be copied in datagram
+ * @param[in]  data        = databuffer to be copied in datagram, NULL to leave
+ *                           the data of a write command to the caller
  * @return always 0
  */
 int ecx_setupdatagram(ecx_portt *port, void *frame, uint8 com, uint8 idx, uint16 ADP, uint16 ADO, uint16 length, void *data)
@@ -107,7 +112,7 @@ int ecx_adddatagram(ecx_portt *port, void *frame, uint8 com, uint8 idx, boolean
 {
    ec_comt *datagramP;
    uint8 *frameP;
-   uint16 prevlength;
+   uint16 prevlength, pos, next;
 
    frameP = frame;
    /* copy previous frame size */
@@ -115,6 +120,15 @@ int ecx_adddatagram(ecx_portt *port, void *frame, uint8 com, uint8 idx, boolean
    datagramP = (ec_comt*)&frameP[ETH_HEADERSIZE];
    /* add new datagram to ethernet frame size */
    datagramP->elength = htoes( etohs(datagramP->elength) + EC_HEADERSIZE + length );
+   /* find last datagram in frame */
+   pos = ETH_HEADERSIZE;
+   next = pos + EC_HEADERSIZE + (etohs(datagramP->dlength) & 0x07ff);
+   while (next < (prevlength - EC_ELENGTHSIZE))
+   {
+      pos = next;
+      datagramP = (ec_comt*)&frameP[pos];
+      next = pos + EC_HEADERSIZE + (etohs(datagramP->dlength) & 0x07ff);
+   }
    /* add "datagram follows" flag to previous subframe dlength */
    datagramP->dlength = htoes( etohs(datagramP->dlength) | EC_DATAGRAMFOLLOWS );
    /* set new EtherCAT header position */
@@ -535,6 +549,134 @@ int ecx_LRWDC(ecx_portt *port, uint32 LogAdr, uint16 length, void *data, uint16
    return wkc;
 }
 
+/** Fill datagram of a batched register access.
+ *
+ * @param[out] dg      = datagram
+ * @param[in]  cmd     = command, EC_CMD_APRD, EC_CMD_FPWR etc.
+ * @param[in]  ADP     = Address Position
+ * @param[in]  ADO     = Address Offset
+ * @param[in]  length  = length of data
+ * @param[in]  data    = data to write or buffer for read data
+ */
+void ecx_multidg(ec_multidgt *dg, uint8 cmd, uint16 ADP, uint16 ADO, uint16 length, void *data)
+{
+   dg->cmd = cmd;
+   dg->adp = ADP;
+   dg->ado = ADO;
+   dg->length = length;
+   dg->data = data;
+   dg->offset = 0;
+   dg->wkc = EC_NOFRAME;
+}
+
+/** Batched register access. Blocking.
+ * Datagrams of mixed commands, addresses and lengths are packed in order into
+ * as few frames as possible. Up to EC_MULTIWINDOW frames are sent before the
+ * replies are collected, so the number of round trips depends on the number of
+ * frames and not on the number of datagrams. Datagrams to the same slave keep
+ * their order, a read after a write returns the written value.
+ * Data of reading commands is copied back to the datagram data.
+ *
+ * @param[in]     port     = port context struct
+ * @param[in,out] dg       = datagrams
+ * @param[in]     n        = number of datagrams
+ * @param[in]     timeout  = timeout in us per window of frames, frames without
+ * answer are resent every EC_TIMEOUTRET within it, f.e. EC_TIMEOUTRET3
+ * @return number of datagrams whose frame came back
+ */
+int ecx_multirw(ecx_portt *port, ec_multidgt *dg, int n, int timeout)
+{
+   uint8 idx[EC_MULTIWINDOW];
+   uint8 done[EC_MULTIWINDOW];
+   int first[EC_MULTIWINDOW + 1];
+   int i = 0, f, nf, k, wkc, pending, cnt = 0;
+   uint16 le_wkc;
+   osal_timert timer;
+
+   while (i < n)
+   {
+      /* fill a window of frames */
+      for (nf = 0; (nf < EC_MULTIWINDOW) && (i < n); nf++)
+      {
+         idx[nf] = ecx_getindex(port);
+         first[nf] = i;
+         ecx_setupdatagram(port, &(port->txbuf[idx[nf]]), dg[i].cmd, idx[nf], dg[i].adp, dg[i].ado, dg[i].length, dg[i].data);
+         dg[i].offset = EC_HEADERSIZE;
+         i++;
+         while ((i < n) &&
+                ((port->txbuflength[idx[nf]] + EC_HEADERSIZE - EC_ELENGTHSIZE + dg[i].length + EC_WKCSIZE) <= EC_MAXTXFRAME))
+         {
+            dg[i].offset = ecx_adddatagram(port, &(port->txbuf[idx[nf]]), dg[i].cmd, idx[nf], FALSE,
+                                           dg[i].adp, dg[i].ado, dg[i].length, dg[i].data);
+            i++;
+         }
+         ecx_queueframe_red(port, idx[nf]);
+      }
+      first[nf] = i;
+      memset(done, 0, sizeof(done));
+      pending = nf;
+      osal_timer_start(&timer, timeout);
+      ecx_flushframes(port);
+      /* collect replies, resend lost frames while time is left as
+         ecx_srconfirm() does */
+      do
+      {
+         for (f = 0; f < nf; f++)
+         {
+            if (done[f])
+            {
+               continue;
+            }
+            wkc = ecx_waitinframe(port, idx[f], (timeout < EC_TIMEOUTRET) ? timeout : EC_TIMEOUTRET);
+            if (wkc <= EC_NOFRAME)
+            {
+               continue;
+            }
+            for (k = first[f]; k < first[f + 1]; k++)
+            {
+               memcpy(&le_wkc, &(port->rxbuf[idx[f]][dg[k].offset + dg[k].length]), EC_WKCSIZE);
+               dg[k].wkc = etohs(le_wkc);
+               if ((dg[k].cmd != EC_CMD_APWR) && (dg[k].cmd != EC_CMD_FPWR) &&
+                   (dg[k].cmd != EC_CMD_BWR) && (dg[k].cmd != EC_CMD_LWR))
+               {
+                  memcpy(dg[k].data, &(port->rxbuf[idx[f]][dg[k].offset]), dg[k].length);
+               }
+               cnt++;
+            }
+            done[f] = 1;
+            pending--;
+         }
+         if (pending && !osal_timer_is_expired(&timer))
+         {
+            for (f = 0; f < nf; f++)
+            {
+               if (!done[f])
+               {
+                  ecx_outframe_red(port, idx[f]);
+               }
+            }
+         }
+         else
+         {
+            break;
+         }
+      } while (pending);
+      for (f = 0; f < nf; f++)
+      {
+         if (!done[f])
+         {
+            for (k = first[f]; k < first[f + 1]; k++)
+            {
+               dg[k].wkc = EC_NOFRAME;
+            }
+         }
+         ecx_setbufstat(port, idx[f], EC_BUF_EMPTY);
+      }
+   }
+
+   return cnt;
+}
+
 #ifdef EC_VER1
 int ec_setupdatagram(void *frame, uint8 com, uint8 idx, uint16 ADP, uint16 ADO, uint16 length, void *data)
 {
@@ -634,4 +776,9 @@ int ec_LRWDC(uint32 LogAdr, uint16 length, void *data, uint16 DCrs, int64 *DCtim
 {
    return ecx_LRWDC(&ecx_port, LogAdr, length, data, DCrs, DCtime, timeout);
 }
+
+int ec_multirw(ec_multidgt *dg, int n, int timeout)
+{
+   return ecx_multirw(&ecx_port, dg, n, timeout);
+}
 #endif
@@ -16,6 +16,29 @@ extern "C"
 {
 #endif
 
+/** max. number of frames in flight in a batched register access */
+#ifndef EC_MULTIWINDOW
+#define EC_MULTIWINDOW    4
+#endif
+
+/** Datagram of a batched register access, see ecx_multirw() */
+typedef struct
+{
+   /** EC_CMD_APRD, EC_CMD_FPWR etc. */
+   uint8    cmd;
+   /** slave position or address, low word of logical address for logical commands */
+   uint16   adp;
+   /** register address, high word of logical address for logical commands */
+   uint16   ado;
+   uint16   length;
+   /** data to write, receives data of reading commands */
+   void     *data;
+   /** offset of data in received frame */
+   int      offset;
+   /** work counter, EC_NOFRAME if the frame was lost */
+   int      wkc;
+} ec_multidgt;
+
 int ecx_setupdatagram(ecx_portt *port, void *frame, uint8 com, uint8 idx, uint16 ADP, uint16 ADO, uint16 length, void *data);
 int ecx_adddatagram(ecx_portt *port, void *frame, uint8 com, uint8 idx, boolean more, uint16 ADP, uint16 ADO, uint16 length, void *data);
 int ecx_BWR(ecx_portt *port, uint16 ADP,uint16 ADO,uint16 length,void *data,int timeout);
@@ -34,6 +57,8 @@ int ecx_LRW(ecx_portt *port, uint32 LogAdr, uint16 length, void *data, int timeo
 int ecx_LRD(ecx_portt *port, uint32 LogAdr, uint16 length, void *data, int timeout);
 int ecx_LWR(ecx_portt *port, uint32 LogAdr, uint16 length, void *data, int timeout);
 int ecx_LRWDC(ecx_portt *port, uint32 LogAdr, uint16 length, void *data, uint16 DCrs, int64 *DCtime, int timeout);
+void ecx_multidg(ec_multidgt *dg, uint8 cmd, uint16 ADP, uint16 ADO, uint16 length, void *data);
+int ecx_multirw(ecx_portt *port, ec_multidgt *dg, int n, int timeout);
 
 #ifdef EC_VER1
 int ec_setupdatagram(void *frame, uint8 com, uint8 idx, uint16 ADP, uint16 ADO, uint16 length, void *data);
@@ -54,6 +79,7 @@ int ec_LRW(uint32 LogAdr, uint16 length, void *data, int timeout);
 int ec_LRD(uint32 LogAdr, uint16 length, void *data, int timeout);
 int ec_LWR(uint32 LogAdr, uint16 length, void *data, int timeout);
 int ec_LRWDC(uint32 LogAdr, uint16 length, void *data, uint16 DCrs, int64 *DCtime, int timeout);
+int ec_multirw(ec_multidgt *dg, int n, int timeout);
 #endif
 
 #ifdef __cplusplus
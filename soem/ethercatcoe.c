@@ -1310,6 +1310,952 @@ int ecx_readOE(ecx_contextt *context, uint16 Item, ec_ODlistt *pODlist, ec_OElis
    return wkc;
 }
 
+/** Build SDO download request of one or more parameters. More parameters are
+ * written with Complete Access starting at the subindex of the first one.
+ *
+ * @param[out] mbx        = mailbox buffer for request
+ * @param[in]  param      = first parameter
+ * @param[in]  count      = number of parameters
+ * @param[in]  CA         = FALSE = single subindex. TRUE = Complete access
+ * @param[in]  cnt        = mailbox counter of request
+ */
+static void ecx_SDOparamreq(ec_mbxbuft *mbx, ec_SDOparamt *param, int count, boolean CA, uint8 cnt)
+{
+   ec_SDOt *SDOp;
+   uint8 *hp;
+   int i, psize = 0;
+
+   ec_clearmbx(mbx);
+   SDOp = (ec_SDOt *)mbx;
+   for (i = 0; i < count; i++)
+   {
+      psize += param[i].psize;
+   }
+   SDOp->MbxHeader.address = htoes(0x0000);
+   SDOp->MbxHeader.priority = 0x00;
+   SDOp->MbxHeader.mbxtype = ECT_MBXT_COE + (cnt << 4); /* CoE */
+   SDOp->CANOpen = htoes(0x000 + (ECT_COES_SDOREQ << 12)); /* number 9bits service upper 4 bits */
+   SDOp->Index = htoes(param->Index);
+   SDOp->SubIndex = param->SubIndex;
+   if ((psize <= 4) && !CA)
+   {
+      SDOp->MbxHeader.length = htoes(0x000a);
+      SDOp->Command = ECT_SDO_DOWN_EXP | (((4 - psize) << 2) & 0x0c); /* expedited SDO download transfer */
+      hp = (uint8 *)&SDOp->ldata[0];
+   }
+   else
+   {
+      SDOp->MbxHeader.length = htoes(0x0a + psize);
+      SDOp->Command = CA ? ECT_SDO_DOWN_INIT_CA : ECT_SDO_DOWN_INIT; /* normal SDO init download transfer */
+      SDOp->ldata[0] = htoel(psize);
+      hp = (uint8 *)&SDOp->ldata[1];
+   }
+   for (i = 0; i < count; i++)
+   {
+      memcpy(hp, param[i].p, param[i].psize);
+      hp += param[i].psize;
+   }
+}
+
+/** Set result of oldest download in flight of a parameter set.
+ *
+ * @param[in]  set        = parameter set
+ * @param[in]  result     = 1, EC_ERROR or EC_TIMEOUT
+ * @param[in]  AbortCode  = SDO abort code when aborted
+ */
+static void ecx_SDOparamdone(ec_SDOparamsett *set, int result, int32 AbortCode)
+{
+   ec_SDOparamxfert *xfer = &(set->inflight[0]);
+   int i;
+
+   for (i = xfer->first; i < (xfer->first + xfer->count); i++)
+   {
+      set->param[i].result = result;
+      set->param[i].AbortCode = AbortCode;
+   }
+   /* aborted Complete Access is repeated per subindex right away, nothing
+      after it is in flight so the parameters stay in list order */
+   if (xfer->CA && (result == EC_ERROR))
+   {
+      for (i = xfer->first; i < (xfer->first + xfer->count); i++)
+      {
+         set->param[i].result = 0;
+      }
+      set->next = xfer->first;
+      set->single = xfer->first + xfer->count;
+   }
+   set->ninflight--;
+   for (i = 0; i < set->ninflight; i++)
+   {
+      set->inflight[i] = set->inflight[i + 1];
+   }
+}
+
+/** Advance parameter set download of one slave without waiting. Collects the
+ * response of the oldest download in flight and sends the next download as
+ * soon as the slave has taken the previous request out of its mailbox.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  set        = parameter set
+ * @param[in]  rxfull     = TRUE if the read mailbox of the slave may hold a response
+ * @param[in]  timeout    = timeout in us for the response of a download
+ * @return TRUE while downloads are left
+ */
+static boolean ecx_SDOparamstep(ecx_contextt *context, ec_SDOparamsett *set, boolean rxfull, int timeout)
+{
+   ec_SDOt *aSDOp;
+   ec_mbxbuft MbxIn, MbxOut;
+   ec_SDOparamt *param;
+   ec_SDOparamxfert *xfer;
+   uint16 Slave = set->Slave;
+   int wkc, count, psize, maxdata;
+   boolean CA;
+   uint8 cnt;
+
+   /* response of oldest download */
+   if (set->ninflight)
+   {
+      xfer = &(set->inflight[0]);
+      param = &(set->param[xfer->first]);
+      ec_clearmbx(&MbxIn);
+      wkc = rxfull ? ecx_mbxreceive(context, Slave, &MbxIn, 0) : 0;
+      aSDOp = (ec_SDOt *)&MbxIn;
+      if ((wkc > 0) && ((aSDOp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_COE))
+      {
+         if (aSDOp->Command == ECT_SDO_ABORT) /* SDO abort frame received */
+         {
+            if (!xfer->CA)
+            {
+               ecx_SDOerror(context, Slave, param->Index, param->SubIndex, etohl(aSDOp->ldata[0]));
+            }
+            ecx_SDOparamdone(set, EC_ERROR, (int32)etohl(aSDOp->ldata[0]));
+         }
+         else if (((etohs(aSDOp->CANOpen) >> 12) == ECT_COES_SDORES) &&
+                  (etohs(aSDOp->Index) == param->Index) &&
+                  ((aSDOp->SubIndex == param->SubIndex) || xfer->CA))
+         {
+            ecx_SDOparamdone(set, 1, 0);
+         }
+         else
+         {
+            ecx_packeterror(context, Slave, param->Index, param->SubIndex, 1); /* Unexpected frame returned */
+            ecx_SDOparamdone(set, EC_ERROR, 0);
+         }
+      }
+      else if (osal_timer_is_expired(&(xfer->timer)))
+      {
+         ecx_SDOparamdone(set, EC_TIMEOUT, 0);
+      }
+   }
+   /* nothing is sent behind a Complete Access download, it may be aborted
+      and repeated per subindex */
+   if ((set->next < set->n) && (set->ninflight < EC_SDOPARAMDEPTH) &&
+       !(set->ninflight && set->inflight[set->ninflight - 1].CA))
+   {
+      param = &(set->param[set->next]);
+      maxdata = context->slavelist[Slave].mbx_l - 0x10; /* data section=mailbox size - 6 mbx - 2 CoE - 8 sdo req */
+      count = 1;
+      psize = param->psize;
+      /* contiguous subindexes of one index are written with Complete Access */
+      if ((set->next >= set->single) && (param->SubIndex == 1) &&
+          (context->slavelist[Slave].CoEdetails & ECT_COEDET_SDOCA))
+      {
+         while (((set->next + count) < set->n) &&
+                (param[count].Index == param->Index) &&
+                (param[count].SubIndex == (param->SubIndex + count)) &&
+                ((psize + param[count].psize) <= maxdata))
+         {
+            psize += param[count].psize;
+            count++;
+         }
+      }
+      CA = (count > 1);
+      if (psize > maxdata)
+      {
+         /* segmented transfer, only when nothing else is in flight */
+         if (!set->ninflight)
+         {
+            wkc = ecx_SDOwrite(context, Slave, param->Index, param->SubIndex, FALSE,
+                               param->psize, param->p, timeout);
+            param->result = (wkc > 0) ? 1 : EC_ERROR;
+            set->next++;
+         }
+      }
+      else if (psize > 0)
+      {
+         cnt = ec_nextmbxcnt(context->slavelist[Slave].mbx_cnt);
+         ecx_SDOparamreq(&MbxOut, param, count, CA, cnt);
+         /* send when the slave has taken the previous request */
+         if (ecx_mbxsend(context, Slave, &MbxOut, 0) > 0)
+         {
+            context->slavelist[Slave].mbx_cnt = cnt;
+            xfer = &(set->inflight[set->ninflight++]);
+            xfer->first = set->next;
+            xfer->count = count;
+            xfer->CA = CA;
+            osal_timer_start(&(xfer->timer), timeout);
+            set->next += count;
+         }
+      }
+      else
+      {
+         param->result = EC_ERROR;
+         set->next++;
+      }
+   }
+   return ((set->next < set->n) || set->ninflight) ? TRUE : FALSE;
+}
+
+/** CoE SDO download of parameter sets to many slaves. Parameters with
+ * contiguous subindexes of one index, starting at subindex 1, are combined
+ * into one Complete Access download when the slave supports it. A Complete
+ * Access download the slave aborts is repeated per subindex before any later
+ * parameter, so the parameters of a slave are always written in list order. Up
+ * to EC_SDOPARAMDEPTH downloads per slave are in flight, the next request is
+ * written as soon as the slave has taken the previous one out of its mailbox,
+ * and all slaves are served in turn so their downloads overlap. Responses are
+ * looked for with one ecx_mbxpoll() of the waiting slaves of each block of
+ * EC_MBXPOLLMULTI sets per turn, turns without progress are EC_SDOPARAMIDLE
+ * apart. Parameters that do not fit in one mailbox use the segmented transfer
+ * of ecx_SDOwrite().
+ *
+ * @param[in]  context    = context struct
+ * @param[in,out] set     = parameter sets, one per slave, result of each parameter is set
+ * @param[in]  nset       = number of parameter sets
+ * @param[in]  timeout    = timeout in us for the response of a download, standard is EC_TIMEOUTRXM
+ * @return number of parameters written
+ */
+int ecx_SDOwriteparams(ecx_contextt *context, ec_SDOparamsett *set, int nset, int timeout)
+{
+   ec_mbxbuft MbxIn;
+   ec_mbxpollt poll;
+   ec_mbxpollslavet pslave[EC_MBXPOLLMULTI];
+   boolean busy, rxfull, progress;
+   int i, k, first, last, next, ninflight, cnt = 0;
+
+   for (i = 0; i < nset; i++)
+   {
+      set[i].next = 0;
+      set[i].single = 0;
+      set[i].ninflight = 0;
+      for (k = 0; k < set[i].n; k++)
+      {
+         set[i].param[k].result = 0;
+         set[i].param[k].AbortCode = 0;
+      }
+      if (!context->slavelist[set[i].Slave].mbx_l)
+      {
+         for (k = 0; k < set[i].n; k++)
+         {
+            set[i].param[k].result = EC_ERROR;
+         }
+         set[i].next = set[i].n;
+      }
+      else
+      {
+         ec_clearmbx(&MbxIn);
+         /* Empty slave out mailbox if something is in. Timeout set to 0 */
+         ecx_mbxreceive(context, set[i].Slave, &MbxIn, 0);
+      }
+   }
+   memset(&poll, 0, sizeof(poll));
+   poll.slave = pslave;
+   do
+   {
+      busy = FALSE;
+      progress = FALSE;
+      for (first = 0; first < nset; first = last)
+      {
+         last = ((nset - first) > EC_MBXPOLLMULTI) ? (first + EC_MBXPOLLMULTI) : nset;
+         /* one status poll for the slaves of the block waiting for a response,
+            mailboxes handled in the process data frames are read without it */
+         poll.nslaves = 0;
+         if (!context->mbxcyclic)
+         {
+            for (i = first; i < last; i++)
+            {
+               if (set[i].ninflight)
+               {
+                  poll.slave[poll.nslaves++].slave = set[i].Slave;
+               }
+            }
+            ecx_mbxpoll(context, &poll);
+         }
+         k = 0;
+         for (i = first; i < last; i++)
+         {
+            rxfull = context->mbxcyclic ? TRUE : FALSE;
+            if (!context->mbxcyclic && set[i].ninflight)
+            {
+               rxfull = (poll.slave[k++].SMstat & 0x08) ? TRUE : FALSE;
+            }
+            next = set[i].next;
+            ninflight = set[i].ninflight;
+            if (ecx_SDOparamstep(context, &set[i], rxfull, timeout))
+            {
+               busy = TRUE;
+            }
+            if ((set[i].next != next) || (set[i].ninflight != ninflight))
+            {
+               progress = TRUE;
+            }
+         }
+      }
+      /* all slaves are waiting for their mailbox, give them time */
+      if (busy && !progress)
+      {
+         osal_usleep(EC_SDOPARAMIDLE);
+      }
+   } while (busy);
+   for (i = 0; i < nset; i++)
+   {
+      for (k = 0; k < set[i].n; k++)
+      {
+         cnt += (set[i].param[k].result > 0) ? 1 : 0;
+      }
+   }
+
+   return cnt;
+}
+
+/** Size of the compact object dictionary header, the objects follow it */
+#define EC_ODDICT_HDRSIZE  ((uint32)((sizeof(ec_ODdictt) + 7) & ~7))
+
+/** Initialise empty compact object dictionary in a caller supplied block.
+ *
+ * @param[out] dict       = start of block
+ * @param[in]  size       = size of block in bytes
+ * @param[in]  Slave      = Slave number the dictionary is read from
+ * @return 1 if OK, 0 if the block is too small
+ */
+int ec_ODdict_init(ec_ODdictt *dict, uint32 size, uint16 Slave)
+{
+   if (size < EC_ODDICT_HDRSIZE)
+   {
+      return 0;
+   }
+   memset(dict, 0, sizeof(*dict));
+   dict->magic = EC_ODDICT_MAGIC;
+   dict->version = EC_ODDICT_VERSION;
+   dict->Slave = Slave;
+   dict->size = size;
+   dict->used = EC_ODDICT_HDRSIZE;
+   dict->names = size;
+   dict->end = size;
+   dict->state = EC_ODDICT_LIST;
+
+   return 1;
+}
+
+/** Get object of compact object dictionary by position.
+ *
+ * @param[in]  dict       = compact object dictionary
+ * @param[in]  n          = position, 0 to nobj - 1
+ * @return object or NULL
+ */
+ec_ODobjt *ec_ODdict_obj(ec_ODdictt *dict, uint16 n)
+{
+   if (n >= dict->nobj)
+   {
+      return NULL;
+   }
+   return (ec_ODobjt *)((uint8 *)dict + EC_ODDICT_HDRSIZE) + n;
+}
+
+/** Find object in compact object dictionary.
+ *
+ * @param[in]  dict       = compact object dictionary
+ * @param[in]  Index      = object index
+ * @return object or NULL if not found
+ */
+ec_ODobjt *ec_ODdict_find(ec_ODdictt *dict, uint16 Index)
+{
+   ec_ODobjt *obj;
+   uint16 n;
+
+   for (n = 0; n < dict->nobj; n++)
+   {
+      obj = ec_ODdict_obj(dict, n);
+      if (obj->Index == Index)
+      {
+         return obj;
+      }
+   }
+   return NULL;
+}
+
+/** Get entry of object in compact object dictionary.
+ *
+ * @param[in]  dict       = compact object dictionary
+ * @param[in]  obj        = object of the dictionary
+ * @param[in]  SubIndex   = subindex, 0 to obj->MaxSub
+ * @return entry or NULL if the object has no entries read
+ */
+ec_OEentryt *ec_ODdict_entry(ec_ODdictt *dict, ec_ODobjt *obj, uint8 SubIndex)
+{
+   if (!obj->entry || (SubIndex > obj->MaxSub))
+   {
+      return NULL;
+   }
+   return (ec_OEentryt *)((uint8 *)dict + obj->entry) + SubIndex;
+}
+
+/** Get name of object or entry in compact object dictionary.
+ *
+ * @param[in]  dict       = compact object dictionary
+ * @param[in]  name       = name offset of object or entry
+ * @return name, empty string if none
+ */
+const char *ec_ODdict_name(ec_ODdictt *dict, uint32 name)
+{
+   return name ? (const char *)dict + name : "";
+}
+
+/** Move the names of a complete dictionary behind the objects and entries so
+ * the dictionary can be saved in its first end bytes.
+ *
+ * @param[in,out] dict    = compact object dictionary
+ * @return number of bytes to save
+ */
+uint32 ec_ODdict_pack(ec_ODdictt *dict)
+{
+   ec_ODobjt *obj;
+   ec_OEentryt *entry;
+   uint32 delta;
+   uint16 n, sub;
+
+   delta = dict->names - dict->used;
+   if (delta)
+   {
+      memmove((uint8 *)dict + dict->used, (uint8 *)dict + dict->names, dict->end - dict->names);
+      for (n = 0; n < dict->nobj; n++)
+      {
+         obj = ec_ODdict_obj(dict, n);
+         if (obj->name)
+         {
+            obj->name -= delta;
+         }
+         for (sub = 0; obj->entry && (sub <= obj->MaxSub); sub++)
+         {
+            entry = ec_ODdict_entry(dict, obj, (uint8)sub);
+            if (entry->name)
+            {
+               entry->name -= delta;
+            }
+         }
+      }
+      dict->names -= delta;
+      dict->end -= delta;
+   }
+
+   return dict->end;
+}
+
+/** Check a loaded compact object dictionary. It is valid when it is complete,
+ * consistent and was read from a slave with the identity of dict->Slave.
+ *
+ * @param[in]  context    = context struct
+ * @param[in,out] dict    = loaded dictionary, size is set when valid
+ * @param[in]  size       = size of the block it is loaded in
+ * @return TRUE if valid, otherwise initialise it with ec_ODdict_init() before reading
+ */
+boolean ecx_ODdict_check(ecx_contextt *context, ec_ODdictt *dict, uint32 size)
+{
+   ec_slavet *sl;
+   ec_ODobjt *obj;
+   ec_OEentryt *entry;
+   uint16 n, sub;
+
+   if ((size < EC_ODDICT_HDRSIZE) || (dict->magic != EC_ODDICT_MAGIC) ||
+       (dict->version != EC_ODDICT_VERSION) || (dict->state != EC_ODDICT_DONE) ||
+       (dict->Slave < 1) || (dict->Slave > *(context->slavecount)) ||
+       (dict->end > size) || (dict->names > dict->end) || (dict->used > dict->names) ||
+       ((EC_ODDICT_HDRSIZE + (uint32)dict->nobj * sizeof(ec_ODobjt)) > dict->used) ||
+       ((dict->names < dict->end) && (*((uint8 *)dict + dict->end - 1) != 0)))
+   {
+      return FALSE;
+   }
+   sl = &(context->slavelist[dict->Slave]);
+   if ((sl->eep_man != dict->eep_man) || (sl->eep_id != dict->eep_id) || (sl->eep_rev != dict->eep_rev))
+   {
+      return FALSE;
+   }
+   for (n = 0; n < dict->nobj; n++)
+   {
+      obj = ec_ODdict_obj(dict, n);
+      if ((obj->name && ((obj->name < dict->names) || (obj->name >= dict->end))) ||
+          (obj->entry && ((obj->entry < EC_ODDICT_HDRSIZE) ||
+                          ((obj->entry + (obj->MaxSub + 1) * sizeof(ec_OEentryt)) > dict->used))))
+      {
+         return FALSE;
+      }
+      for (sub = 0; obj->entry && (sub <= obj->MaxSub); sub++)
+      {
+         entry = ec_ODdict_entry(dict, obj, (uint8)sub);
+         if (entry->name && ((entry->name < dict->names) || (entry->name >= dict->end)))
+         {
+            return FALSE;
+         }
+      }
+   }
+   dict->size = size;
+
+   return TRUE;
+}
+
+/** Start upload of a compact object dictionary, previous content is dropped.
+ *
+ * @param[in]  context    = context struct
+ * @param[in,out] dict    = compact object dictionary
+ */
+static void ecx_ODdictstart(ecx_contextt *context, ec_ODdictt *dict)
+{
+   ec_slavet *sl;
+
+   ec_ODdict_init(dict, dict->size, dict->Slave);
+   if ((dict->Slave < 1) || (dict->Slave > *(context->slavecount)))
+   {
+      dict->state = EC_ODDICT_ERROR;
+      return;
+   }
+   sl = &(context->slavelist[dict->Slave]);
+   dict->eep_man = sl->eep_man;
+   dict->eep_id = sl->eep_id;
+   dict->eep_rev = sl->eep_rev;
+   if (!sl->mbx_l || !(sl->mbx_proto & ECT_MBXPROT_COE))
+   {
+      dict->state = EC_ODDICT_ERROR;
+   }
+}
+
+/** Add name to compact object dictionary.
+ *
+ * @param[in,out] dict    = compact object dictionary
+ * @param[in]  name       = name, not terminated
+ * @param[in]  n          = length of name
+ * @return offset of name, 0 if there is no space left
+ */
+static uint32 ecx_ODdictname(ec_ODdictt *dict, const uint8 *name, int n)
+{
+   if (n < 0)
+   {
+      n = 0;
+   }
+   if ((dict->names - dict->used) < (uint32)(n + 1))
+   {
+      return 0;
+   }
+   dict->names -= n + 1;
+   memcpy((uint8 *)dict + dict->names, name, n);
+   *((uint8 *)dict + dict->names + n) = 0x00; /* string terminator */
+
+   return dict->names;
+}
+
+/** Move request or response position to the next object entry.
+ *
+ * @param[in]  dict       = compact object dictionary
+ * @param[in,out] obj     = object position
+ * @param[in,out] sub     = subindex
+ * @param[in]  next       = TRUE to advance, FALSE to only skip objects without entries
+ */
+static void ecx_ODdictnextentry(ec_ODdictt *dict, uint16 *obj, uint16 *sub, boolean next)
+{
+   ec_ODobjt *o;
+
+   if (next)
+   {
+      (*sub)++;
+   }
+   while ((o = ec_ODdict_obj(dict, *obj)) != NULL)
+   {
+      if (o->entry && (*sub <= o->MaxSub))
+      {
+         return;
+      }
+      (*obj)++;
+      *sub = 0;
+   }
+}
+
+/** Report that the dictionary does not fit in its block.
+ *
+ * @param[in]  context    = context struct
+ * @param[in,out] dict    = compact object dictionary
+ */
+static void ecx_ODdictfull(ecx_contextt *context, ec_ODdictt *dict)
+{
+   ecx_SDOinfoerror(context, dict->Slave, 0, 0, 0xf000000); /* Too many entries for master buffer */
+   dict->state = EC_ODDICT_ERROR;
+}
+
+/** Handle SDO information response of a dictionary upload. Responses come in
+ * the order of the requests, a response of more fragments only keeps the
+ * start of the name.
+ *
+ * @param[in]  context    = context struct
+ * @param[in,out] dict    = compact object dictionary
+ * @param[in]  aSDOp      = SDO information response
+ */
+static void ecx_ODdictresponse(ecx_contextt *context, ec_ODdictt *dict, ec_SDOservicet *aSDOp)
+{
+   ec_ODobjt *obj;
+   ec_OEentryt *entry;
+   uint16 length, n, i, offset;
+   int datal;
+   uint8 opcode;
+
+   opcode = aSDOp->Opcode & 0x7f;
+   length = etohs(aSDOp->MbxHeader.length);
+   /* data of a response is limited by the read mailbox */
+   datal = context->slavelist[dict->Slave].mbx_rl - sizeof(ec_mbxheadert);
+   if (length < datal)
+   {
+      datal = length;
+   }
+   obj = ec_ODdict_obj(dict, dict->robj);
+   if (dict->state == EC_ODDICT_LIST)
+   {
+      if (opcode == ECT_GET_ODLIST_RES)
+      {
+         /* first fragment starts with the list type */
+         offset = dict->frag ? 0 : 1;
+         n = (datal > 6) ? (uint16)((datal - 6) / 2) : 0;
+         n = (n > offset) ? (uint16)(n - offset) : 0;
+         for (i = 0; i < n; i++)
+         {
+            if ((dict->used + sizeof(ec_ODobjt)) > dict->names)
+            {
+               ecx_ODdictfull(context, dict);
+               return;
+            }
+            obj = (ec_ODobjt *)((uint8 *)dict + dict->used);
+            memset(obj, 0, sizeof(*obj));
+            obj->Index = etohs(aSDOp->wdata[i + offset]);
+            dict->used += sizeof(ec_ODobjt);
+            dict->nobj++;
+         }
+         dict->frag = etohs(aSDOp->Fragments);
+         if (!dict->frag)
+         {
+            dict->ninflight = 0;
+            dict->sobj = 0;
+            dict->state = (dict->nobj) ? EC_ODDICT_DESC : EC_ODDICT_DONE;
+         }
+      }
+      else if (opcode == ECT_SDOINFO_ERROR)
+      {
+         ecx_SDOinfoerror(context, dict->Slave, 0, 0, etohl(aSDOp->ldata[0]));
+         dict->state = EC_ODDICT_ERROR;
+      }
+      else
+      {
+         ecx_packeterror(context, dict->Slave, 0, 0, 1); /* Unexpected frame returned */
+      }
+      return;
+   }
+   if (!obj)
+   {
+      return;
+   }
+   if (dict->frag)
+   {
+      /* rest of a fragmented response */
+      dict->frag = etohs(aSDOp->Fragments);
+   }
+   else if ((dict->state == EC_ODDICT_DESC) && (opcode == ECT_GET_OD_RES) &&
+            (etohs(aSDOp->wdata[0]) == obj->Index))
+   {
+      obj->DataType = etohs(aSDOp->wdata[1]);
+      obj->ObjectCode = aSDOp->bdata[5];
+      obj->MaxSub = aSDOp->bdata[4];
+      if ((dict->used + (obj->MaxSub + 1) * sizeof(ec_OEentryt)) > dict->names)
+      {
+         ecx_ODdictfull(context, dict);
+         return;
+      }
+      obj->entry = dict->used;
+      dict->used += (obj->MaxSub + 1) * sizeof(ec_OEentryt);
+      memset((uint8 *)dict + obj->entry, 0, (obj->MaxSub + 1) * sizeof(ec_OEentryt));
+      obj->name = ecx_ODdictname(dict, &aSDOp->bdata[6], datal - 12);
+      if (!obj->name && (datal > 12))
+      {
+         ecx_ODdictfull(context, dict);
+         return;
+      }
+      dict->frag = etohs(aSDOp->Fragments);
+   }
+   else if ((dict->state == EC_ODDICT_ENTRY) && (opcode == ECT_GET_OE_RES) &&
+            (etohs(aSDOp->wdata[0]) == obj->Index) && (aSDOp->bdata[2] == dict->rsub))
+   {
+      entry = ec_ODdict_entry(dict, obj, (uint8)dict->rsub);
+      entry->ValueInfo = aSDOp->bdata[3];
+      entry->DataType = etohs(aSDOp->wdata[2]);
+      entry->BitLength = etohs(aSDOp->wdata[3]);
+      entry->ObjAccess = etohs(aSDOp->wdata[4]);
+      entry->valid = 1;
+      entry->name = ecx_ODdictname(dict, (uint8 *)&aSDOp->wdata[5], datal - 16);
+      if (!entry->name && (datal > 16))
+      {
+         ecx_ODdictfull(context, dict);
+         return;
+      }
+      dict->frag = etohs(aSDOp->Fragments);
+   }
+   else if (opcode == ECT_SDOINFO_ERROR)
+   {
+      /* object or entry stays without description */
+      ecx_SDOinfoerror(context, dict->Slave, obj->Index, (uint8)dict->rsub, etohl(aSDOp->ldata[0]));
+   }
+   else
+   {
+      ecx_packeterror(context, dict->Slave, obj->Index, (uint8)dict->rsub, 1); /* Unexpected frame returned */
+      return;
+   }
+   if (dict->frag)
+   {
+      return;
+   }
+   /* request answered */
+   dict->ninflight--;
+   if (dict->state == EC_ODDICT_DESC)
+   {
+      dict->robj++;
+      if (dict->robj >= dict->nobj)
+      {
+         dict->state = EC_ODDICT_ENTRY;
+         dict->sobj = dict->ssub = dict->robj = dict->rsub = 0;
+         ecx_ODdictnextentry(dict, &(dict->sobj), &(dict->ssub), FALSE);
+         ecx_ODdictnextentry(dict, &(dict->robj), &(dict->rsub), FALSE);
+      }
+   }
+   else
+   {
+      ecx_ODdictnextentry(dict, &(dict->robj), &(dict->rsub), TRUE);
+   }
+   if ((dict->state == EC_ODDICT_ENTRY) && (dict->robj >= dict->nobj))
+   {
+      dict->state = EC_ODDICT_DONE;
+   }
+}
+
+/** Advance dictionary upload of one slave without waiting. Handles a response
+ * and sends the next request as soon as the slave has taken the previous one
+ * out of its mailbox.
+ *
+ * @param[in]  context    = context struct
+ * @param[in,out] dict    = compact object dictionary
+ * @param[in]  rxfull     = TRUE if the read mailbox of the slave may hold a response
+ * @param[in]  timeout    = timeout in us for a response
+ * @return TRUE while the upload is running
+ */
+static boolean ecx_ODdictstep(ecx_contextt *context, ec_ODdictt *dict, boolean rxfull, int timeout)
+{
+   ec_SDOservicet *SDOp, *aSDOp;
+   ec_mbxbuft MbxIn, MbxOut;
+   ec_ODobjt *obj = NULL;
+   uint16 Slave = dict->Slave;
+   uint8 cnt;
+   int wkc;
+
+   if (dict->ninflight)
+   {
+      wkc = 0;
+      if (rxfull)
+      {
+         ec_clearmbx(&MbxIn);
+         wkc = ecx_mbxreceive(context, Slave, &MbxIn, 0);
+      }
+      aSDOp = (ec_SDOservicet *)&MbxIn;
+      if ((wkc > 0) && ((aSDOp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_COE) &&
+          ((etohs(aSDOp->CANOpen) >> 12) == ECT_COES_SDOINFO))
+      {
+         ecx_ODdictresponse(context, dict, aSDOp);
+         osal_timer_start(&(dict->timer), timeout);
+      }
+      else if (osal_timer_is_expired(&(dict->timer)))
+      {
+         dict->state = EC_ODDICT_ERROR;
+      }
+   }
+   if (dict->state == EC_ODDICT_LIST)
+   {
+      /* the object list is requested once */
+      if (dict->ninflight || dict->sobj)
+      {
+         return TRUE;
+      }
+   }
+   else if ((dict->state == EC_ODDICT_DESC) || (dict->state == EC_ODDICT_ENTRY))
+   {
+      obj = ec_ODdict_obj(dict, dict->sobj);
+      if (!obj || (dict->ninflight >= EC_SDOINFODEPTH))
+      {
+         return TRUE;
+      }
+   }
+   else
+   {
+      return FALSE;
+   }
+   ec_clearmbx(&MbxOut);
+   SDOp = (ec_SDOservicet *)&MbxOut;
+   SDOp->MbxHeader.length = htoes(0x0008);
+   SDOp->MbxHeader.address = htoes(0x0000);
+   SDOp->MbxHeader.priority = 0x00;
+   cnt = ec_nextmbxcnt(context->slavelist[Slave].mbx_cnt);
+   SDOp->MbxHeader.mbxtype = ECT_MBXT_COE + (cnt << 4); /* CoE */
+   SDOp->CANOpen = htoes(0x000 + (ECT_COES_SDOINFO << 12)); /* number 9bits service upper 4 bits */
+   SDOp->Reserved = 0;
+   SDOp->Fragments = 0; /* fragments left */
+   if (!obj)
+   {
+      SDOp->Opcode = ECT_GET_ODLIST_REQ; /* get object description list request */
+      SDOp->wdata[0] = htoes(0x01); /* all objects */
+   }
+   else if (dict->state == EC_ODDICT_DESC)
+   {
+      SDOp->Opcode = ECT_GET_OD_REQ; /* get object description request */
+      SDOp->wdata[0] = htoes(obj->Index); /* Data of Index */
+   }
+   else
+   {
+      SDOp->MbxHeader.length = htoes(0x000a);
+      SDOp->Opcode = ECT_GET_OE_REQ; /* get object entry description request */
+      SDOp->wdata[0] = htoes(obj->Index); /* Index */
+      SDOp->bdata[2] = (uint8)dict->ssub; /* SubIndex */
+      SDOp->bdata[3] = 1 + 2 + 4; /* get access rights, object category, PDO */
+   }
+   if (ecx_mbxsend(context, Slave, &MbxOut, 0) > 0)
+   {
+      context->slavelist[Slave].mbx_cnt = cnt;
+      if (!dict->ninflight)
+      {
+         osal_timer_start(&(dict->timer), timeout);
+      }
+      dict->ninflight++;
+      if (dict->state == EC_ODDICT_LIST)
+      {
+         dict->sobj = 1;
+      }
+      else if (dict->state == EC_ODDICT_DESC)
+      {
+         dict->sobj++;
+      }
+      else
+      {
+         ecx_ODdictnextentry(dict, &(dict->sobj), &(dict->ssub), TRUE);
+      }
+   }
+
+   return TRUE;
+}
+
+/** CoE read object dictionaries of many slaves into compact object
+ * dictionaries. For each slave the object list, the object descriptions and
+ * the descriptions of all entries are read. Up to EC_SDOINFODEPTH requests
+ * per slave are in flight and all slaves are served in turn, so the uploads
+ * overlap. Responses are looked for with one ecx_mbxpoll() of the waiting
+ * slaves of each block of EC_MBXPOLLMULTI dictionaries per turn, turns
+ * without progress are EC_SDOPARAMIDLE apart. Dictionaries
+ * that are complete and were read from a slave with the same identity are
+ * kept, so a dictionary loaded after ecx_ODdict_check() is not read again.
+ *
+ * @param[in]  context    = context struct
+ * @param[in,out] dict    = dictionaries, set up by ec_ODdict_init() with the slave to read
+ * @param[in]  n          = number of dictionaries
+ * @param[in]  timeout    = timeout in us for each response, standard is EC_TIMEOUTRXM
+ * @return number of complete dictionaries
+ */
+int ecx_readODdict(ecx_contextt *context, ec_ODdictt **dict, int n, int timeout)
+{
+   ec_mbxbuft MbxIn;
+   ec_mbxpollt poll;
+   ec_mbxpollslavet pslave[EC_MBXPOLLMULTI];
+   ec_slavet *sl;
+   ec_ODdictt prev;
+   boolean busy, rxfull, progress;
+   int i, k, first, last, cnt = 0;
+
+   for (i = 0; i < n; i++)
+   {
+      if ((dict[i]->state == EC_ODDICT_DONE) && (dict[i]->Slave >= 1) &&
+          (dict[i]->Slave <= *(context->slavecount)))
+      {
+         sl = &(context->slavelist[dict[i]->Slave]);
+         if ((sl->eep_man == dict[i]->eep_man) && (sl->eep_id == dict[i]->eep_id) &&
+             (sl->eep_rev == dict[i]->eep_rev))
+         {
+            continue;
+         }
+      }
+      ecx_ODdictstart(context, dict[i]);
+      if (dict[i]->state == EC_ODDICT_LIST)
+      {
+         ec_clearmbx(&MbxIn);
+         /* clear pending out mailbox in slave if available. Timeout is set to 0 */
+         ecx_mbxreceive(context, dict[i]->Slave, &MbxIn, 0);
+      }
+   }
+   memset(&poll, 0, sizeof(poll));
+   poll.slave = pslave;
+   do
+   {
+      busy = FALSE;
+      progress = FALSE;
+      for (first = 0; first < n; first = last)
+      {
+         last = ((n - first) > EC_MBXPOLLMULTI) ? (first + EC_MBXPOLLMULTI) : n;
+         /* one status poll for the slaves of the block waiting for a response,
+            mailboxes handled in the process data frames are read without it */
+         poll.nslaves = 0;
+         if (!context->mbxcyclic)
+         {
+            for (i = first; i < last; i++)
+            {
+               if (dict[i]->ninflight && (dict[i]->state < EC_ODDICT_DONE))
+               {
+                  poll.slave[poll.nslaves++].slave = dict[i]->Slave;
+               }
+            }
+            ecx_mbxpoll(context, &poll);
+         }
+         k = 0;
+         for (i = first; i < last; i++)
+         {
+            rxfull = ((dict[i]->state < EC_ODDICT_DONE) && context->mbxcyclic) ? TRUE : FALSE;
+            if (!context->mbxcyclic && dict[i]->ninflight && (dict[i]->state < EC_ODDICT_DONE))
+            {
+               rxfull = (poll.slave[k++].SMstat & 0x08) ? TRUE : FALSE;
+            }
+            prev = *dict[i];
+            if (ecx_ODdictstep(context, dict[i], rxfull, timeout))
+            {
+               busy = TRUE;
+            }
+            if ((dict[i]->state != prev.state) || (dict[i]->ninflight != prev.ninflight) ||
+                (dict[i]->sobj != prev.sobj) || (dict[i]->ssub != prev.ssub) ||
+                (dict[i]->robj != prev.robj) || (dict[i]->rsub != prev.rsub) ||
+                (dict[i]->frag != prev.frag))
+            {
+               progress = TRUE;
+            }
+         }
+      }
+      /* all slaves are waiting for their mailbox, give them time */
+      if (busy && !progress)
+      {
+         osal_usleep(EC_SDOPARAMIDLE);
+      }
+   } while (busy);
+   for (i = 0; i < n; i++)
+   {
+      cnt += (dict[i]->state == EC_ODDICT_DONE) ? 1 : 0;
+   }
+
+   return cnt;
+}
+
 #ifdef EC_VER1
 /** Report SDO error.
  *
@@ -1502,4 +2448,42 @@ int ec_readOE(uint16 Item, ec_ODlistt *pODlist, ec_OElistt *pOElist)
 {
    return ecx_readOE(&ecx_context, Item, pODlist, pOElist);
 }
+
+/** CoE SDO download of parameter sets to many slaves.
+ *
+ * @param[in,out] set     = parameter sets, one per slave
+ * @param[in]  nset       = number of parameter sets
+ * @param[in]  timeout    = timeout in us for the response of a download
+ * @return number of parameters written
+ * @see ecx_SDOwriteparams
+ */
+int ec_SDOwriteparams(ec_SDOparamsett *set, int nset, int timeout)
+{
+   return ecx_SDOwriteparams(&ecx_context, set, nset, timeout);
+}
+
+/** Check a loaded compact object dictionary.
+ *
+ * @param[in,out] dict    = loaded dictionary, size is set when valid
+ * @param[in]  size       = size of the block it is loaded in
+ * @return TRUE if valid
+ * @see ecx_ODdict_check
+ */
+boolean ec_ODdict_check(ec_ODdictt *dict, uint32 size)
+{
+   return ecx_ODdict_check(&ecx_context, dict, size);
+}
+
+/** CoE read object dictionaries of many slaves into compact object dictionaries.
+ *
+ * @param[in,out] dict    = dictionaries, set up by ec_ODdict_init() with the slave to read
+ * @param[in]  n          = number of dictionaries
+ * @param[in]  timeout    = timeout in us for each response, standard is EC_TIMEOUTRXM
+ * @return number of complete dictionaries
+ * @see ecx_readODdict
+ */
+int ec_readODdict(ec_ODdictt **dict, int n, int timeout)
+{
+   return ecx_readODdict(&ecx_context, dict, n, timeout);
+}
 #endif
@@ -58,6 +58,139 @@ typedef struct
    char   Name[EC_MAXOELIST][EC_MAXNAME+1];
 } ec_OElistt;
 
+/** max SDO information requests of one slave in flight in a dictionary upload */
+#define EC_SDOINFODEPTH   2
+/** compact object dictionary identification "ECOD" and layout version */
+#define EC_ODDICT_MAGIC    0x444f4345
+#define EC_ODDICT_VERSION  1
+
+/** States of a compact object dictionary */
+enum
+{
+   /** reading object list, descriptions or entries */
+   EC_ODDICT_LIST,
+   EC_ODDICT_DESC,
+   EC_ODDICT_ENTRY,
+   /** complete */
+   EC_ODDICT_DONE,
+   /** upload failed */
+   EC_ODDICT_ERROR
+};
+
+/** Object in a compact object dictionary */
+typedef struct
+{
+   uint16  Index;
+   /** datatype and object code, see EtherCAT specification */
+   uint16  DataType;
+   uint8   ObjectCode;
+   /** highest subindex */
+   uint8   MaxSub;
+   uint16  nu1;
+   /** offset of name in the dictionary, 0 if none */
+   uint32  name;
+   /** offset of entries of subindex 0 to MaxSub, 0 if the description was not read */
+   uint32  entry;
+} ec_ODobjt;
+
+/** Object entry in a compact object dictionary */
+typedef struct
+{
+   /** value info, see EtherCAT specification */
+   uint8   ValueInfo;
+   /** 1 if the slave described the entry */
+   uint8   valid;
+   /** datatype, bit length and object access bits, see EtherCAT specification */
+   uint16  DataType;
+   uint16  BitLength;
+   uint16  ObjAccess;
+   /** offset of name in the dictionary, 0 if none */
+   uint32  name;
+} ec_OEentryt;
+
+/** Compact object dictionary of one slave. This is the header of a caller
+ * supplied block, objects and entries are added after the header and names
+ * from the end of the block, all references are offsets in the block. After
+ * ec_ODdict_pack() the first end bytes can be saved as one block and be used
+ * again after ecx_ODdict_check().
+ */
+typedef struct
+{
+   uint32  magic;
+   uint16  version;
+   uint16  Slave;
+   /** identity of the slave the dictionary was read from */
+   uint32  eep_man;
+   uint32  eep_id;
+   uint32  eep_rev;
+   /** size of the block */
+   uint32  size;
+   /** end of objects and entries */
+   uint32  used;
+   /** start and end of names */
+   uint32  names;
+   uint32  end;
+   /** number of objects */
+   uint16  nobj;
+   /** EC_ODDICT_LIST to EC_ODDICT_ERROR */
+   uint16  state;
+   /** internal, request and response position of upload */
+   uint16  sobj;
+   uint16  ssub;
+   uint16  robj;
+   uint16  rsub;
+   /** internal, fragments left of last response and requests in flight */
+   uint16  frag;
+   uint16  ninflight;
+   osal_timert timer;
+} ec_ODdictt;
+
+/** max SDO downloads of one slave in flight in a parameter set download */
+#define EC_SDOPARAMDEPTH  2
+/** wait in us between turns of a parameter set download that made no progress */
+#ifndef EC_SDOPARAMIDLE
+#define EC_SDOPARAMIDLE   200
+#endif
+
+/** One parameter of a parameter set */
+typedef struct
+{
+   uint16  Index;
+   uint8   SubIndex;
+   /** size of data in bytes */
+   int     psize;
+   void    *p;
+   /** 1 if written, 0 if not written, EC_ERROR if aborted, EC_TIMEOUT if no response */
+   int     result;
+   /** SDO abort code if aborted */
+   int32   AbortCode;
+} ec_SDOparamt;
+
+/** SDO download in flight, internal to ecx_SDOwriteparams() */
+typedef struct
+{
+   /** first parameter and number of parameters in download */
+   int         first;
+   int         count;
+   boolean     CA;
+   osal_timert timer;
+} ec_SDOparamxfert;
+
+/** Parameter set of one slave */
+typedef struct
+{
+   uint16  Slave;
+   /** number of parameters */
+   int     n;
+   ec_SDOparamt *param;
+   /** internal state, parameters before single are written per subindex
+    * after an aborted Complete Access */
+   int     next;
+   int     single;
+   int     ninflight;
+   ec_SDOparamxfert inflight[EC_SDOPARAMDEPTH];
+} ec_SDOparamsett;
+
 #ifdef EC_VER1
 void ec_SDOerror(uint16 Slave, uint16 Index, uint8 SubIdx, int32 AbortCode);
 int ec_SDOread(uint16 slave, uint16 index, uint8 subindex,
@@ -72,8 +205,18 @@ int ec_readODlist(uint16 Slave, ec_ODlistt *pODlist);
 int ec_readODdescription(uint16 Item, ec_ODlistt *pODlist);
 int ec_readOEsingle(uint16 Item, uint8 SubI, ec_ODlistt *pODlist, ec_OElistt *pOElist);
 int ec_readOE(uint16 Item, ec_ODlistt *pODlist, ec_OElistt *pOElist);
+int ec_SDOwriteparams(ec_SDOparamsett *set, int nset, int timeout);
+boolean ec_ODdict_check(ec_ODdictt *dict, uint32 size);
+int ec_readODdict(ec_ODdictt **dict, int n, int timeout);
 #endif
 
+int ec_ODdict_init(ec_ODdictt *dict, uint32 size, uint16 Slave);
+uint32 ec_ODdict_pack(ec_ODdictt *dict);
+ec_ODobjt *ec_ODdict_obj(ec_ODdictt *dict, uint16 n);
+ec_ODobjt *ec_ODdict_find(ec_ODdictt *dict, uint16 Index);
+ec_OEentryt *ec_ODdict_entry(ec_ODdictt *dict, ec_ODobjt *obj, uint8 SubIndex);
+const char *ec_ODdict_name(ec_ODdictt *dict, uint32 name);
+
 void ecx_SDOerror(ecx_contextt *context, uint16 Slave, uint16 Index, uint8 SubIdx, int32 AbortCode);
 int ecx_SDOread(ecx_contextt *context, uint16 slave, uint16 index, uint8 subindex,
                       boolean CA, int *psize, void *p, int timeout);
@@ -87,6 +230,9 @@ int ecx_readODlist(ecx_contextt *context, uint16 Slave, ec_ODlistt *pODlist);
 int ecx_readODdescription(ecx_contextt *context, uint16 Item, ec_ODlistt *pODlist);
 int ecx_readOEsingle(ecx_contextt *context, uint16 Item, uint8 SubI, ec_ODlistt *pODlist, ec_OElistt *pOElist);
 int ecx_readOE(ecx_contextt *context, uint16 Item, ec_ODlistt *pODlist, ec_OElistt *pOElist);
+int ecx_SDOwriteparams(ecx_contextt *context, ec_SDOparamsett *set, int nset, int timeout);
+boolean ecx_ODdict_check(ecx_contextt *context, ec_ODdictt *dict, uint32 size);
+int ecx_readODdict(ecx_contextt *context, ec_ODdictt **dict, int n, int timeout);
 
 #ifdef __cplusplus
 }
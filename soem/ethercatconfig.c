@@ -23,18 +23,48 @@
 #include "ethercatconfig.h"
 
 
+typedef struct ecx_mappool ecx_mappoolt;
+
+/** Mapping stage, executed by the mapping pool for every slave of the group */
+typedef int (*ecx_mapstaget)(ecx_mappoolt *pool, uint16 slave, int thread_n);
+
+#if EC_MAX_MAPT > 1
+/** Worker thread of the mapping pool */
 typedef struct
 {
+   ecx_mappoolt *pool;
+   /** index of thread specific mapping buffers in context */
    int thread_n;
-   int running;
+} ecx_mapworkert;
+#endif
+
+/** Worker pool for slave mapping. The calling thread works as thread 0 next to
+ * EC_MAX_MAPT - 1 worker threads. Each stage hands out the slaves of the group
+ * one at a time and returns when all slaves are done.
+ */
+struct ecx_mappool
+{
    ecx_contextt *context;
+   uint8 group;
+   /** current stage, NULL stops the workers */
+   ecx_mapstaget stage;
+   /** next slave to hand out */
    uint16 slave;
-} ecx_mapt_t;
-
-ecx_mapt_t ecx_mapt[EC_MAX_MAPT];
 #if EC_MAX_MAPT > 1
-OSAL_THREAD_HANDLE ecx_threadh[EC_MAX_MAPT];
+   osal_mutex_t *mtx;
+   /** serialises SII access, the SII reader state in context is shared */
+   osal_mutex_t *siimtx;
+   /** posted once per worker to start a stage */
+   osal_sem_t *work;
+   /** posted by the last worker finishing a stage */
+   osal_sem_t *done;
+   /** workers not finished with the current stage */
+   int active;
+   int workers;
+   ecx_mapworkert worker[EC_MAX_MAPT];
+   OSAL_THREAD_HANDLE threadh[EC_MAX_MAPT];
 #endif
+};
 
 #ifdef EC_VER1
 /** Slave configuration structure */
@@ -107,8 +137,11 @@ void ecx_init_context(ecx_contextt *context)
    /* clean ec_slave array */
    memset(context->slavelist, 0x00, sizeof(ec_slavet) * context->maxslave);
    memset(context->grouplist, 0x00, sizeof(ec_groupt) * context->maxgroup);
-   /* clear slave eeprom cache, does not actually read any eeprom */
+   /* deselect slave in eeprom cache, does not actually read any eeprom.
+    * Per slave cached content is kept while the slave identity stays the same,
+    * the SII checksum of each slave is probed again at its next access */
    ecx_siigetbyte(context, 0, EC_MAXEEPBUF);
+   ecx_siirecheck(context, 0);
    for(lp = 0; lp < context->maxgroup; lp++)
    {
       /* default start address per group entry */
@@ -134,14 +167,14 @@ int ecx_detect_slaves(ecx_contextt *context)
    if (wkc > 0)
    {
       /* this is strictly "less than" since the master is "slave 0" */
-      if (wkc < EC_MAXSLAVE)
+      if (wkc < context->maxslave)
       {
          *(context->slavecount) = wkc;
       }
       else
       {
-         EC_PRINT("Error: too many slaves on network: num_slaves=%d, EC_MAXSLAVE=%d\n",
-               wkc, EC_MAXSLAVE);
+         EC_PRINT("Error: too many slaves on network: num_slaves=%d, maxslave=%d\n",
+               wkc, context->maxslave);
          return EC_SLAVECOUNTEXCEEDED;
       }
    }
@@ -299,103 +332,107 @@ static int ecx_lookup_prev_sii(ecx_contextt *context, uint16 slave)
    return 0;
 }
 
-/** Enumerate and init all slaves.
+/** Set station address of all slaves and read their interface type, alias and
+ * EEPROM status. The registers of EC_CONFIGMULTI slaves at a time are accessed
+ * with one batched register access. A slave whose station address could not
+ * be written or read back gets a packet error.
  *
  * @param[in] context      = context struct
- * @param[in] usetable     = TRUE when using configtable to init slaves, FALSE otherwise
- * @return Workcounter of slave discover datagram = number of slaves found
+ * @return number of slaves without station address
  */
-int ecx_config_init(ecx_contextt *context, uint8 usetable)
+static int ecx_config_address(ecx_contextt *context)
 {
-   uint16 slave, ADPh, configadr, ssigen;
-   uint16 topology, estat;
-   int16 topoc, slavec, aliasadr;
-   uint8 b,h;
-   uint8 SMc;
-   uint32 eedat;
-   int wkc, cindex, nSM;
-   uint16 val16;
+   ec_multidgt dg[EC_CONFIGMULTI * 6];
+   uint16 reg[EC_CONFIGMULTI][6];
+   uint16 slave, fslave, ADPh;
+   int i, k, nfail = 0;
 
-   EC_PRINT("ec_config_init %d\n",usetable);
-   ecx_init_context(context);
-   wkc = ecx_detect_slaves(context);
-   if (wkc > 0)
+   for (fslave = 1; fslave <= *(context->slavecount); fslave += EC_CONFIGMULTI)
    {
-      ecx_set_slaves_to_default(context);
-      for (slave = 1; slave <= *(context->slavecount); slave++)
+      k = 0;
+      for (i = 0; (i < EC_CONFIGMULTI) && ((fslave + i) <= *(context->slavecount)); i++)
       {
+         slave = fslave + i;
          ADPh = (uint16)(1 - slave);
-         val16 = ecx_APRDw(context->port, ADPh, ECT_REG_PDICTL, EC_TIMEOUTRET3); /* read interface type of slave */
-         context->slavelist[slave].Itype = etohs(val16);
          /* a node offset is used to improve readability of network frames */
          /* this has no impact on the number of addressable slaves (auto wrap around) */
-         ecx_APWRw(context->port, ADPh, ECT_REG_STADR, htoes(slave + EC_NODEOFFSET) , EC_TIMEOUTRET3); /* set node address of slave */
-         if (slave == 1)
-         {
-            b = 1; /* kill non ecat frames for first slave */
-         }
-         else
+         reg[i][1] = htoes(slave + EC_NODEOFFSET);
+         /* kill non ecat frames for first slave, pass all frames for following slaves */
+         reg[i][2] = htoes((slave == 1) ? 1 : 0);
+         /* interface type, node address, non ecat frame behaviour, read back node address */
+         ecx_multidg(&dg[k++], EC_CMD_APRD, ADPh, ECT_REG_PDICTL, sizeof(uint16), &reg[i][0]);
+         ecx_multidg(&dg[k++], EC_CMD_APWR, ADPh, ECT_REG_STADR, sizeof(uint16), &reg[i][1]);
+         ecx_multidg(&dg[k++], EC_CMD_APWR, ADPh, ECT_REG_DLCTL, sizeof(uint16), &reg[i][2]);
+         ecx_multidg(&dg[k++], EC_CMD_APRD, ADPh, ECT_REG_STADR, sizeof(uint16), &reg[i][3]);
+         ecx_multidg(&dg[k++], EC_CMD_APRD, ADPh, ECT_REG_ALIAS, sizeof(uint16), &reg[i][4]);
+         ecx_multidg(&dg[k++], EC_CMD_APRD, ADPh, ECT_REG_EEPSTAT, sizeof(uint16), &reg[i][5]);
+      }
+      ecx_multirw(context->port, dg, k, EC_TIMEOUTRET3);
+      for (i = 0; i < (k / 6); i++)
+      {
+         slave = fslave + i;
+         context->slavelist[slave].Itype = (dg[i * 6].wkc > 0) ? etohs(reg[i][0]) : 0;
+         context->slavelist[slave].configadr = (dg[i * 6 + 3].wkc > 0) ? etohs(reg[i][3]) : 0;
+         context->slavelist[slave].aliasadr = (dg[i * 6 + 4].wkc > 0) ? etohs(reg[i][4]) : 0;
+         if ((dg[i * 6 + 5].wkc > 0) && (etohs(reg[i][5]) & EC_ESTAT_R64)) /* check if slave can read 8 byte chunks */
          {
-            b = 0; /* pass all frames for following slaves */
+            context->slavelist[slave].eep_8byte = 1;
          }
-         ecx_APWRw(context->port, ADPh, ECT_REG_DLCTL, htoes(b), EC_TIMEOUTRET3); /* set non ecat frame behaviour */
-         configadr = ecx_APRDw(context->port, ADPh, ECT_REG_STADR, EC_TIMEOUTRET3);
-         configadr = etohs(configadr);
-         context->slavelist[slave].configadr = configadr;
-         ecx_FPRD(context->port, configadr, ECT_REG_ALIAS, sizeof(aliasadr), &aliasadr, EC_TIMEOUTRET3);
-         context->slavelist[slave].aliasadr = etohs(aliasadr);
-         ecx_FPRD(context->port, configadr, ECT_REG_EEPSTAT, sizeof(estat), &estat, EC_TIMEOUTRET3);
-         estat = etohs(estat);
-         if (estat & EC_ESTAT_R64) /* check if slave can read 8 byte chunks */
+         if ((dg[i * 6 + 1].wkc <= 0) || (dg[i * 6 + 3].wkc <= 0))
          {
-            context->slavelist[slave].eep_8byte = 1;
+            ecx_packeterror(context, slave, ECT_REG_STADR, 0, 4); /* no response */
+            nfail++;
          }
-         ecx_readeeprom1(context, slave, ECT_SII_MANUF); /* Manuf */
       }
-      for (slave = 1; slave <= *(context->slavecount); slave++)
-      {
-         eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP); /* Manuf */
-         context->slavelist[slave].eep_man = etohl(eedat);
-         ecx_readeeprom1(context, slave, ECT_SII_ID); /* ID */
-      }
-      for (slave = 1; slave <= *(context->slavecount); slave++)
-      {
-         eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP); /* ID */
-         context->slavelist[slave].eep_id = etohl(eedat);
-         ecx_readeeprom1(context, slave, ECT_SII_REV); /* revision */
-      }
-      for (slave = 1; slave <= *(context->slavecount); slave++)
-      {
-         eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP); /* revision */
-         context->slavelist[slave].eep_rev = etohl(eedat);
-         ecx_readeeprom1(context, slave, ECT_SII_RXMBXADR); /* write mailbox address + mailboxsize */
-      }
-      for (slave = 1; slave <= *(context->slavecount); slave++)
+   }
+
+   return nfail;
+}
+
+/** Read DC support, port status and physical type of all slaves with one
+ * batched register access per EC_CONFIGMULTI slaves. A slave that does not
+ * answer gets a packet error.
+ *
+ * @param[in] context      = context struct
+ * @return number of slaves that did not answer
+ */
+static int ecx_config_ports(ecx_contextt *context)
+{
+   ec_multidgt dg[EC_CONFIGMULTI * 3];
+   uint16 reg[EC_CONFIGMULTI][3];
+   uint16 slave, fslave, configadr, topology;
+   uint8 b, h;
+   int i, k, nfail = 0;
+
+   for (fslave = 1; fslave <= *(context->slavecount); fslave += EC_CONFIGMULTI)
+   {
+      k = 0;
+      for (i = 0; (i < EC_CONFIGMULTI) && ((fslave + i) <= *(context->slavecount)); i++)
       {
-         eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP); /* write mailbox address and mailboxsize */
-         context->slavelist[slave].mbx_wo = (uint16)LO_WORD(etohl(eedat));
-         context->slavelist[slave].mbx_l = (uint16)HI_WORD(etohl(eedat));
-         if (context->slavelist[slave].mbx_l > 0)
-         {
-            ecx_readeeprom1(context, slave, ECT_SII_TXMBXADR); /* read mailbox offset */
-         }
+         configadr = context->slavelist[fslave + i].configadr;
+         ecx_multidg(&dg[k++], EC_CMD_FPRD, configadr, ECT_REG_ESCSUP, sizeof(uint16), &reg[i][0]);
+         ecx_multidg(&dg[k++], EC_CMD_FPRD, configadr, ECT_REG_DLSTAT, sizeof(uint16), &reg[i][1]);
+         ecx_multidg(&dg[k++], EC_CMD_FPRD, configadr, ECT_REG_PORTDES, sizeof(uint16), &reg[i][2]);
       }
-      for (slave = 1; slave <= *(context->slavecount); slave++)
+      ecx_multirw(context->port, dg, k, EC_TIMEOUTRET3);
+      for (i = 0; i < (k / 3); i++)
       {
-         if (context->slavelist[slave].mbx_l > 0)
+         slave = fslave + i;
+         h = 0;
+         for (b = 0; b < 3; b++)
          {
-            eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP); /* read mailbox offset */
-            context->slavelist[slave].mbx_ro = (uint16)LO_WORD(etohl(eedat)); /* read mailbox offset */
-            context->slavelist[slave].mbx_rl = (uint16)HI_WORD(etohl(eedat)); /*read mailbox length */
-            if (context->slavelist[slave].mbx_rl == 0)
+            if (dg[i * 3 + b].wkc <= 0)
             {
-               context->slavelist[slave].mbx_rl = context->slavelist[slave].mbx_l;
+               reg[i][b] = 0;
+               h = 1;
             }
-            ecx_readeeprom1(context, slave, ECT_SII_MBXPROTO);
          }
-         configadr = context->slavelist[slave].configadr;
-         val16 = ecx_FPRDw(context->port, configadr, ECT_REG_ESCSUP, EC_TIMEOUTRET3);
-         if ((etohs(val16) & 0x04) > 0)  /* Support DC? */
+         if (h)
+         {
+            ecx_packeterror(context, slave, ECT_REG_DLSTAT, 0, 4); /* no response */
+            nfail++;
+         }
+         if ((etohs(reg[i][0]) & 0x04) > 0)  /* Support DC? */
          {
             context->slavelist[slave].hasdc = TRUE;
          }
@@ -403,8 +440,7 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable)
          {
             context->slavelist[slave].hasdc = FALSE;
          }
-         topology = ecx_FPRDw(context->port, configadr, ECT_REG_DLSTAT, EC_TIMEOUTRET3); /* extract topology from DL status */
-         topology = etohs(topology);
+         topology = etohs(reg[i][1]); /* extract topology from DL status */
          h = 0;
          b = 0;
          if ((topology & 0x0300) == 0x0200) /* port0 open and communication established */
@@ -428,10 +464,114 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable)
             b |= 0x08;
          }
          /* ptype = Physical type*/
-         val16 = ecx_FPRDw(context->port, configadr, ECT_REG_PORTDES, EC_TIMEOUTRET3);
-         context->slavelist[slave].ptype = LO_BYTE(etohs(val16));
+         context->slavelist[slave].ptype = LO_BYTE(etohs(reg[i][2]));
          context->slavelist[slave].topology = h;
          context->slavelist[slave].activeports = b;
+      }
+   }
+
+   return nfail;
+}
+
+/** Read identity and mailbox setup of a block of slaves from EEPROM, each
+ * item is read from all slaves of the block at once.
+ *
+ * @param[in] context      = context struct
+ * @param[in] first        = first slave of block
+ * @param[in] n            = number of slaves in block, max EC_EEPMULTI
+ */
+static void ecx_config_eeprom(ecx_contextt *context, uint16 first, int n)
+{
+   uint32 eedatlst[EC_EEPMULTI];
+   uint16 slavelst[EC_EEPMULTI];
+   uint16 slave;
+   int i, m;
+
+   for (i = 0; i < n; i++)
+   {
+      slavelst[i] = (uint16)(first + i);
+   }
+   ecx_readeeprom_multi(context, n, slavelst, ECT_SII_MANUF, eedatlst, EC_TIMEOUTEEP); /* Manuf */
+   for (i = 0; i < n; i++)
+   {
+      context->slavelist[slavelst[i]].eep_man = etohl(eedatlst[i]);
+   }
+   ecx_readeeprom_multi(context, n, slavelst, ECT_SII_ID, eedatlst, EC_TIMEOUTEEP); /* ID */
+   for (i = 0; i < n; i++)
+   {
+      context->slavelist[slavelst[i]].eep_id = etohl(eedatlst[i]);
+   }
+   ecx_readeeprom_multi(context, n, slavelst, ECT_SII_REV, eedatlst, EC_TIMEOUTEEP); /* revision */
+   for (i = 0; i < n; i++)
+   {
+      context->slavelist[slavelst[i]].eep_rev = etohl(eedatlst[i]);
+   }
+   ecx_readeeprom_multi(context, n, slavelst, ECT_SII_RXMBXADR, eedatlst, EC_TIMEOUTEEP); /* write mailbox address + mailboxsize */
+   m = 0;
+   for (i = 0; i < n; i++)
+   {
+      slave = slavelst[i];
+      context->slavelist[slave].mbx_wo = (uint16)LO_WORD(etohl(eedatlst[i]));
+      context->slavelist[slave].mbx_l = (uint16)HI_WORD(etohl(eedatlst[i]));
+      if (context->slavelist[slave].mbx_l > 0)
+      {
+         slavelst[m++] = slave;
+      }
+   }
+   /* slaves with mailbox only */
+   ecx_readeeprom_multi(context, m, slavelst, ECT_SII_TXMBXADR, eedatlst, EC_TIMEOUTEEP); /* read mailbox offset */
+   for (i = 0; i < m; i++)
+   {
+      slave = slavelst[i];
+      context->slavelist[slave].mbx_ro = (uint16)LO_WORD(etohl(eedatlst[i])); /* read mailbox offset */
+      context->slavelist[slave].mbx_rl = (uint16)HI_WORD(etohl(eedatlst[i])); /*read mailbox length */
+      if (context->slavelist[slave].mbx_rl == 0)
+      {
+         context->slavelist[slave].mbx_rl = context->slavelist[slave].mbx_l;
+      }
+   }
+   ecx_readeeprom_multi(context, m, slavelst, ECT_SII_MBXPROTO, eedatlst, EC_TIMEOUTEEP);
+   for (i = 0; i < m; i++)
+   {
+      context->slavelist[slavelst[i]].mbx_proto = (uint16)etohl(eedatlst[i]);
+   }
+}
+
+/** Enumerate and init all slaves.
+ *
+ * @param[in] context      = context struct
+ * @param[in] usetable     = TRUE when using configtable to init slaves, FALSE otherwise
+ * @return Workcounter of slave discover datagram = number of slaves found,
+ * 0 if a station address could not be set
+ */
+int ecx_config_init(ecx_contextt *context, uint8 usetable)
+{
+   uint16 slave, configadr, ssigen;
+   uint16 topology;
+   int16 topoc, slavec;
+   uint8 SMc;
+   int wkc, cindex, nSM, n;
+
+   EC_PRINT("ec_config_init %d\n",usetable);
+   ecx_init_context(context);
+   wkc = ecx_detect_slaves(context);
+   if (wkc > 0)
+   {
+      ecx_set_slaves_to_default(context);
+      if (ecx_config_address(context) > 0)
+      {
+         return 0; /* slave(s) without station address, see packet errors */
+      }
+      /* identity and mailbox setup from EEPROM, in blocks of slaves */
+      for (slave = 1; slave <= *(context->slavecount); slave += EC_EEPMULTI)
+      {
+         n = *(context->slavecount) - slave + 1;
+         ecx_config_eeprom(context, slave, (n > EC_EEPMULTI) ? EC_EEPMULTI : n);
+      }
+      ecx_config_ports(context);
+      for (slave = 1; slave <= *(context->slavecount); slave++)
+      {
+         configadr = context->slavelist[slave].configadr;
          /* 0=no links, not possible             */
          /* 1=1 link  , end of line              */
          /* 2=2 links , one before and one after */
@@ -483,8 +623,6 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable)
             context->slavelist[slave].SM[1].StartAddr = htoes(context->slavelist[slave].mbx_ro);
             context->slavelist[slave].SM[1].SMlength = htoes(context->slavelist[slave].mbx_rl);
             context->slavelist[slave].SM[1].SMflags = htoel(EC_DEFAULTMBXSM1);
-            eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP);
-            context->slavelist[slave].mbx_proto = etohl(eedat);
          }
          cindex = 0;
          /* use configuration table ? */
@@ -638,6 +776,195 @@ static int ecx_lookup_mapping(ecx_contextt *context, uint16 slave, int *Osize, i
    return 0;
 }
 
+/** Find mapping snapshot entry of slave. The entry is only valid if identity
+ * and topology of the slave match the slave the mapping was taken from.
+ *
+ * @param[in] context      = context struct
+ * @param[in] slave        = slave number
+ * @return snapshot entry or NULL if there is none for the slave
+ */
+static ec_mapslavet *ecx_mapsnap_find(ecx_contextt *context, uint16 slave)
+{
+   ec_mapslavet *ms;
+   ec_slavet *sl;
+
+   if (!context->mapsnap)
+   {
+      return NULL;
+   }
+   ms = &(context->mapsnap->slave[slave]);
+   sl = &(context->slavelist[slave]);
+   if (!ms->valid ||
+       (ms->eep_man != sl->eep_man) || (ms->eep_id != sl->eep_id) || (ms->eep_rev != sl->eep_rev) ||
+       (ms->topology != sl->topology) || (ms->activeports != sl->activeports) || (ms->parent != sl->parent))
+   {
+      return NULL;
+   }
+
+   return ms;
+}
+
+/** Read CoE PDO assign list of one SM into the PDOassign buffer of the
+ * thread, with one Complete Access read if the slave supports it.
+ *
+ * @param[in] context      = context struct
+ * @param[in] slave        = slave number
+ * @param[in] thread_n     = mapping thread, selects the PDOassign buffer
+ * @param[in] nSM          = SM number
+ * @return 1 if the list was read, 0 otherwise
+ */
+static int ecx_mapsnap_readassign(ecx_contextt *context, uint16 slave, int thread_n, uint8 nSM)
+{
+   ec_PDOassignt *pa;
+   uint16 idx;
+   int wkc, rdl, i;
+
+   pa = &(context->PDOassign[thread_n]);
+   pa->n = 0;
+   if (context->slavelist[slave].CoEdetails & ECT_COEDET_SDOCA)
+   {
+      rdl = sizeof(ec_PDOassignt);
+      wkc = ecx_SDOread(context, slave, ECT_SDO_PDOASSIGN + nSM, 0x00, TRUE, &rdl, pa, EC_TIMEOUTRXM);
+      return (wkc > 0) ? 1 : 0;
+   }
+   rdl = sizeof(pa->n);
+   wkc = ecx_SDOread(context, slave, ECT_SDO_PDOASSIGN + nSM, 0x00, FALSE, &rdl, &(pa->n), EC_TIMEOUTRXM);
+   for (i = 0; (wkc > 0) && (i < pa->n); i++)
+   {
+      rdl = sizeof(idx);
+      idx = 0;
+      wkc = ecx_SDOread(context, slave, ECT_SDO_PDOASSIGN + nSM, (uint8)(i + 1), FALSE, &rdl, &idx, EC_TIMEOUTRXM);
+      pa->index[i] = idx;
+   }
+
+   return (wkc > 0) ? 1 : 0;
+}
+
+/** Use mapping of slave from mapping snapshot. The PDO assign lists held in
+ * the entry are read back from the slave first, on a difference the entry is
+ * dropped and the mapping is discovered again.
+ *
+ * @param[in] context      = context struct
+ * @param[in] slave        = slave number
+ * @param[in] thread_n     = mapping thread
+ * @return 1 if mapping was taken from the snapshot, 0 if discovery is needed
+ */
+static int ecx_mapsnap_apply(ecx_contextt *context, uint16 slave, int thread_n)
+{
+   ec_mapslavet *ms;
+   ec_slavet *sl;
+   int nSM, i;
+
+   ms = ecx_mapsnap_find(context, slave);
+   if (!ms)
+   {
+      return 0;
+   }
+   for (nSM = 2; nSM < EC_MAXSM; nSM++)
+   {
+      if (!(ms->assignmask & (1 << nSM)))
+      {
+         continue;
+      }
+      if (!ecx_mapsnap_readassign(context, slave, thread_n, (uint8)nSM) ||
+          (context->PDOassign[thread_n].n != ms->nassign[nSM]))
+      {
+         break;
+      }
+      i = 0;
+      while ((i < ms->nassign[nSM]) && (etohs(context->PDOassign[thread_n].index[i]) == ms->assign[nSM][i]))
+      {
+         i++;
+      }
+      if (i < ms->nassign[nSM])
+      {
+         break;
+      }
+   }
+   if (nSM < EC_MAXSM)
+   {
+      EC_PRINT("  Snapshot PDO assign of SM%d changed\n", nSM);
+      ms->valid = 0;
+      return 0;
+   }
+   sl = &(context->slavelist[slave]);
+   for (nSM = 0; nSM < EC_MAXSM; nSM++)
+   {
+      sl->SM[nSM] = ms->SM[nSM];
+      sl->SMtype[nSM] = ms->SMtype[nSM];
+   }
+   sl->FMMU0func = ms->FMMUfunc[0];
+   sl->FMMU1func = ms->FMMUfunc[1];
+   sl->FMMU2func = ms->FMMUfunc[2];
+   sl->FMMU3func = ms->FMMUfunc[3];
+   sl->Obits = ms->Obits;
+   sl->Ibits = ms->Ibits;
+   EC_PRINT("  Snapshot Osize:%d Isize:%d\n", sl->Obits, sl->Ibits);
+
+   return 1;
+}
+
+/** Store mapping of slave in mapping snapshot. For CoE slaves the PDO assign
+ * lists of the process data SMs are read and stored with it, a slave with a
+ * list longer than EC_MAXMAPASSIGN is not stored.
+ *
+ * @param[in] context      = context struct
+ * @param[in] slave        = slave number
+ */
+static void ecx_mapsnap_store(ecx_contextt *context, uint16 slave)
+{
+   ec_mapslavet *ms;
+   ec_slavet *sl;
+   int nSM, i;
+
+   if (!context->mapsnap)
+   {
+      return;
+   }
+   ms = &(context->mapsnap->slave[slave]);
+   sl = &(context->slavelist[slave]);
+   memset(ms, 0x00, sizeof(*ms));
+   ms->topology = sl->topology;
+   ms->activeports = sl->activeports;
+   ms->parent = sl->parent;
+   ms->eep_man = sl->eep_man;
+   ms->eep_id = sl->eep_id;
+   ms->eep_rev = sl->eep_rev;
+   ms->Obits = sl->Obits;
+   ms->Ibits = sl->Ibits;
+   for (nSM = 0; nSM < EC_MAXSM; nSM++)
+   {
+      ms->SM[nSM] = sl->SM[nSM];
+      ms->SMtype[nSM] = sl->SMtype[nSM];
+   }
+   ms->FMMUfunc[0] = sl->FMMU0func;
+   ms->FMMUfunc[1] = sl->FMMU1func;
+   ms->FMMUfunc[2] = sl->FMMU2func;
+   ms->FMMUfunc[3] = sl->FMMU3func;
+   if (sl->mbx_proto & ECT_MBXPROT_COE)
+   {
+      for (nSM = 2; nSM < EC_MAXSM; nSM++)
+      {
+         if (((sl->SMtype[nSM] != 3) && (sl->SMtype[nSM] != 4)) ||
+             !ecx_mapsnap_readassign(context, slave, 0, (uint8)nSM))
+         {
+            continue;
+         }
+         if (context->PDOassign[0].n > EC_MAXMAPASSIGN)
+         {
+            return;
+         }
+         ms->nassign[nSM] = context->PDOassign[0].n;
+         for (i = 0; i < ms->nassign[nSM]; i++)
+         {
+            ms->assign[nSM][i] = etohs(context->PDOassign[0].index[i]);
+         }
+         ms->assignmask |= (uint8)(1 << nSM);
+      }
+   }
+   ms->valid = 1;
+}
+
 static int ecx_map_coe_soe(ecx_contextt *context, uint16 slave, int thread_n)
 {
    int Isize, Osize;
@@ -657,8 +984,8 @@ static int ecx_map_coe_soe(ecx_contextt *context, uint16 slave, int thread_n)
    {
       context->slavelist[slave].PO2SOconfigx(context, slave);
    }
-   /* if slave not found in configlist find IO mapping in slave self */
-   if (!context->slavelist[slave].configindex)
+   /* if slave not found in configlist or snapshot find IO mapping in slave self */
+   if (!context->slavelist[slave].configindex && !ecx_mapsnap_apply(context, slave, thread_n))
    {
       Isize = 0;
       Osize = 0;
@@ -701,6 +1028,10 @@ static int ecx_map_sii(ecx_contextt *context, uint16 slave)
    Osize = context->slavelist[slave].Obits;
    Isize = context->slavelist[slave].Ibits;
 
+   if (ecx_mapsnap_find(context, slave)) /* mapping from snapshot */
+   {
+      return 1;
+   }
    if (!Isize && !Osize) /* find PDO in previous slave with same ID */
    {
       (void)ecx_lookup_mapping(context, slave, &Osize, &Isize);
@@ -802,93 +1133,220 @@ static int ecx_map_sm(ecx_contextt *context, uint16 slave)
    return 1;
 }
 
+/** Hand out next slave of the group.
+ *
+ * @param[in] pool         = mapping pool
+ * @return slave number, 0 when all slaves are handed out
+ */
+static uint16 ecx_mappool_take(ecx_mappoolt *pool)
+{
+   ecx_contextt *context = pool->context;
+   uint16 slave = 0;
+
+#if EC_MAX_MAPT > 1
+   if (pool->workers)
+   {
+      osal_mtx_lock(pool->mtx);
+   }
+#endif
+   while ((pool->slave <= *(context->slavecount)) &&
+          pool->group && (pool->group != context->slavelist[pool->slave].group))
+   {
+      pool->slave++;
+   }
+   if (pool->slave <= *(context->slavecount))
+   {
+      slave = pool->slave++;
+   }
+#if EC_MAX_MAPT > 1
+   if (pool->workers)
+   {
+      osal_mtx_unlock(pool->mtx);
+   }
+#endif
+
+   return slave;
+}
+
+/** Execute current stage for slaves until all slaves are handed out.
+ *
+ * @param[in] pool         = mapping pool
+ * @param[in] thread_n     = index of thread specific mapping buffers
+ */
+static void ecx_mappool_exec(ecx_mappoolt *pool, int thread_n)
+{
+   uint16 slave;
+
+   while ((slave = ecx_mappool_take(pool)) > 0)
+   {
+      pool->stage(pool, slave, thread_n);
+   }
+}
+
 #if EC_MAX_MAPT > 1
 OSAL_THREAD_FUNC ecx_mapper_thread(void *param)
 {
-   ecx_mapt_t *maptp;
-   maptp = param;
-   ecx_map_coe_soe(maptp->context, maptp->slave, maptp->thread_n);
-   maptp->running = 0;
+   ecx_mapworkert *worker = param;
+   ecx_mappoolt *pool = worker->pool;
+   boolean stop, last;
+
+   do
+   {
+      osal_sem_wait(pool->work);
+      stop = (pool->stage == NULL);
+      if (!stop)
+      {
+         ecx_mappool_exec(pool, worker->thread_n);
+      }
+      osal_mtx_lock(pool->mtx);
+      last = (--pool->active == 0);
+      osal_mtx_unlock(pool->mtx);
+      /* pool may be released as soon as done is posted */
+      if (last)
+      {
+         osal_sem_post(pool->done);
+      }
+   } while (!stop);
 }
+#endif
 
-static int ecx_find_mapt(void)
+/** Run mapping stage for all slaves of the group and wait until it is done.
+ *
+ * @param[in] pool         = mapping pool
+ * @param[in] stage        = stage to run, NULL stops the workers
+ */
+static void ecx_mappool_stage(ecx_mappoolt *pool, ecx_mapstaget stage)
 {
-   int p;
-   p = 0;
-   while((p < EC_MAX_MAPT) && ecx_mapt[p].running)
+#if EC_MAX_MAPT > 1
+   int i;
+#endif
+
+   pool->stage = stage;
+   pool->slave = 1;
+#if EC_MAX_MAPT > 1
+   pool->active = pool->workers;
+   for (i = 0; i < pool->workers; i++)
    {
-      p++;
+      osal_sem_post(pool->work);
    }
-   if(p < EC_MAX_MAPT)
+#endif
+   if (stage)
    {
-      return p;
+      ecx_mappool_exec(pool, 0);
    }
-   else
+#if EC_MAX_MAPT > 1
+   if (pool->workers)
    {
-      return -1;
+      osal_sem_wait(pool->done);
    }
-}
 #endif
+}
 
-static int ecx_get_threadcount(void)
+/** Start mapping pool. When no worker can be started the calling thread
+ * executes all stages alone.
+ *
+ * @param[out] pool        = mapping pool
+ * @param[in]  context     = context struct
+ * @param[in]  group       = group number, 0 for all slaves
+ */
+static void ecx_mappool_start(ecx_mappoolt *pool, ecx_contextt *context, uint8 group)
 {
-   int thrc, thrn;
-   thrc = 0;
-   for(thrn = 0 ; thrn < EC_MAX_MAPT ; thrn++)
+   memset(pool, 0, sizeof(*pool));
+   pool->context = context;
+   pool->group = group;
+#if EC_MAX_MAPT > 1
+   pool->mtx = osal_mtx_create();
+   pool->siimtx = osal_mtx_create();
+   pool->work = osal_sem_create(0);
+   pool->done = osal_sem_create(0);
+   if (pool->mtx && pool->siimtx && pool->work && pool->done)
    {
-      thrc += ecx_mapt[thrn].running;
+      while (pool->workers < (EC_MAX_MAPT - 1))
+      {
+         pool->worker[pool->workers].pool = pool;
+         pool->worker[pool->workers].thread_n = pool->workers + 1;
+         if (!osal_thread_create(&(pool->threadh[pool->workers]), 128000,
+               &ecx_mapper_thread, &(pool->worker[pool->workers])))
+         {
+            break;
+         }
+         pool->workers++;
+      }
    }
-   return thrc;
+#endif
 }
 
-static void ecx_config_find_mappings(ecx_contextt *context, uint8 group)
+/** Stop workers of mapping pool and release its resources.
+ *
+ * @param[in] pool         = mapping pool
+ */
+static void ecx_mappool_stop(ecx_mappoolt *pool)
 {
-   int thrn, thrc;
-   uint16 slave;
-
-   for (thrn = 0; thrn < EC_MAX_MAPT; thrn++)
+#if EC_MAX_MAPT > 1
+   ecx_mappool_stage(pool, NULL);
+   if (pool->done)
    {
-      ecx_mapt[thrn].running = 0;
+      osal_sem_destroy(pool->done);
    }
-   /* find CoE and SoE mapping of slaves in multiple threads */
-   for (slave = 1; slave <= *(context->slavecount); slave++)
+   if (pool->work)
    {
-      if (!group || (group == context->slavelist[slave].group))
-      {
-#if EC_MAX_MAPT > 1
-            /* multi-threaded version */
-            while ((thrn = ecx_find_mapt()) < 0)
-            {
-               osal_usleep(1000);
-            }
-            ecx_mapt[thrn].context = context;
-            ecx_mapt[thrn].slave = slave;
-            ecx_mapt[thrn].thread_n = thrn;
-            ecx_mapt[thrn].running = 1;
-            osal_thread_create(&(ecx_threadh[thrn]), 128000,
-               &ecx_mapper_thread, &(ecx_mapt[thrn]));
+      osal_sem_destroy(pool->work);
+   }
+   if (pool->siimtx)
+   {
+      osal_mtx_destroy(pool->siimtx);
+   }
+   if (pool->mtx)
+   {
+      osal_mtx_destroy(pool->mtx);
+   }
 #else
-            /* serialised version */
-            ecx_map_coe_soe(context, slave, 0);
+   (void)pool;
 #endif
-      }
+}
+
+static int ecx_mapstage_coe_soe(ecx_mappoolt *pool, uint16 slave, int thread_n)
+{
+   return ecx_map_coe_soe(pool->context, slave, thread_n);
+}
+
+static int ecx_mapstage_sii_sm(ecx_mappoolt *pool, uint16 slave, int thread_n)
+{
+   (void)thread_n;
+#if EC_MAX_MAPT > 1
+   if (pool->workers)
+   {
+      osal_mtx_lock(pool->siimtx);
    }
-   /* wait for all threads to finish */
-   do
+#endif
+   ecx_map_sii(pool->context, slave);
+#if EC_MAX_MAPT > 1
+   if (pool->workers)
    {
-      thrc = ecx_get_threadcount();
-      if (thrc)
-      {
-         osal_usleep(1000);
-      }
-   } while (thrc);
+      osal_mtx_unlock(pool->siimtx);
+   }
+#endif
+   return ecx_map_sm(pool->context, slave);
+}
+
+static void ecx_config_find_mappings(ecx_contextt *context, uint8 group)
+{
+   ecx_mappoolt pool;
+   uint16 slave;
+
+   ecx_mappool_start(&pool, context, group);
+   /* find CoE and SoE mapping of slaves */
+   ecx_mappool_stage(&pool, &ecx_mapstage_coe_soe);
    /* find SII mapping of slave and program SM */
+   ecx_mappool_stage(&pool, &ecx_mapstage_sii_sm);
+   ecx_mappool_stop(&pool);
+   /* keep mappings found by discovery for the next start, the mapping
+      threads are stopped so PDOassign buffer 0 is free */
    for (slave = 1; slave <= *(context->slavecount); slave++)
    {
-      if (!group || (group == context->slavelist[slave].group))
+      if ((!group || (group == context->slavelist[slave].group)) && !ecx_mapsnap_find(context, slave))
       {
-         ecx_map_sii(context, slave);
-         ecx_map_sm(context, slave);
+         ecx_mapsnap_store(context, slave);
       }
    }
 }
@@ -1529,6 +1987,8 @@ int ecx_recover_slave(ecx_contextt *context, uint16 slave, int timeout)
       {
          rval = ecx_FPWRw(context->port, EC_TEMPNODE, ECT_REG_STADR, htoes(configadr) , timeout);
          context->slavelist[slave].configadr = configadr;
+         /* may be another device of the same type */
+         ecx_siirecheck(context, slave);
       }
       else
       {
@@ -1558,6 +2018,7 @@ int ecx_reconfig_slave(ecx_contextt *context, uint16 slave, int timeout)
    {
       return 0;
    }
+   ecx_siirecheck(context, slave);
    state = 0;
    ecx_eeprom2pdi(context, slave); /* set Eeprom control to PDI */
    /* check state change init */
@@ -1596,11 +2057,57 @@ int ecx_reconfig_slave(ecx_contextt *context, uint16 slave, int timeout)
    return state;
 }
 
+/** Attach mapping snapshot. A snapshot without valid content, f.e. new or
+ * from another version, is cleared first. Mapping then uses the snapshot entry
+ * of a slave when identity and topology match and stores the result of
+ * discovery for all other slaves. Save the snapshot header and slave table to
+ * skip CoE, SoE and SII discovery at the next start. The configuration hooks
+ * of the slaves still run. A changed CoE PDO assignment is found by reading
+ * the assign lists back, clear the snapshot when a hook changes the content of
+ * a PDO.
+ *
+ * @param[in] context     = context struct
+ * @param[in] snap        = mapping snapshot header, NULL to stop using it
+ * @param[in] slaves      = snapshot slave table with context->maxslave entries
+ * @return number of slaves in snapshot, -1 if snap is set without slave table
+ */
+int ecx_mapsnap_init(ecx_contextt *context, ec_mapsnapt *snap, ec_mapslavet *slaves)
+{
+   int i, cnt = 0;
+
+   context->mapsnap = NULL;
+   if (!snap)
+   {
+      return 0;
+   }
+   if (!slaves)
+   {
+      return -1;
+   }
+   snap->slave = slaves;
+   if ((snap->magic != EC_MAPSNAP_MAGIC) || (snap->version != EC_MAPSNAP_VERSION) ||
+       (snap->nslave != context->maxslave))
+   {
+      snap->magic = EC_MAPSNAP_MAGIC;
+      snap->version = EC_MAPSNAP_VERSION;
+      snap->nslave = (uint16)context->maxslave;
+      memset(slaves, 0x00, sizeof(ec_mapslavet) * context->maxslave);
+   }
+   for (i = 1; i < context->maxslave; i++)
+   {
+      cnt += snap->slave[i].valid ? 1 : 0;
+   }
+   context->mapsnap = snap;
+
+   return cnt;
+}
+
 #ifdef EC_VER1
 /** Enumerate and init all slaves.
  *
  * @param[in] usetable     = TRUE when using configtable to init slaves, FALSE otherwise
- * @return Workcounter of slave discover datagram = number of slaves found
+ * @return Workcounter of slave discover datagram = number of slaves found,
+ * 0 if a station address could not be set
  * @see ecx_config_init
  */
 int ec_config_init(uint8 usetable)
@@ -1713,4 +2220,16 @@ int ec_reconfig_slave(uint16 slave, int timeout)
 {
    return ecx_reconfig_slave(&ecx_context, slave, timeout);
 }
+
+/** Attach mapping snapshot.
+ *
+ * @param[in] snap        = mapping snapshot header, NULL to stop using it
+ * @param[in] slaves      = snapshot slave table with EC_MAXSLAVE entries
+ * @return number of slaves in snapshot, -1 on error
+ * @see ecx_mapsnap_init
+ */
+int ec_mapsnap_init(ec_mapsnapt *snap, ec_mapslavet *slaves)
+{
+   return ecx_mapsnap_init(&ecx_context, snap, slaves);
+}
 #endif
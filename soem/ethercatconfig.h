@@ -29,6 +29,7 @@ int ec_config(uint8 usetable, void *pIOmap);
 int ec_config_overlap(uint8 usetable, void *pIOmap);
 int ec_recover_slave(uint16 slave, int timeout);
 int ec_reconfig_slave(uint16 slave, int timeout);
+int ec_mapsnap_init(ec_mapsnapt *snap, ec_mapslavet *slaves);
 #endif
 
 int ecx_config_init(ecx_contextt *context, uint8 usetable);
@@ -36,6 +37,7 @@ int ecx_config_map_group(ecx_contextt *context, void *pIOmap, uint8 group);
 int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 group);
 int ecx_recover_slave(ecx_contextt *context, uint16 slave, int timeout);
 int ecx_reconfig_slave(ecx_contextt *context, uint16 slave, int timeout);
+int ecx_mapsnap_init(ecx_contextt *context, ec_mapsnapt *snap, ec_mapslavet *slaves);
 
 #ifdef __cplusplus
 }
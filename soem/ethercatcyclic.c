@@ -0,0 +1,178 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Cyclic process data executor.
+ *
+ * Runs send, receive and a user hook on absolute deadlines of the monotonic
+ * clock, so the cycle does not drift with the execution time of the loop.
+ * When the group has DC the cycle start is locked to the DC reference clock
+ * with a PI controller on the system time read back by the process data frame.
+ */
+#include <string.h>
+#include "oshw.h"
+#include "osal.h"
+#include "ethercattype.h"
+#include "ethercatbase.h"
+#include "ethercatmain.h"
+#include "ethercatcyclic.h"
+
+/** Add wakeup jitter of one cycle to the statistics.
+ *
+ * @param[in] stat    = statistics struct
+ * @param[in] jitter  = actual cycle start minus deadline in ns
+ */
+static void ecx_cyclic_addjitter(ec_cyclicstatt *stat, int64 jitter)
+{
+   int64 bin;
+
+   if (!stat->cycles || (jitter < stat->minjitter))
+   {
+      stat->minjitter = jitter;
+   }
+   if (!stat->cycles || (jitter > stat->maxjitter))
+   {
+      stat->maxjitter = jitter;
+   }
+   stat->jitter = jitter;
+   stat->sumjitter += jitter;
+   bin = ((jitter < 0) ? -jitter : jitter) / EC_CYCLIC_HISTWIDTH;
+   if (bin >= EC_CYCLIC_HISTBINS)
+   {
+      bin = EC_CYCLIC_HISTBINS - 1;
+   }
+   stat->hist[bin]++;
+}
+
+/** PI controller locking the cycle start to the DC reference clock.
+ * The phase error is the position of the reference clock time, minus the
+ * wanted sync offset, within the cycle. The output is added to the next cycle time.
+ *
+ * @param[in] cyclic  = cyclic executor
+ * @param[in] reftime = DC reference clock time read back in the last cycle
+ */
+static void ecx_cyclic_dcsync(ec_cyclict *cyclic, int64 reftime)
+{
+   int64 delta;
+
+   delta = (reftime - cyclic->syncoffset) % cyclic->cycletime;
+   if (delta > (cyclic->cycletime / 2))
+   {
+      delta -= cyclic->cycletime;
+   }
+   if (delta > 0)
+   {
+      cyclic->integral++;
+   }
+   if (delta < 0)
+   {
+      cyclic->integral--;
+   }
+   cyclic->toff = -(delta / EC_CYCLIC_PDIV) - (cyclic->integral / EC_CYCLIC_IDIV);
+   cyclic->stat.dcdelta = delta;
+}
+
+/** Initialise cyclic executor. Defaults are DC lock enabled with EC_CYCLIC_SYNCOFFSET
+ * and a receive timeout of EC_TIMEOUTRET, both can be changed before ecx_cyclic_run().
+ *
+ * @param[out] cyclic    = cyclic executor
+ * @param[in]  context   = context struct
+ * @param[in]  group     = group number
+ * @param[in]  cycletime = cycle time in ns
+ * @param[in]  hook      = user hook called every cycle, or NULL
+ * @param[in]  arg       = user argument available to the hook as cyclic->arg
+ */
+void ecx_cyclic_init(ec_cyclict *cyclic, ecx_contextt *context, uint8 group, uint32 cycletime, ec_cyclichookt hook, void *arg)
+{
+   memset(cyclic, 0, sizeof(*cyclic));
+   cyclic->context = context;
+   cyclic->group = group;
+   cyclic->cycletime = cycletime;
+   cyclic->syncoffset = EC_CYCLIC_SYNCOFFSET;
+   cyclic->dclock = TRUE;
+   cyclic->timeout = EC_TIMEOUTRET;
+   cyclic->hook = hook;
+   cyclic->arg = arg;
+}
+
+/** Run the cyclic executor in the calling thread. Each cycle sleeps until the
+ * absolute deadline, sends and receives process data of the group, updates the
+ * DC lock and calls the user hook. Cycles missed because a cycle ran too long are
+ * skipped and counted as overruns instead of being executed back to back.
+ *
+ * @param[in] cyclic  = cyclic executor
+ * @param[in] cycles  = number of cycles to run, 0 to run until ecx_cyclic_stop()
+ * @return number of cycles executed
+ */
+int ecx_cyclic_run(ec_cyclict *cyclic, uint32 cycles)
+{
+   ecx_contextt *context = cyclic->context;
+   int64 wakeup, now, missed;
+   uint32 cnt = 0;
+   int wkc;
+
+   cyclic->run = TRUE;
+   cyclic->integral = 0;
+   cyclic->toff = 0;
+   /* first deadline on a cycle boundary of the monotonic clock */
+   wakeup = osal_current_time_ns();
+   wakeup -= wakeup % cyclic->cycletime;
+   while (cyclic->run && (!cycles || (cnt < cycles)))
+   {
+      wakeup += cyclic->cycletime + cyclic->toff;
+      osal_sleep_until_ns(wakeup);
+      ecx_cyclic_addjitter(&cyclic->stat, osal_current_time_ns() - wakeup);
+      ecx_send_processdata_group(context, cyclic->group);
+      wkc = ecx_receive_processdata_group(context, cyclic->group, cyclic->timeout);
+      /* DC time is only valid when the frame came back */
+      if (cyclic->dclock && context->grouplist[cyclic->group].hasdc && (wkc > 0))
+      {
+         ecx_cyclic_dcsync(cyclic, *(context->DCtime));
+      }
+      if (cyclic->hook)
+      {
+         cyclic->hook(cyclic, wkc);
+      }
+      cyclic->stat.cycles++;
+      cnt++;
+      now = osal_current_time_ns();
+      if (now > (wakeup + cyclic->cycletime))
+      {
+         missed = (now - wakeup) / cyclic->cycletime;
+         cyclic->stat.overruns += (uint32)missed;
+         wakeup += missed * cyclic->cycletime;
+      }
+   }
+   cyclic->run = FALSE;
+
+   return (int)cnt;
+}
+
+/** Request ecx_cyclic_run() to return after the current cycle. Can be called
+ * from the hook or from another thread.
+ *
+ * @param[in] cyclic  = cyclic executor
+ */
+void ecx_cyclic_stop(ec_cyclict *cyclic)
+{
+   cyclic->run = FALSE;
+}
+
+/** Clear cyclic executor statistics.
+ *
+ * @param[in] cyclic  = cyclic executor
+ */
+void ecx_cyclic_clearstat(ec_cyclict *cyclic)
+{
+   memset(&cyclic->stat, 0, sizeof(cyclic->stat));
+}
+
+#ifdef EC_VER1
+void ec_cyclic_init(ec_cyclict *cyclic, uint8 group, uint32 cycletime, ec_cyclichookt hook, void *arg)
+{
+   ecx_cyclic_init(cyclic, &ecx_context, group, cycletime, hook, arg);
+}
+#endif
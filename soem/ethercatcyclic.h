@@ -0,0 +1,95 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Headerfile for ethercatcyclic.c
+ */
+
+#ifndef _EC_ECATCYCLIC_H
+#define _EC_ECATCYCLIC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** number of bins in the wakeup jitter histogram */
+#define EC_CYCLIC_HISTBINS    16
+/** width of one jitter histogram bin in ns, last bin collects all above */
+#define EC_CYCLIC_HISTWIDTH   10000
+/** default offset in ns of the cycle start after the DC cycle boundary */
+#define EC_CYCLIC_SYNCOFFSET  50000
+/** divisor of the proportional term of the DC lock controller */
+#define EC_CYCLIC_PDIV        100
+/** divisor of the integral term of the DC lock controller */
+#define EC_CYCLIC_IDIV        20
+
+typedef struct ec_cyclic ec_cyclict;
+
+/** User hook called every cycle after the process data exchange.
+ * wkc is the result of ecx_receive_processdata_group().
+ */
+typedef void (*ec_cyclichookt)(ec_cyclict *cyclic, int wkc);
+
+/** Cyclic executor statistics, all times in ns */
+typedef struct
+{
+   /** number of executed cycles */
+   uint32         cycles;
+   /** number of cycle deadlines missed because a cycle ran too long */
+   uint32         overruns;
+   /** wakeup jitter of last cycle, actual start minus deadline */
+   int64          jitter;
+   int64          minjitter;
+   int64          maxjitter;
+   /** sum of jitter over all cycles, divide by cycles for the mean */
+   int64          sumjitter;
+   /** jitter histogram in EC_CYCLIC_HISTWIDTH bins */
+   uint32         hist[EC_CYCLIC_HISTBINS];
+   /** last phase error of the cycle start against the DC reference clock */
+   int64          dcdelta;
+} ec_cyclicstatt;
+
+/** Cyclic executor state, set up by ecx_cyclic_init() */
+struct ec_cyclic
+{
+   ecx_contextt   *context;
+   /** group to exchange process data with */
+   uint8          group;
+   /** cycle time in ns */
+   int64          cycletime;
+   /** cycle start offset in ns after the DC cycle boundary */
+   int64          syncoffset;
+   /** TRUE to lock the cycle start to the DC reference clock when the group has DC */
+   boolean        dclock;
+   /** receive timeout in us */
+   int            timeout;
+   ec_cyclichookt hook;
+   /** user argument for hook */
+   void           *arg;
+   /** cleared by ecx_cyclic_stop() to end ecx_cyclic_run() */
+   volatile boolean run;
+   /** DC lock controller integral */
+   int64          integral;
+   /** DC lock controller output, added to the next cycle time */
+   int64          toff;
+   ec_cyclicstatt stat;
+};
+
+#ifdef EC_VER1
+void ec_cyclic_init(ec_cyclict *cyclic, uint8 group, uint32 cycletime, ec_cyclichookt hook, void *arg);
+#endif
+
+void ecx_cyclic_init(ec_cyclict *cyclic, ecx_contextt *context, uint8 group, uint32 cycletime, ec_cyclichookt hook, void *arg);
+int ecx_cyclic_run(ec_cyclict *cyclic, uint32 cycles);
+void ecx_cyclic_stop(ec_cyclict *cyclic);
+void ecx_cyclic_clearstat(ec_cyclict *cyclic);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EC_ECATCYCLIC_H */
@@ -8,6 +8,7 @@
  * Distributed Clock EtherCAT functions.
  *
  */
+#include <string.h>
 #include "oshw.h"
 #include "osal.h"
 #include "ethercattype.h"
@@ -243,26 +244,233 @@ static uint8 ecx_parentport(ecx_contextt *context, uint16 parent)
    return parentport;
 }
 
+/** Topology step of DC setup. Finds the entry port and DC parent of a slave and
+ * calculates its propagation delay from the latched port times in the slave
+ * list, without any register access. Slaves must be passed in order, non DC
+ * slaves included.
+ *
+ * @param[in]     context        = context struct
+ * @param[in]     i              = slave number
+ * @param[in,out] prevDCslave    = last DC slave found
+ * @param[in,out] parenthold     = root parent of a branch starting with a non DC slave
+ * @return DC parent of the slave, 0 for the reference clock and non DC slaves
+ */
+static uint16 ecx_dctopology(ecx_contextt *context, uint16 i, uint16 *prevDCslave, uint16 *parenthold)
+{
+   uint16 parent, child;
+   int32 dt1, dt2, dt3;
+   uint8 entryport;
+   int8 nlist;
+   int8 plist[4];
+   int32 tlist[4];
+
+   context->slavelist[i].consumedports = context->slavelist[i].activeports;
+   if (!context->slavelist[i].hasdc)
+   {
+      context->slavelist[i].DCrtA = 0;
+      context->slavelist[i].DCrtB = 0;
+      context->slavelist[i].DCrtC = 0;
+      context->slavelist[i].DCrtD = 0;
+      parent = context->slavelist[i].parent;
+      /* if non DC slave found on first position on branch hold root parent */
+      if ( (parent > 0) && (context->slavelist[parent].topology > 2))
+         *parenthold = parent;
+      /* if branch has no DC slaves consume port on root parent */
+      if ( *parenthold && (context->slavelist[i].topology == 1))
+      {
+         ecx_parentport(context, *parenthold);
+         *parenthold = 0;
+      }
+      return 0;
+   }
+   if (!context->slavelist[0].hasdc)
+   {
+      context->slavelist[0].hasdc = TRUE;
+      context->slavelist[0].DCnext = i;
+      context->slavelist[i].DCprevious = 0;
+      context->grouplist[context->slavelist[i].group].hasdc = TRUE;
+      context->grouplist[context->slavelist[i].group].DCnext = i;
+   }
+   else
+   {
+      context->slavelist[*prevDCslave].DCnext = i;
+      context->slavelist[i].DCprevious = *prevDCslave;
+   }
+   /* this branch has DC slave so remove parenthold */
+   *parenthold = 0;
+   *prevDCslave = i;
+
+   /* make list of active ports and their time stamps */
+   nlist = 0;
+   if (context->slavelist[i].activeports & PORTM0)
+   {
+      plist[nlist] = 0;
+      tlist[nlist] = context->slavelist[i].DCrtA;
+      nlist++;
+   }
+   if (context->slavelist[i].activeports & PORTM3)
+   {
+      plist[nlist] = 3;
+      tlist[nlist] = context->slavelist[i].DCrtD;
+      nlist++;
+   }
+   if (context->slavelist[i].activeports & PORTM1)
+   {
+      plist[nlist] = 1;
+      tlist[nlist] = context->slavelist[i].DCrtB;
+      nlist++;
+   }
+   if (context->slavelist[i].activeports & PORTM2)
+   {
+      plist[nlist] = 2;
+      tlist[nlist] = context->slavelist[i].DCrtC;
+      nlist++;
+   }
+   /* entryport is port with the lowest timestamp */
+   entryport = 0;
+   if((nlist > 1) && (tlist[1] < tlist[entryport]))
+   {
+      entryport = 1;
+   }
+   if((nlist > 2) && (tlist[2] < tlist[entryport]))
+   {
+      entryport = 2;
+   }
+   if((nlist > 3) && (tlist[3] < tlist[entryport]))
+   {
+      entryport = 3;
+   }
+   entryport = plist[entryport];
+   context->slavelist[i].entryport = entryport;
+   /* consume entryport from activeports */
+   context->slavelist[i].consumedports &= (uint8)~(1 << entryport);
+
+   /* finding DC parent of current */
+   parent = i;
+   do
+   {
+      child = parent;
+      parent = context->slavelist[parent].parent;
+   }
+   while (!((parent == 0) || (context->slavelist[parent].hasdc)));
+   /* only calculate propagation delay if slave is not the first */
+   if (parent > 0)
+   {
+      /* find port on parent this slave is connected to */
+      context->slavelist[i].parentport = ecx_parentport(context, parent);
+      if (context->slavelist[parent].topology == 1)
+      {
+         context->slavelist[i].parentport = context->slavelist[parent].entryport;
+      }
+
+      dt1 = 0;
+      dt2 = 0;
+      /* delta time of (parentport - 1) - parentport */
+      /* note: order of ports is 0 - 3 - 1 -2 */
+      /* non active ports are skipped */
+      dt3 = ecx_porttime(context, parent, context->slavelist[i].parentport) -
+            ecx_porttime(context, parent,
+              ecx_prevport(context, parent, context->slavelist[i].parentport));
+      /* current slave has children */
+      /* those children's delays need to be subtracted */
+      if (context->slavelist[i].topology > 1)
+      {
+         dt1 = ecx_porttime(context, i,
+                  ecx_prevport(context, i, context->slavelist[i].entryport)) -
+               ecx_porttime(context, i, context->slavelist[i].entryport);
+      }
+      /* we are only interested in positive difference */
+      if (dt1 > dt3) dt1 = -dt1;
+      /* current slave is not the first child of parent */
+      /* previous child's delays need to be added */
+      if ((child - parent) > 1)
+      {
+         dt2 = ecx_porttime(context, parent,
+                  ecx_prevport(context, parent, context->slavelist[i].parentport)) -
+               ecx_porttime(context, parent, context->slavelist[parent].entryport);
+      }
+      if (dt2 < 0) dt2 = -dt2;
+
+      /* calculate current slave delay from delta times */
+      /* assumption : forward delay equals return delay */
+      context->slavelist[i].pdelay = ((dt3 - dt1) / 2) + dt2 +
+         context->slavelist[parent].pdelay;
+   }
+
+   return parent;
+}
+
+/** Complete DC setup report with totals.
+ *
+ * @param[in]  context        = context struct
+ * @param[in]  start          = start time of DC setup in ns
+ */
+static void ecx_dcreport_done(ecx_contextt *context, int64 start)
+{
+   ec_dcreportt *rep = context->dcreport;
+   ec_dcdelayt *dc;
+   int i;
+
+   rep->refclock = context->slavelist[0].hasdc ? context->slavelist[0].DCnext : 0;
+   for (i = 0; i < rep->ndc; i++)
+   {
+      dc = &(rep->dc[i]);
+      if (dc->pdelay > rep->maxdelay)
+      {
+         rep->maxdelay = dc->pdelay;
+      }
+      if ((dc->rdwkc <= 0) || (dc->offwkc <= 0) || (dc->parent && (dc->delaywkc <= 0)))
+      {
+         rep->nfail++;
+      }
+   }
+   rep->duration = osal_current_time_ns() - start;
+}
+
 /**
  * Locate DC slaves, measure propagation delays.
  *
+ * The latched port times and local times of EC_CONFIGMULTI DC slaves are read
+ * with one batched register access. That access also writes system time offset
+ * and propagation delay of the previous EC_CONFIGMULTI DC slaves, which are
+ * calculated in memory in between. When a DC setup report is set with
+ * ecx_dcreport_init() it is filled with the result of each DC slave.
+ *
  * @param[in]  context        = context struct
  * @return boolean if slaves are found with DC
  */
 boolean ecx_configdc(ecx_contextt *context)
 {
-   uint16 i, slaveh, parent, child;
+   ec_multidgt dg[EC_CONFIGMULTI * 4];
+   int32 rt[EC_CONFIGMULTI][4];
+   int64 hrt[EC_CONFIGMULTI];
+   int64 offset[EC_CONFIGMULTI];
+   int32 delay[EC_CONFIGMULTI];
+   uint16 list[EC_CONFIGMULTI];
+   uint16 wlist[EC_CONFIGMULTI];
+   uint16 wparent[EC_CONFIGMULTI];
+   uint8 hasoffset[EC_CONFIGMULTI];
+   int woff[EC_CONFIGMULTI];
+   int wdelay[EC_CONFIGMULTI];
+   ec_dcreportt *rep = context->dcreport;
+   ec_dcdelayt *dc;
+   uint16 slave, topo, parent;
    uint16 parenthold = 0;
    uint16 prevDCslave = 0;
-   int32 ht, dt1, dt2, dt3;
-   int64 hrt;
-   uint8 entryport;
-   int8 nlist;
-   int8 plist[4];
-   int32 tlist[4];
+   int32 ht;
+   int i, j, k, n, nw = 0, wfirst = 0, ndc = 0;
+   int64 start;
    ec_timet mastertime;
    uint64 mastertime64;
 
+   start = osal_current_time_ns();
+   if (rep)
+   {
+      dc = rep->dc;
+      memset(rep, 0x00, sizeof(*rep));
+      memset(dc, 0x00, sizeof(ec_dcdelayt) * context->maxslave);
+      rep->dc = dc;
+   }
    context->slavelist[0].hasdc = FALSE;
    context->grouplist[0].hasdc = FALSE;
    ht = 0;
@@ -271,163 +479,257 @@ boolean ecx_configdc(ecx_contextt *context)
    mastertime = osal_current_time();
    mastertime.sec -= 946684800UL;  /* EtherCAT uses 2000-01-01 as epoch start instead of 1970-01-01 */
    mastertime64 = (((uint64)mastertime.sec * 1000000) + (uint64)mastertime.usec) * 1000;
-   for (i = 1; i <= *(context->slavecount); i++)
+   slave = 1;
+   topo = 1;
+   for (;;)
    {
-      context->slavelist[i].consumedports = context->slavelist[i].activeports;
-      if (context->slavelist[i].hasdc)
+      /* read latched times of the next DC slaves */
+      n = 0;
+      while ((slave <= *(context->slavecount)) && (n < EC_CONFIGMULTI))
       {
-         if (!context->slavelist[0].hasdc)
-         {
-            context->slavelist[0].hasdc = TRUE;
-            context->slavelist[0].DCnext = i;
-            context->slavelist[i].DCprevious = 0;
-            context->grouplist[context->slavelist[i].group].hasdc = TRUE;
-            context->grouplist[context->slavelist[i].group].DCnext = i;
-         }
-         else
+         if (context->slavelist[slave].hasdc)
          {
-            context->slavelist[prevDCslave].DCnext = i;
-            context->slavelist[i].DCprevious = prevDCslave;
+            list[n] = slave;
+            /* DCrecvTimeA to D in one datagram */
+            ecx_multidg(&dg[n * 2], EC_CMD_FPRD, context->slavelist[slave].configadr,
+                        ECT_REG_DCTIME0, sizeof(rt[n]), rt[n]);
+            /* 64bit latched DCrecvTimeA of each specific slave */
+            ecx_multidg(&dg[n * 2 + 1], EC_CMD_FPRD, context->slavelist[slave].configadr,
+                        ECT_REG_DCSOF, sizeof(hrt[n]), &hrt[n]);
+            n++;
          }
-         /* this branch has DC slave so remove parenthold */
-         parenthold = 0;
-         prevDCslave = i;
-         slaveh = context->slavelist[i].configadr;
-         (void)ecx_FPRD(context->port, slaveh, ECT_REG_DCTIME0, sizeof(ht), &ht, EC_TIMEOUTRET);
-         context->slavelist[i].DCrtA = etohl(ht);
-         /* 64bit latched DCrecvTimeA of each specific slave */
-         (void)ecx_FPRD(context->port, slaveh, ECT_REG_DCSOF, sizeof(hrt), &hrt, EC_TIMEOUTRET);
-         /* use it as offset in order to set local time around 0 + mastertime */
-         hrt = htoell(-etohll(hrt) + mastertime64);
-         /* save it in the offset register */
-         (void)ecx_FPWR(context->port, slaveh, ECT_REG_DCSYSOFFSET, sizeof(hrt), &hrt, EC_TIMEOUTRET);
-         (void)ecx_FPRD(context->port, slaveh, ECT_REG_DCTIME1, sizeof(ht), &ht, EC_TIMEOUTRET);
-         context->slavelist[i].DCrtB = etohl(ht);
-         (void)ecx_FPRD(context->port, slaveh, ECT_REG_DCTIME2, sizeof(ht), &ht, EC_TIMEOUTRET);
-         context->slavelist[i].DCrtC = etohl(ht);
-         (void)ecx_FPRD(context->port, slaveh, ECT_REG_DCTIME3, sizeof(ht), &ht, EC_TIMEOUTRET);
-         context->slavelist[i].DCrtD = etohl(ht);
-
-         /* make list of active ports and their time stamps */
-         nlist = 0;
-         if (context->slavelist[i].activeports & PORTM0)
-         {
-            plist[nlist] = 0;
-            tlist[nlist] = context->slavelist[i].DCrtA;
-            nlist++;
-         }
-         if (context->slavelist[i].activeports & PORTM3)
+         slave++;
+      }
+      /* write offsets and delays of the DC slaves read in the previous step */
+      k = n * 2;
+      for (j = 0; j < nw; j++)
+      {
+         woff[j] = -1;
+         wdelay[j] = -1;
+         if (hasoffset[j])
          {
-            plist[nlist] = 3;
-            tlist[nlist] = context->slavelist[i].DCrtD;
-            nlist++;
+            woff[j] = k;
+            ecx_multidg(&dg[k++], EC_CMD_FPWR, context->slavelist[wlist[j]].configadr,
+                        ECT_REG_DCSYSOFFSET, sizeof(offset[j]), &offset[j]);
          }
-         if (context->slavelist[i].activeports & PORTM1)
+         if (wparent[j])
          {
-            plist[nlist] = 1;
-            tlist[nlist] = context->slavelist[i].DCrtB;
-            nlist++;
+            wdelay[j] = k;
+            delay[j] = htoel(context->slavelist[wlist[j]].pdelay);
+            ecx_multidg(&dg[k++], EC_CMD_FPWR, context->slavelist[wlist[j]].configadr,
+                        ECT_REG_DCSYSDELAY, sizeof(delay[j]), &delay[j]);
          }
-         if (context->slavelist[i].activeports & PORTM2)
+      }
+      if (!k)
+      {
+         break;
+      }
+      ecx_multirw(context->port, dg, k, EC_TIMEOUTRET);
+      if (rep)
+      {
+         rep->nmulti++;
+         for (j = 0; j < nw; j++)
          {
-            plist[nlist] = 2;
-            tlist[nlist] = context->slavelist[i].DCrtC;
-            nlist++;
+            dc = &(rep->dc[wfirst + j]);
+            dc->offwkc = (woff[j] >= 0) ? dg[woff[j]].wkc : 0;
+            dc->delaywkc = (wdelay[j] >= 0) ? dg[wdelay[j]].wkc : 0;
          }
-         /* entryport is port with the lowest timestamp */
-         entryport = 0;
-         if((nlist > 1) && (tlist[1] < tlist[entryport]))
+      }
+      for (i = 0; i < n; i++)
+      {
+         if (dg[i * 2].wkc <= 0)
          {
-            entryport = 1;
+            rt[i][0] = rt[i][1] = rt[i][2] = rt[i][3] = 0;
          }
-         if((nlist > 2) && (tlist[2] < tlist[entryport]))
+         context->slavelist[list[i]].DCrtA = etohl(rt[i][0]);
+         context->slavelist[list[i]].DCrtB = etohl(rt[i][1]);
+         context->slavelist[list[i]].DCrtC = etohl(rt[i][2]);
+         context->slavelist[list[i]].DCrtD = etohl(rt[i][3]);
+         /* use it as offset in order to set local time around 0 + mastertime */
+         hasoffset[i] = (dg[i * 2 + 1].wkc > 0);
+         offset[i] = htoell(-etohll(hrt[i]) + mastertime64);
+         wlist[i] = list[i];
+      }
+      /* topology and delays of all slaves up to the last one read */
+      wfirst = ndc;
+      i = 0;
+      for (; topo < slave; topo++)
+      {
+         parent = ecx_dctopology(context, topo, &prevDCslave, &parenthold);
+         if (context->slavelist[topo].hasdc)
          {
-            entryport = 2;
+            wparent[i] = parent;
+            if (rep)
+            {
+               dc = &(rep->dc[ndc]);
+               dc->slave = topo;
+               dc->parent = parent;
+               dc->entryport = context->slavelist[topo].entryport;
+               dc->parentport = parent ? context->slavelist[topo].parentport : 0;
+               dc->porttime[0] = context->slavelist[topo].DCrtA;
+               dc->porttime[1] = context->slavelist[topo].DCrtB;
+               dc->porttime[2] = context->slavelist[topo].DCrtC;
+               dc->porttime[3] = context->slavelist[topo].DCrtD;
+               dc->pdelay = parent ? context->slavelist[topo].pdelay : 0;
+               dc->offset = etohll(offset[i]);
+               dc->rdwkc = dg[i * 2].wkc;
+               rep->ndc++;
+            }
+            ndc++;
+            i++;
          }
-         if((nlist > 3) && (tlist[3] < tlist[entryport]))
+      }
+      nw = n;
+   }
+   /* remaining slaves when there is no DC slave */
+   for (; topo <= *(context->slavecount); topo++)
+   {
+      (void)ecx_dctopology(context, topo, &prevDCslave, &parenthold);
+   }
+   if (rep)
+   {
+      ecx_dcreport_done(context, start);
+   }
+
+   return context->slavelist[0].hasdc;
+}
+
+/** Set DC setup report to be filled by ecx_configdc().
+ *
+ * @param[in]  context        = context struct
+ * @param[out] report         = DC setup report, NULL to stop using it
+ * @param[out] dc             = entry table with context->maxslave entries
+ * @return 1 if OK, 0 if report is set without entry table
+ */
+int ecx_dcreport_init(ecx_contextt *context, ec_dcreportt *report, ec_dcdelayt *dc)
+{
+   context->dcreport = NULL;
+   if (!report)
+   {
+      return 1;
+   }
+   if (!dc)
+   {
+      return 0;
+   }
+   memset(report, 0x00, sizeof(*report));
+   memset(dc, 0x00, sizeof(ec_dcdelayt) * context->maxslave);
+   report->dc = dc;
+   context->dcreport = report;
+
+   return 1;
+}
+
+/**
+ * Static drift compensation of DC slaves. The reference clock system time is
+ * distributed with FRMW datagrams, EC_DCDRIFTBURST of them per batched register
+ * access. The same access reads the system time difference of the next
+ * EC_CONFIGMULTI DC slaves. After each pass over all DC slaves the compensation
+ * stops when all of them are within the target deviation, or when the number
+ * of iterations is done. Call after ecx_configdc() and before going to SAFE_OP.
+ *
+ * @param[in]  context        = context struct
+ * @param[in]  iterations     = max. number of FRMW datagrams, 15000 is typical
+ * @param[in]  target         = target deviation in ns, negative to do all iterations
+ * @param[out] result         = result of compensation, may be NULL
+ * @return TRUE if all DC slaves are within the target deviation
+ */
+boolean ecx_dcdrift(ecx_contextt *context, int32 iterations, int32 target, ec_dcdriftt *result)
+{
+   ec_multidgt dg[EC_DCDRIFTBURST + EC_CONFIGMULTI];
+   uint32 diff[EC_CONFIGMULTI];
+   uint16 list[EC_CONFIGMULTI];
+   ec_dcreportt *rep = context->dcreport;
+   ec_dcdriftt res;
+   uint16 refadr, slave, passslave = 0;
+   int64 ht, start;
+   int32 d, passmax = 0;
+   int i, k, n, nb, entry = 0;
+
+   memset(&res, 0x00, sizeof(res));
+   start = osal_current_time_ns();
+   if (context->slavelist[0].hasdc)
+   {
+      refadr = context->slavelist[context->slavelist[0].DCnext].configadr;
+      ht = 0;
+      slave = 1;
+      for (;;)
+      {
+         /* FRMW burst on the reference clock system time */
+         nb = iterations - res.iterations;
+         if (nb > EC_DCDRIFTBURST)
          {
-            entryport = 3;
+            nb = EC_DCDRIFTBURST;
          }
-         entryport = plist[entryport];
-         context->slavelist[i].entryport = entryport;
-         /* consume entryport from activeports */
-         context->slavelist[i].consumedports &= (uint8)~(1 << entryport);
-
-         /* finding DC parent of current */
-         parent = i;
-         do
+         for (k = 0; k < nb; k++)
          {
-            child = parent;
-            parent = context->slavelist[parent].parent;
+            ecx_multidg(&dg[k], EC_CMD_FRMW, refadr, ECT_REG_DCSYSTIME, sizeof(ht), &ht);
          }
-         while (!((parent == 0) || (context->slavelist[parent].hasdc)));
-         /* only calculate propagation delay if slave is not the first */
-         if (parent > 0)
+         /* system time difference of the next DC slaves */
+         n = 0;
+         while ((slave <= *(context->slavecount)) && (n < EC_CONFIGMULTI))
          {
-            /* find port on parent this slave is connected to */
-            context->slavelist[i].parentport = ecx_parentport(context, parent);
-            if (context->slavelist[parent].topology == 1)
+            if (context->slavelist[slave].hasdc)
             {
-               context->slavelist[i].parentport = context->slavelist[parent].entryport;
+               list[n] = slave;
+               ecx_multidg(&dg[k++], EC_CMD_FPRD, context->slavelist[slave].configadr,
+                           ECT_REG_DCSYSDIFF, sizeof(diff[n]), &diff[n]);
+               n++;
             }
-
-            dt1 = 0;
-            dt2 = 0;
-            /* delta time of (parentport - 1) - parentport */
-            /* note: order of ports is 0 - 3 - 1 -2 */
-            /* non active ports are skipped */
-            dt3 = ecx_porttime(context, parent, context->slavelist[i].parentport) -
-                  ecx_porttime(context, parent,
-                    ecx_prevport(context, parent, context->slavelist[i].parentport));
-            /* current slave has children */
-            /* those children's delays need to be subtracted */
-            if (context->slavelist[i].topology > 1)
+            slave++;
+         }
+         ecx_multirw(context->port, dg, k, EC_TIMEOUTRET);
+         res.iterations += nb;
+         res.nmulti++;
+         for (i = 0; i < n; i++)
+         {
+            d = 0x7fffffff;
+            if (dg[nb + i].wkc > 0)
             {
-               dt1 = ecx_porttime(context, i,
-                        ecx_prevport(context, i, context->slavelist[i].entryport)) -
-                     ecx_porttime(context, i, context->slavelist[i].entryport);
+               d = ecx_dcsysdiff(etohl(diff[i]));
+               if (rep && (entry < rep->ndc) && (rep->dc[entry].slave == list[i]))
+               {
+                  rep->dc[entry].sysdiff = d;
+               }
+               if (d < 0)
+               {
+                  d = -d;
+               }
             }
-            /* we are only interested in positive difference */
-            if (dt1 > dt3) dt1 = -dt1;
-            /* current slave is not the first child of parent */
-            /* previous child's delays need to be added */
-            if ((child - parent) > 1)
+            if (!passslave || (d > passmax))
             {
-               dt2 = ecx_porttime(context, parent,
-                        ecx_prevport(context, parent, context->slavelist[i].parentport)) -
-                     ecx_porttime(context, parent, context->slavelist[parent].entryport);
+               passmax = d;
+               passslave = list[i];
             }
-            if (dt2 < 0) dt2 = -dt2;
-
-            /* calculate current slave delay from delta times */
-            /* assumption : forward delay equals return delay */
-            context->slavelist[i].pdelay = ((dt3 - dt1) / 2) + dt2 +
-               context->slavelist[parent].pdelay;
-            ht = htoel(context->slavelist[i].pdelay);
-            /* write propagation delay*/
-            (void)ecx_FPWR(context->port, slaveh, ECT_REG_DCSYSDELAY, sizeof(ht), &ht, EC_TIMEOUTRET);
+            entry++;
          }
-      }
-      else
-      {
-         context->slavelist[i].DCrtA = 0;
-         context->slavelist[i].DCrtB = 0;
-         context->slavelist[i].DCrtC = 0;
-         context->slavelist[i].DCrtD = 0;
-         parent = context->slavelist[i].parent;
-         /* if non DC slave found on first position on branch hold root parent */
-         if ( (parent > 0) && (context->slavelist[parent].topology > 2))
-            parenthold = parent;
-         /* if branch has no DC slaves consume port on root parent */
-         if ( parenthold && (context->slavelist[i].topology == 1))
+         if (slave > *(context->slavecount))
          {
-            ecx_parentport(context, parenthold);
-            parenthold = 0;
+            /* pass over all DC slaves done */
+            res.maxdiff = passmax;
+            res.maxslave = passslave;
+            if (passmax <= target)
+            {
+               res.converged = TRUE;
+               break;
+            }
+            if (res.iterations >= iterations)
+            {
+               break;
+            }
+            slave = 1;
+            entry = 0;
+            passslave = 0;
          }
       }
    }
+   res.duration = osal_current_time_ns() - start;
+   if (result)
+   {
+      *result = res;
+   }
 
-   return context->slavelist[0].hasdc;
+   return res.converged;
 }
 
 #ifdef EC_VER1
@@ -445,4 +747,14 @@ boolean ec_configdc(void)
 {
    return ecx_configdc(&ecx_context);
 }
+
+int ec_dcreport_init(ec_dcreportt *report, ec_dcdelayt *dc)
+{
+   return ecx_dcreport_init(&ecx_context, report, dc);
+}
+
+boolean ec_dcdrift(int32 iterations, int32 target, ec_dcdriftt *result)
+{
+   return ecx_dcdrift(&ecx_context, iterations, target, result);
+}
 #endif
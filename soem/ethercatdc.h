@@ -16,15 +16,41 @@ extern "C"
 {
 #endif
 
+/** max. number of FRMW datagrams in one batched register access of the drift compensation */
+#ifndef EC_DCDRIFTBURST
+#define EC_DCDRIFTBURST   128
+#endif
+
+/** Result of DC drift compensation, see ecx_dcdrift() */
+typedef struct
+{
+   /** number of FRMW datagrams sent */
+   int32          iterations;
+   /** number of batched register accesses */
+   int32          nmulti;
+   /** largest system time difference of the last pass over all DC slaves in ns */
+   int32          maxdiff;
+   /** DC slave with the largest difference */
+   uint16         maxslave;
+   /** all DC slaves were within the target deviation */
+   boolean        converged;
+   /** duration in ns */
+   int64          duration;
+} ec_dcdriftt;
+
 #ifdef EC_VER1
 boolean ec_configdc();
 void ec_dcsync0(uint16 slave, boolean act, uint32 CyclTime, int32 CyclShift);
 void ec_dcsync01(uint16 slave, boolean act, uint32 CyclTime0, uint32 CyclTime1, int32 CyclShift);
+int ec_dcreport_init(ec_dcreportt *report, ec_dcdelayt *dc);
+boolean ec_dcdrift(int32 iterations, int32 target, ec_dcdriftt *result);
 #endif
 
 boolean ecx_configdc(ecx_contextt *context);
 void ecx_dcsync0(ecx_contextt *context, uint16 slave, boolean act, uint32 CyclTime, int32 CyclShift);
 void ecx_dcsync01(ecx_contextt *context, uint16 slave, boolean act, uint32 CyclTime0, uint32 CyclTime1, int32 CyclShift);
+int ecx_dcreport_init(ecx_contextt *context, ec_dcreportt *report, ec_dcdelayt *dc);
+boolean ecx_dcdrift(ecx_contextt *context, int32 iterations, int32 target, ec_dcdriftt *result);
 
 #ifdef __cplusplus
 }
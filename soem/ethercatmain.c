@@ -25,6 +25,12 @@
 /** delay in us for eeprom ready loop */
 #define EC_LOCALDELAY  200
 
+/** mailbox datagram types in process data frames */
+#define EC_MBXC_NONE   0
+#define EC_MBXC_STATUS 1
+#define EC_MBXC_READ   2
+#define EC_MBXC_WRITE  3
+
 /** record for ethercat eeprom communications */
 PACKED_BEGIN
 typedef struct PACKED
@@ -74,6 +80,10 @@ ec_groupt               ec_group[EC_MAXGROUP];
 static uint8            ec_esibuf[EC_MAXEEPBUF];
 /** bitmap for filled cache buffer bytes */
 static uint32           ec_esimap[EC_MAXEEPBITMAP];
+/** per slave cache for EEPROM read functions */
+static ec_siipoolt      ec_siipool;
+/** identity of the slaves in the per slave cache */
+static ec_siislavet     ec_siislave[EC_MAXSLAVE];
 /** current slave for EEPROM cache buffer */
 static ec_eringt        ec_elist;
 static ec_idxstackT     ec_idxstack;
@@ -120,7 +130,16 @@ ecx_contextt  ecx_context = {
     &ec_FMMU,           // .eepFMMU       =
     NULL,               // .FOEhook()
     NULL,               // .EOEhook()
-    0                   // .manualstatechange
+    0,                  // .manualstatechange
+    NULL,               // .mbxcyclic
+    NULL,               // .siicache
+    NULL,               // .siiimage
+    &ec_siipool,        // .siipool
+    &ec_siislave[0],    // .siislave
+    NULL,               // .mapsnap
+    NULL,               // .dcreport
+    NULL,               // .dcmon
+    NULL                // .elistmtx
 };
 #endif
 
@@ -153,6 +172,12 @@ void ec_free_adapters (ec_adaptert * adapter)
  */
 void ecx_pusherror(ecx_contextt *context, const ec_errort *Ec)
 {
+   /* errors are pushed from the worker threads of mapping and the
+      asynchronous mailbox service as well */
+   if (context->elistmtx)
+   {
+      osal_mtx_lock(context->elistmtx);
+   }
    context->elist->Error[context->elist->head] = *Ec;
    context->elist->Error[context->elist->head].Signal = TRUE;
    context->elist->head++;
@@ -169,6 +194,10 @@ void ecx_pusherror(ecx_contextt *context, const ec_errort *Ec)
       context->elist->tail = 0;
    }
    *(context->ecaterror) = TRUE;
+   if (context->elistmtx)
+   {
+      osal_mtx_unlock(context->elistmtx);
+   }
 }
 
 /** Pops an error from the list.
@@ -179,8 +208,13 @@ void ecx_pusherror(ecx_contextt *context, const ec_errort *Ec)
  */
 boolean ecx_poperror(ecx_contextt *context, ec_errort *Ec)
 {
-   boolean notEmpty = (context->elist->head != context->elist->tail);
+   boolean notEmpty;
 
+   if (context->elistmtx)
+   {
+      osal_mtx_lock(context->elistmtx);
+   }
+   notEmpty = (context->elist->head != context->elist->tail);
    *Ec = context->elist->Error[context->elist->tail];
    context->elist->Error[context->elist->tail].Signal = FALSE;
    if (notEmpty)
@@ -195,6 +229,10 @@ boolean ecx_poperror(ecx_contextt *context, ec_errort *Ec)
    {
       *(context->ecaterror) = FALSE;
    }
+   if (context->elistmtx)
+   {
+      osal_mtx_unlock(context->elistmtx);
+   }
    return notEmpty;
 }
 
@@ -287,6 +325,10 @@ static void ecx_mbxemergencyerror(ecx_contextt *context, uint16 Slave,uint16 Err
  */
 int ecx_init(ecx_contextt *context, const char * ifname)
 {
+   if (!context->elistmtx)
+   {
+      context->elistmtx = osal_mtx_create();
+   }
    return ecx_setupnic(context->port, ifname, FALSE);
 }
 
@@ -302,6 +344,10 @@ int ecx_init_redundant(ecx_contextt *context, ecx_redportt *redport, const char
    int rval, zbuf;
    ec_etherheadert *ehp;
 
+   if (!context->elistmtx)
+   {
+      context->elistmtx = osal_mtx_create();
+   }
    context->port->redport = redport;
    ecx_setupnic(context->port, ifname, FALSE);
    rval = ecx_setupnic(context->port, if2name, TRUE);
@@ -321,11 +367,390 @@ int ecx_init_redundant(ecx_contextt *context, ecx_redportt *redport, const char
 void ecx_close(ecx_contextt *context)
 {
    ecx_closenic(context->port);
+   if (context->elistmtx)
+   {
+      osal_mtx_destroy(context->elistmtx);
+      context->elistmtx = NULL;
+   }
 };
 
+/** Hash of the SII category layout of a slave. Only the header and size
+ *  word of each category are read, one EEPROM read per category.
+ *  @param[in] context = context struct
+ *  @param[in] slave   = slave number, EEPROM must be in master control
+ *  @return hash of the category header and size words
+ */
+static uint32 ecx_siicatsum(ecx_contextt *context, uint16 slave)
+{
+   uint16 eadr = ECT_SII_START;
+   uint32 edat;
+   uint32 sum = 2166136261U;
+   int n;
+
+   for (n = 0; (n < EC_MAXSIICAT) && (eadr < (EC_MAXEEPBUF >> 1)); n++)
+   {
+      /* category type in the low word, size in words in the high word */
+      edat = (uint32)ecx_readeepromFP(context, context->slavelist[slave].configadr, eadr, EC_TIMEOUTEEP);
+      sum = (sum ^ edat) * 16777619U;
+      if ((edat & 0xffff) == 0xffff)
+      {
+         break;
+      }
+      eadr = (uint16)(eadr + 2 + (edat >> 16));
+   }
+
+   return sum;
+}
+
+/** Find SII image of slave in the SII image cache. Images are kept per slave
+ *  type and SII checksum, so slaves of one type with different EEPROM content
+ *  each have their own image. The checksum word only covers words 0 to 6, so
+ *  the layout of the categories is compared as well and an image with another
+ *  layout is filled again. A slave not yet cached gets a free image if one is
+ *  left.
+ *  @param[in] context = context struct
+ *  @param[in] slave   = slave number
+ *  @return image to use, NULL if the slave is not cached
+ */
+static ec_siiimaget *ecx_siicache_lookup(ecx_contextt *context, uint16 slave)
+{
+   ec_siicachet *cache = context->siicache;
+   ec_siiimaget *image = NULL;
+   ec_slavet *sl;
+   uint16 checksum;
+   uint32 catsum;
+   int i;
+
+   if (!cache || (slave < 1) || (slave > *(context->slavecount)))
+   {
+      return NULL;
+   }
+   sl = &(context->slavelist[slave]);
+   /* probe checksum and categories instead of reading the whole content */
+   ecx_eeprom2master(context, slave); /* set eeprom control to master */
+   checksum = (uint16)ecx_readeepromFP(context, sl->configadr, ECT_SII_CHECKSUM, EC_TIMEOUTEEP);
+   for (i = 0; i < cache->nimage; i++)
+   {
+      if ((cache->image[i].eep_man == sl->eep_man) &&
+          (cache->image[i].eep_id == sl->eep_id) &&
+          (cache->image[i].eep_rev == sl->eep_rev) &&
+          (cache->image[i].checksum == checksum))
+      {
+         image = &(cache->image[i]);
+         break;
+      }
+   }
+   if (!image && (cache->nimage >= EC_MAXSIICACHE))
+   {
+      return NULL;
+   }
+   catsum = ecx_siicatsum(context, slave);
+   if (!image)
+   {
+      image = &(cache->image[cache->nimage++]);
+      image->eep_man = sl->eep_man;
+      image->eep_id = sl->eep_id;
+      image->eep_rev = sl->eep_rev;
+      image->checksum = checksum;
+      image->catsum = catsum;
+      memset(image->map, 0x00, sizeof(image->map));
+   }
+   else if (image->catsum != catsum)
+   {
+      /* categories differ from the cached ones */
+      image->catsum = catsum;
+      memset(image->map, 0x00, sizeof(image->map));
+   }
+
+   return image;
+}
+
+/** Hash bucket of SII cache line.
+ *  @param[in] slave   = slave number
+ *  @param[in] block   = SII byte address / EC_SIILINESIZE
+ *  @return bucket number
+ */
+static int ecx_siipool_hash(uint16 slave, uint16 block)
+{
+   return ((slave * 131) + block) & (EC_SIIBUCKETS - 1);
+}
+
+/** Remove line from its hash bucket and mark it unused.
+ *  @param[in] pool    = per slave SII cache
+ *  @param[in] n       = line number
+ */
+static void ecx_siipool_unlink(ec_siipoolt *pool, int n)
+{
+   ec_siilinet *line = &(pool->line[n]);
+   uint16 *prev;
+
+   prev = &(pool->bucket[ecx_siipool_hash(line->slave, line->block)]);
+   while (*prev && (*prev != (n + 1)))
+   {
+      prev = &(pool->line[*prev - 1].next);
+   }
+   if (*prev)
+   {
+      *prev = line->next;
+   }
+   memset(line, 0x00, sizeof(*line));
+}
+
+/** Find line of slave SII block, allocate it if not cached. When all lines
+ *  are in use the least recently used one is evicted.
+ *  @param[in] pool    = per slave SII cache
+ *  @param[in] slave   = slave number
+ *  @param[in] block   = SII byte address / EC_SIILINESIZE
+ *  @return line
+ */
+static ec_siilinet *ecx_siipool_line(ec_siipoolt *pool, uint16 slave, uint16 block)
+{
+   ec_siilinet *line;
+   uint16 n;
+   int i, lru = -1;
+   int hash = ecx_siipool_hash(slave, block);
+
+   for (n = pool->bucket[hash]; n; n = line->next)
+   {
+      line = &(pool->line[n - 1]);
+      if ((line->slave == slave) && (line->block == block))
+      {
+         return line;
+      }
+   }
+   for (i = 0; i < EC_MAXSIILINES; i++)
+   {
+      if (!pool->line[i].slave)
+      {
+         lru = i;
+         break;
+      }
+      if ((lru < 0) || ((pool->stamp - pool->line[i].stamp) > (pool->stamp - pool->line[lru].stamp)))
+      {
+         lru = i;
+      }
+   }
+   if (pool->line[lru].slave)
+   {
+      ecx_siipool_unlink(pool, lru);
+      pool->evictions++;
+   }
+   line = &(pool->line[lru]);
+   line->slave = slave;
+   line->block = block;
+   line->next = pool->bucket[hash];
+   pool->bucket[hash] = (uint16)(lru + 1);
+
+   return line;
+}
+
+/** Per slave SII cache of the context. The pool is only used together with
+ *  the siislave table, which holds maxslave entries.
+ *  @param[in] context = context struct
+ *  @return SII pool or NULL
+ */
+static ec_siipoolt *ecx_siipoolget(ecx_contextt *context)
+{
+   return context->siislave ? context->siipool : NULL;
+}
+
+/** Select slave for SII access. Cached lines of a slave with another identity
+ *  or another SII checksum than before are dropped, the checksum is probed at
+ *  the first select after ecx_siirecheck(), f.e. after a new scan. The SII
+ *  image is looked up once per slave identity when a per slave SII cache is
+ *  used, else at every slave change.
+ *  @param[in] context = context struct
+ *  @param[in] slave   = slave number
+ *  @return SII image of slave, NULL if the slave is not in the SII image cache
+ */
+static ec_siiimaget *ecx_siiselect(ecx_contextt *context, uint16 slave)
+{
+   ec_siipoolt *pool = ecx_siipoolget(context);
+   ec_siislavet *ss;
+   ec_slavet *sl;
+   ec_siiimaget *image;
+   uint16 checksum;
+
+   if (!pool || (slave < 1))
+   {
+      return ecx_siicache_lookup(context, slave);
+   }
+   ss = &(context->siislave[slave]);
+   sl = &(context->slavelist[slave]);
+   if ((ss->eep_man != sl->eep_man) || (ss->eep_id != sl->eep_id) || (ss->eep_rev != sl->eep_rev))
+   {
+      ecx_siiflush(context, slave);
+      ss->eep_man = sl->eep_man;
+      ss->eep_id = sl->eep_id;
+      ss->eep_rev = sl->eep_rev;
+   }
+   if (!ss->checked)
+   {
+      /* a swapped or re-flashed slave of the same type has other content */
+      ecx_eeprom2master(context, slave); /* set eeprom control to master */
+      checksum = (uint16)ecx_readeepromFP(context, sl->configadr, ECT_SII_CHECKSUM, EC_TIMEOUTEEP);
+      if (checksum != ss->checksum)
+      {
+         ecx_siiflush(context, slave);
+         ss->checksum = checksum;
+      }
+      ss->checked = 1;
+   }
+   if (!ss->image)
+   {
+      image = ecx_siicache_lookup(context, slave);
+      ss->image = image ? (int16)(image - context->siicache->image) + 1 : -1;
+   }
+   if (ss->image > 0)
+   {
+      return &(context->siicache->image[ss->image - 1]);
+   }
+
+   return NULL;
+}
+
+/** Drop cached SII content, f.e. after the EEPROM was written.
+ *  @param[in] context = context struct
+ *  @param[in] slave   = slave number, 0 for all slaves
+ */
+void ecx_siiflush(ecx_contextt *context, uint16 slave)
+{
+   ec_siipoolt *pool = ecx_siipoolget(context);
+   int i;
+
+   if ((slave == 0) || (slave == context->esislave))
+   {
+      context->esislave = 0;
+      context->siiimage = NULL;
+      memset(context->esimap, 0x00, EC_MAXEEPBITMAP * sizeof(uint32)); /* clear esibuf cache map */
+   }
+   if (!pool)
+   {
+      return;
+   }
+   if (slave == 0)
+   {
+      memset(pool, 0x00, sizeof(*pool));
+      memset(context->siislave, 0x00, sizeof(ec_siislavet) * context->maxslave);
+      return;
+   }
+   for (i = 0; i < EC_MAXSIILINES; i++)
+   {
+      if (pool->line[i].slave == slave)
+      {
+         ecx_siipool_unlink(pool, i);
+      }
+   }
+   context->siislave[slave].image = 0;
+}
+
+/** Have the SII checksum of slaves with cached lines probed again at their
+ *  next access, their lines are dropped if it changed. Call when a slave may
+ *  have been replaced by another one of the same type.
+ *  @param[in] context = context struct
+ *  @param[in] slave   = slave number, 0 for all slaves
+ */
+void ecx_siirecheck(ecx_contextt *context, uint16 slave)
+{
+   ec_siipoolt *pool = ecx_siipoolget(context);
+   int i;
+
+   if ((slave == 0) || (slave == context->esislave))
+   {
+      /* select again at the next access */
+      context->esislave = 0;
+      context->siiimage = NULL;
+      memset(context->esimap, 0x00, EC_MAXEEPBITMAP * sizeof(uint32)); /* clear esibuf cache map */
+   }
+   if (!pool)
+   {
+      return;
+   }
+   if (slave == 0)
+   {
+      for (i = 0; i < context->maxslave; i++)
+      {
+         context->siislave[i].checked = 0;
+      }
+      return;
+   }
+   context->siislave[slave].checked = 0;
+}
+
+/** Attach SII image cache. A cache without valid content, f.e. new or
+ *  from another version, is cleared first. Slaves of a cached type are then
+ *  read from the cache after a probe of their SII checksum and category
+ *  layout, new types are added to the cache as they are read. Save the cache
+ *  struct to keep it for the next start.
+ *  @param[in] context = context struct
+ *  @param[in] cache   = SII image cache, NULL to stop using it
+ *  @return number of slave types in cache
+ */
+int ecx_siicache_init(ecx_contextt *context, ec_siicachet *cache)
+{
+   ec_siipoolt *pool;
+   int i;
+
+   context->siicache = NULL;
+   context->siiimage = NULL;
+   context->esislave = 0;
+   memset(context->esimap, 0x00, EC_MAXEEPBITMAP * sizeof(uint32)); /* clear esibuf cache map */
+   pool = ecx_siipoolget(context);
+   if (pool)
+   {
+      for (i = 0; i < context->maxslave; i++)
+      {
+         context->siislave[i].image = 0;
+      }
+   }
+   if (!cache)
+   {
+      return 0;
+   }
+   if ((cache->magic != EC_SIICACHE_MAGIC) || (cache->version != EC_SIICACHE_VERSION) ||
+       (cache->nimage > EC_MAXSIICACHE))
+   {
+      memset(cache, 0x00, sizeof(*cache));
+      cache->magic = EC_SIICACHE_MAGIC;
+      cache->version = EC_SIICACHE_VERSION;
+   }
+   context->siicache = cache;
+
+   return cache->nimage;
+}
+
+/** Read one 4 or 8 byte chunk from slave EEPROM.
+ *  @param[in]  context = context struct
+ *  @param[in]  slave   = slave number
+ *  @param[in]  eadr    = eeprom address in words
+ *  @param[out] buf     = buffer for the chunk
+ *  @return number of bytes read, 4 or 8 depending on the slave
+ */
+static int ecx_siiread(ecx_contextt *context, uint16 slave, uint16 eadr, uint8 *buf)
+{
+   uint64 edat64;
+   uint32 edat32;
+
+   ecx_eeprom2master(context, slave); /* set eeprom control to master */
+   edat64 = ecx_readeepromFP(context, context->slavelist[slave].configadr, eadr, EC_TIMEOUTEEP);
+   /* 8 byte response */
+   if (context->slavelist[slave].eep_8byte)
+   {
+      put_unaligned64(edat64, buf);
+      return 8;
+   }
+   /* 4 byte response */
+   edat32 = (uint32)edat64;
+   put_unaligned32(edat32, buf);
+   return 4;
+}
+
 /** Read one byte from slave EEPROM via cache.
  *  If the cache location is empty then a read request is made to the slave.
  *  Depending on the slave capabilities the request is 4 or 8 bytes.
+ *  Bytes are cached per slave when context->siipool and siislave are set,
+ *  else only for the last used slave. With an SII image cache attached the
+ *  bytes of cached slave types come from the image cache.
  *  @param[in] context = context struct
  *  @param[in] slave   = slave number
  *  @param[in] address = eeprom address in bytes (slave uses words)
@@ -333,67 +758,79 @@ void ecx_close(ecx_contextt *context)
  */
 uint8 ecx_siigetbyte(ecx_contextt *context, uint16 slave, uint16 address)
 {
-   uint16 configadr, eadr;
-   uint64 edat64;
-   uint32 edat32;
+   ec_siipoolt *pool = ecx_siipoolget(context);
+   ec_siilinet *line;
+   uint16 eadr, offs;
    uint16 mapw, mapb;
    int lp,cnt;
-   uint8 retval;
+   uint8 *esibuf;
+   uint32 *esimap;
 
-   retval = 0xff;
    if (slave != context->esislave) /* not the same slave? */
    {
       memset(context->esimap, 0x00, EC_MAXEEPBITMAP * sizeof(uint32)); /* clear esibuf cache map */
       context->esislave = slave;
+      context->siiimage = ecx_siiselect(context, slave);
    }
-   if (address < EC_MAXEEPBUF)
+   if (address >= EC_MAXEEPBUF)
    {
-      mapw = address >> 5;
-      mapb = address - (mapw << 5);
-      if (context->esimap[mapw] & (uint32)(1 << mapb))
+      return 0xff;
+   }
+   if (pool && !context->siiimage && (slave >= 1))
+   {
+      line = ecx_siipool_line(pool, slave, address / EC_SIILINESIZE);
+      line->stamp = ++pool->stamp;
+      offs = address % EC_SIILINESIZE;
+      if (line->valid & ((uint32)1 << offs))
       {
-         /* byte is already in buffer */
-         retval = context->esibuf[address];
+         pool->hits++;
       }
       else
       {
-         /* byte is not in buffer, put it there */
-         configadr = context->slavelist[slave].configadr;
-         ecx_eeprom2master(context, slave); /* set eeprom control to master */
-         eadr = address >> 1;
-         edat64 = ecx_readeepromFP (context, configadr, eadr, EC_TIMEOUTEEP);
-         /* 8 byte response */
-         if (context->slavelist[slave].eep_8byte)
-         {
-            put_unaligned64(edat64, &(context->esibuf[eadr << 1]));
-            cnt = 8;
-         }
-         /* 4 byte response */
-         else
-         {
-            edat32 = (uint32)edat64;
-            put_unaligned32(edat32, &(context->esibuf[eadr << 1]));
-            cnt = 4;
-         }
-         /* find bitmap location */
-         mapw = eadr >> 4;
-         mapb = (eadr << 1) - (mapw << 5);
-         for(lp = 0 ; lp < cnt ; lp++)
+         pool->misses++;
+         /* align the chunk so it stays within the line */
+         cnt = context->slavelist[slave].eep_8byte ? 8 : 4;
+         offs &= ~(cnt - 1);
+         eadr = (uint16)(((address / EC_SIILINESIZE) * EC_SIILINESIZE + offs) >> 1);
+         cnt = ecx_siiread(context, slave, eadr, &(line->data[offs]));
+         line->valid |= (((uint32)1 << cnt) - 1) << offs;
+      }
+      return line->data[address % EC_SIILINESIZE];
+   }
+   if (context->siiimage)
+   {
+      esibuf = context->siiimage->buf;
+      esimap = context->siiimage->map;
+   }
+   else
+   {
+      esibuf = context->esibuf;
+      esimap = context->esimap;
+   }
+   mapw = address >> 5;
+   mapb = address - (mapw << 5);
+   if (!(esimap[mapw] & (uint32)(1 << mapb)))
+   {
+      /* byte is not in buffer, put it there */
+      eadr = address >> 1;
+      cnt = ecx_siiread(context, slave, eadr, &(esibuf[eadr << 1]));
+      /* find bitmap location */
+      mapw = eadr >> 4;
+      mapb = (eadr << 1) - (mapw << 5);
+      for(lp = 0 ; lp < cnt ; lp++)
+      {
+         /* set bitmap for each byte that is read */
+         esimap[mapw] |= (1 << mapb);
+         mapb++;
+         if (mapb > 31)
          {
-            /* set bitmap for each byte that is read */
-            context->esimap[mapw] |= (1 << mapb);
-            mapb++;
-            if (mapb > 31)
-            {
-               mapb = 0;
-               mapw++;
-            }
+            mapb = 0;
+            mapw++;
          }
-         retval = context->esibuf[address];
       }
    }
 
-   return retval;
+   return esibuf[address];
 }
 
 /** Find SII section header in slave EEPROM.
@@ -904,23 +1341,726 @@ uint16 ecx_statecheck(ecx_contextt *context, uint16 slave, uint16 reqstate, int
  * @param[in] cnt     = Mailbox counter value [0..7]
  * @return next mailbox counter value
  */
-uint8 ec_nextmbxcnt(uint8 cnt)
+uint8 ec_nextmbxcnt(uint8 cnt)
+{
+   cnt++;
+   if (cnt > 7)
+   {
+      cnt = 1; /* wrap around to 1, not 0 */
+   }
+
+   return cnt;
+}
+
+/** Clear mailbox buffer.
+ * @param[out] Mbx     = Mailbox buffer to clear
+ */
+void ec_clearmbx(ec_mbxbuft *Mbx)
+{
+    memset(Mbx, 0x00, EC_MAXMBX);
+}
+
+/** Handle mailbox error, emergency and EoE fragment responses that are not
+ * meant for the caller of ecx_mbxreceive().
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  mbx        = Mailbox data
+ * @param[in]  wkc        = Work counter of mailbox read
+ * @return Work counter, 0 if the mailbox was handled here
+ */
+static int ecx_mbxhandle(ecx_contextt *context, uint16 slave, ec_mbxbuft *mbx, int wkc)
+{
+   ec_mbxheadert *mbxh;
+   ec_emcyt *EMp;
+   ec_mbxerrort *MBXEp;
+
+   mbxh = (ec_mbxheadert *)mbx;
+   if ((mbxh->mbxtype & 0x0f) == 0x00) /* Mailbox error response? */
+   {
+      MBXEp = (ec_mbxerrort *)mbx;
+      ecx_mbxerror(context, slave, etohs(MBXEp->Detail));
+      wkc = 0; /* prevent emergency to cascade up, it is already handled. */
+   }
+   else if ((mbxh->mbxtype & 0x0f) == ECT_MBXT_COE) /* CoE response? */
+   {
+      EMp = (ec_emcyt *)mbx;
+      if ((etohs(EMp->CANOpen) >> 12) == 0x01) /* Emergency request? */
+      {
+         ecx_mbxemergencyerror(context, slave, etohs(EMp->ErrorCode), EMp->ErrorReg,
+                 EMp->bData, etohs(EMp->w1), etohs(EMp->w2));
+         wkc = 0; /* prevent emergency to cascade up, it is already handled. */
+      }
+   }
+   else if ((mbxh->mbxtype & 0x0f) == ECT_MBXT_EOE) /* EoE response? */
+   {
+      ec_EOEt * eoembx = (ec_EOEt *)mbx;
+      uint16 frameinfo1 = etohs(eoembx->frameinfo1);
+      /* All non fragment data frame types are expected to be handled by
+      * slave send/receive API if the EoE hook is set
+      */
+      if (EOE_HDR_FRAME_TYPE_GET(frameinfo1) == EOE_FRAG_DATA)
+      {
+         if (context->EOEhook)
+         {
+            if (context->EOEhook(context, slave, eoembx) > 0)
+            {
+               /* Fragment handled by EoE hook */
+               wkc = 0;
+            }
+         }
+      }
+   }
+
+   return wkc;
+}
+
+/** Request the slave to repeat a lost read mailbox and wait until it is available again.
+ * @param[in]     context  = context struct
+ * @param[in]     slave    = Slave number
+ * @param[in,out] SMstat   = SM1 status, last read value on return
+ * @param[in]     timer    = Timer of the mailbox receive
+ * @param[in]     timeout  = Timeout in us
+ */
+static void ecx_mbxrepeat(ecx_contextt *context, uint16 slave, uint16 *SMstat, osal_timert *timer, int timeout)
+{
+   uint16 configadr, stat;
+   uint8 SMcontr;
+   int wkc2;
+
+   configadr = context->slavelist[slave].configadr;
+   stat = *SMstat;
+   stat ^= 0x0200; /* toggle repeat request */
+   stat = htoes(stat);
+   wkc2 = ecx_FPWR(context->port, configadr, ECT_REG_SM1STAT, sizeof(stat), &stat, EC_TIMEOUTRET);
+   stat = etohs(stat);
+   do /* wait for toggle ack */
+   {
+      wkc2 = ecx_FPRD(context->port, configadr, ECT_REG_SM1CONTR, sizeof(SMcontr), &SMcontr, EC_TIMEOUTRET);
+   } while (((wkc2 <= 0) || ((SMcontr & 0x02) != (HI_BYTE(stat) & 0x02))) && (osal_timer_is_expired(timer) == FALSE));
+   do /* wait for read mailbox available */
+   {
+      wkc2 = ecx_FPRD(context->port, configadr, ECT_REG_SM1STAT, sizeof(stat), &stat, EC_TIMEOUTRET);
+      stat = etohs(stat);
+      if (((stat & 0x08) == 0) && (timeout > EC_LOCALDELAY))
+      {
+         osal_usleep(EC_LOCALDELAY);
+      }
+   } while (((wkc2 <= 0) || ((stat & 0x08) == 0)) && (osal_timer_is_expired(timer) == FALSE));
+   *SMstat = stat;
+}
+
+/** Find cyclic mailbox slot of slave.
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @return slot or NULL if the mailbox of the slave is not handled in the process data frames
+ */
+static ec_mbxcyclicslott *ecx_mbxcyclic_find(ecx_contextt *context, uint16 slave)
+{
+   ec_mbxcyclict *mbxc = context->mbxcyclic;
+   int i;
+
+   if (mbxc)
+   {
+      for (i = 0; i < mbxc->nslots; i++)
+      {
+         if (mbxc->slot[i].slave == slave)
+         {
+            return &(mbxc->slot[i]);
+         }
+      }
+   }
+   return NULL;
+}
+
+/** Process result of the mailbox datagram of a slot and wake the thread
+ * waiting on the slot. Called with the mutex locked.
+ * @param[in]  slot       = cyclic mailbox slot
+ * @param[in]  frame      = received frame, NULL if the frame was lost
+ */
+static void ecx_mbxcyclic_result(ec_mbxcyclicslott *slot, uint8 *frame)
+{
+   uint16 le_wkc, le_stat;
+   int wkc = EC_NOFRAME;
+
+   if (frame)
+   {
+      memcpy(&le_wkc, &frame[slot->offset + slot->length], EC_WKCSIZE);
+      wkc = etohs(le_wkc);
+   }
+   switch (slot->op)
+   {
+      case EC_MBXC_STATUS:
+         if (wkc > 0)
+         {
+            memcpy(&le_stat, &frame[slot->offset], sizeof(le_stat));
+            slot->SMstat = etohs(le_stat);
+            slot->full = ((slot->SMstat & 0x08) != 0);
+         }
+         break;
+      case EC_MBXC_READ:
+         if (wkc > 0)
+         {
+            memcpy(&(slot->inbox), &frame[slot->offset], slot->length);
+            slot->rxstate = EC_MBXC_FULL;
+            slot->full = FALSE;
+            osal_sem_post(slot->sem);
+         }
+         /* without reply the slave may have emptied the mailbox */
+         else if (wkc == EC_NOFRAME)
+         {
+            slot->rxstate = EC_MBXC_LOST;
+            slot->full = FALSE;
+            osal_sem_post(slot->sem);
+         }
+         break;
+      case EC_MBXC_WRITE:
+         if ((wkc > 0) && (slot->txstate == EC_MBXC_PEND))
+         {
+            slot->txwkc = wkc;
+            slot->txstate = EC_MBXC_DONE;
+            osal_sem_post(slot->sem);
+         }
+         break;
+      default:
+         break;
+   }
+   slot->idx = -1;
+   slot->op = EC_MBXC_NONE;
+}
+
+/** Start sending process data of a group. Mailbox datagrams of the group sent
+ * earlier and never received are treated as lost.
+ * @param[in]  context    = context struct
+ * @param[in]  group      = group number
+ */
+static void ecx_mbxcyclic_begin(ecx_contextt *context, uint8 group)
+{
+   ec_mbxcyclict *mbxc = context->mbxcyclic;
+   ec_mbxcyclicslott *slot;
+   int i;
+
+   osal_mtx_lock(mbxc->mtx);
+   for (i = 0; i < mbxc->nslots; i++)
+   {
+      slot = &(mbxc->slot[i]);
+      if ((slot->idx >= 0) && (slot->group == group))
+      {
+         ecx_mbxcyclic_result(slot, NULL);
+      }
+   }
+   if (mbxc->added && mbxc->nslots)
+   {
+      mbxc->next = (mbxc->last + 1) % mbxc->nslots;
+   }
+   mbxc->added = 0;
+   osal_mtx_unlock(mbxc->mtx);
+}
+
+/** Add pending mailbox datagrams of the group to a process data frame, as far
+ * as they fit in the frame. A pending outbox is written, a full inbox is read,
+ * otherwise the SM1 status is read to see if the inbox got full.
+ * @param[in]  context    = context struct
+ * @param[in]  group      = group number, 0 for all slaves
+ * @param[in]  idx        = index of process data frame
+ */
+static void ecx_mbxcyclic_attach(ecx_contextt *context, uint8 group, uint8 idx)
+{
+   ec_mbxcyclict *mbxc = context->mbxcyclic;
+   ec_mbxcyclicslott *slot;
+   ec_slavet *sl;
+   uint16 ado, length;
+   uint8 cmd, op;
+   void *data;
+   int i, n;
+
+   osal_mtx_lock(mbxc->mtx);
+   for (n = 0; (n < mbxc->nslots) && (mbxc->added < mbxc->percycle); n++)
+   {
+      i = (mbxc->next + n) % mbxc->nslots;
+      slot = &(mbxc->slot[i]);
+      sl = &(context->slavelist[slot->slave]);
+      if ((slot->idx >= 0) || (group && (sl->group != group)))
+      {
+         continue;
+      }
+      if (slot->txstate == EC_MBXC_PEND)
+      {
+         op = EC_MBXC_WRITE;
+         cmd = EC_CMD_FPWR;
+         ado = sl->mbx_wo;
+         length = sl->mbx_l;
+         data = &(slot->outbox);
+      }
+      else if (slot->rxstate != EC_MBXC_IDLE)
+      {
+         /* previous inbox not yet taken */
+         continue;
+      }
+      else if (slot->full)
+      {
+         op = EC_MBXC_READ;
+         cmd = EC_CMD_FPRD;
+         ado = sl->mbx_ro;
+         length = sl->mbx_rl;
+         data = &(slot->inbox);
+      }
+      else
+      {
+         op = EC_MBXC_STATUS;
+         cmd = EC_CMD_FPRD;
+         ado = ECT_REG_SM1STAT;
+         length = sizeof(slot->SMstat);
+         data = &(slot->SMstat);
+      }
+      if ((context->port->txbuflength[idx] + EC_HEADERSIZE - EC_ELENGTHSIZE + length + EC_WKCSIZE) > EC_MAXTXFRAME)
+      {
+         continue;
+      }
+      slot->offset = (uint16)ecx_adddatagram(context->port, &(context->port->txbuf[idx]), cmd, idx, FALSE,
+                                             sl->configadr, ado, length, data);
+      slot->length = length;
+      slot->op = op;
+      slot->group = group;
+      slot->idx = idx;
+      mbxc->added++;
+      mbxc->last = i;
+   }
+   osal_mtx_unlock(mbxc->mtx);
+}
+
+/** Collect mailbox datagrams of a received process data frame.
+ * @param[in]  context    = context struct
+ * @param[in]  idx        = index of process data frame
+ * @param[in]  wkc        = result of ecx_waitinframe()
+ * @return number of mailbox datagrams in the frame
+ */
+static int ecx_mbxcyclic_collect(ecx_contextt *context, uint8 idx, int wkc)
+{
+   ec_mbxcyclict *mbxc = context->mbxcyclic;
+   ec_mbxcyclicslott *slot;
+   int i, cnt = 0;
+
+   osal_mtx_lock(mbxc->mtx);
+   for (i = 0; i < mbxc->nslots; i++)
+   {
+      slot = &(mbxc->slot[i]);
+      if (slot->idx == idx)
+      {
+         ecx_mbxcyclic_result(slot, (wkc > EC_NOFRAME) ? context->port->rxbuf[idx] : NULL);
+         cnt++;
+      }
+   }
+   osal_mtx_unlock(mbxc->mtx);
+
+   return cnt;
+}
+
+/** Wait until the slot semaphore is posted or the timer expires. Called with
+ * the mutex locked, it is unlocked while waiting.
+ * @param[in]  mbxc       = cyclic mailbox struct
+ * @param[in]  slot       = cyclic mailbox slot of slave
+ * @param[in]  timer      = timeout timer
+ */
+static void ecx_mbxcyclic_wait(ec_mbxcyclict *mbxc, ec_mbxcyclicslott *slot, osal_timert *timer)
+{
+   int64 left;
+
+   left = osal_timer_left_ns(timer, osal_current_time_ns());
+   if (left > 0)
+   {
+      osal_mtx_unlock(mbxc->mtx);
+      osal_sem_timedwait(slot->sem, (uint32)((left + 999) / 1000));
+      osal_mtx_lock(mbxc->mtx);
+   }
+}
+
+/** Write IN mailbox to slave with the next process data frames.
+ * @param[in]  context    = context struct
+ * @param[in]  slot       = cyclic mailbox slot of slave
+ * @param[in]  mbx        = Mailbox data
+ * @param[in]  timeout    = Timeout in us
+ * @return Work counter (>0 is success)
+ */
+static int ecx_mbxcyclic_send(ecx_contextt *context, ec_mbxcyclicslott *slot, ec_mbxbuft *mbx, int timeout)
+{
+   ec_mbxcyclict *mbxc = context->mbxcyclic;
+   osal_timert timer;
+   int wkc;
+
+   osal_timer_start(&timer, timeout);
+   osal_mtx_lock(mbxc->mtx);
+   memcpy(&(slot->outbox), mbx, context->slavelist[slot->slave].mbx_l);
+   slot->txwkc = 0;
+   slot->txstate = EC_MBXC_PEND;
+   while ((slot->txstate == EC_MBXC_PEND) && (osal_timer_is_expired(&timer) == FALSE))
+   {
+      ecx_mbxcyclic_wait(mbxc, slot, &timer);
+   }
+   wkc = (slot->txstate == EC_MBXC_DONE) ? slot->txwkc : 0;
+   slot->txstate = EC_MBXC_IDLE;
+   osal_mtx_unlock(mbxc->mtx);
+
+   return wkc;
+}
+
+/** Read OUT mailbox from slave with the next process data frames.
+ * A lost read is recovered with a repeat request outside the process data frames.
+ * @param[in]  context    = context struct
+ * @param[in]  slot       = cyclic mailbox slot of slave
+ * @param[out] mbx        = Mailbox data
+ * @param[in]  timeout    = Timeout in us
+ * @return Work counter (>0 is success), EC_TIMEOUT if no mailbox was received
+ */
+static int ecx_mbxcyclic_receive(ecx_contextt *context, ec_mbxcyclicslott *slot, ec_mbxbuft *mbx, int timeout)
+{
+   ec_mbxcyclict *mbxc = context->mbxcyclic;
+   osal_timert timer;
+   uint16 SMstat;
+   int state, wkc = 0;
+
+   osal_timer_start(&timer, timeout);
+   do
+   {
+      osal_mtx_lock(mbxc->mtx);
+      if (slot->rxstate == EC_MBXC_IDLE)
+      {
+         ecx_mbxcyclic_wait(mbxc, slot, &timer);
+      }
+      state = slot->rxstate;
+      if (state == EC_MBXC_FULL)
+      {
+         memcpy(mbx, &(slot->inbox), context->slavelist[slot->slave].mbx_rl);
+         slot->rxstate = EC_MBXC_IDLE;
+      }
+      SMstat = slot->SMstat;
+      osal_mtx_unlock(mbxc->mtx);
+      if (state == EC_MBXC_FULL)
+      {
+         wkc = ecx_mbxhandle(context, slot->slave, mbx, 1);
+      }
+      else if (state == EC_MBXC_LOST)
+      {
+         ecx_mbxrepeat(context, slot->slave, &SMstat, &timer, timeout);
+         osal_mtx_lock(mbxc->mtx);
+         slot->SMstat = SMstat;
+         slot->full = ((SMstat & 0x08) != 0);
+         slot->rxstate = EC_MBXC_IDLE;
+         osal_mtx_unlock(mbxc->mtx);
+      }
+   } while ((wkc <= 0) && (osal_timer_is_expired(&timer) == FALSE));
+
+   return (wkc > 0) ? wkc : EC_TIMEOUT;
+}
+
+/** Set up mailbox handling in the process data frames. Slaves added with
+ * ecx_mbxcyclic_add() then have their mailbox datagrams appended to the
+ * process data frames sent by ecx_send_processdata_group() instead of using
+ * frames of their own, ecx_mbxsend() and ecx_mbxreceive() wait for the
+ * process data cycle. Call while no process data is exchanged.
+ * @param[in]  context    = context struct
+ * @param[out] mbxc       = cyclic mailbox struct, NULL to stop using it
+ * @param[in]  percycle   = max. mailbox datagrams per send of process data, 0 for EC_MAXMBXCYCLIC
+ * @return 1 if OK, 0 on failure
+ */
+int ecx_mbxcyclic_init(ecx_contextt *context, ec_mbxcyclict *mbxc, int percycle)
+{
+   ec_mbxcyclict *old = context->mbxcyclic;
+   int i;
+
+   if (old)
+   {
+      context->mbxcyclic = NULL;
+      for (i = 0; i < old->nslots; i++)
+      {
+         osal_sem_destroy(old->slot[i].sem);
+         old->slot[i].sem = NULL;
+      }
+      osal_mtx_destroy(old->mtx);
+      old->mtx = NULL;
+   }
+   if (!mbxc)
+   {
+      return 1;
+   }
+   memset(mbxc, 0, sizeof(*mbxc));
+   mbxc->mtx = osal_mtx_create();
+   if (!mbxc->mtx)
+   {
+      return 0;
+   }
+   mbxc->percycle = (percycle > 0) ? percycle : EC_MAXMBXCYCLIC;
+   context->mbxcyclic = mbxc;
+
+   return 1;
+}
+
+/** Handle mailbox of slave in the process data frames.
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @return 1 if OK, 0 if not set up, slave has no mailbox or all slots are used
+ */
+int ecx_mbxcyclic_add(ecx_contextt *context, uint16 slave)
+{
+   ec_mbxcyclict *mbxc = context->mbxcyclic;
+   ec_mbxcyclicslott *slot;
+   ec_slavet *sl;
+   osal_sem_t *sem;
+
+   if (!mbxc || (slave < 1) || (slave > *(context->slavecount)))
+   {
+      return 0;
+   }
+   sl = &(context->slavelist[slave]);
+   if ((sl->mbx_l == 0) || (sl->mbx_l > EC_MAXMBX) || (sl->mbx_rl == 0) || (sl->mbx_rl > EC_MAXMBX))
+   {
+      return 0;
+   }
+   if (ecx_mbxcyclic_find(context, slave))
+   {
+      return 1;
+   }
+   if (mbxc->nslots >= EC_MAXMBXCYCLIC)
+   {
+      return 0;
+   }
+   sem = osal_sem_create(0);
+   if (!sem)
+   {
+      return 0;
+   }
+   osal_mtx_lock(mbxc->mtx);
+   slot = &(mbxc->slot[mbxc->nslots]);
+   memset(slot, 0, sizeof(*slot));
+   slot->slave = slave;
+   slot->idx = -1;
+   slot->sem = sem;
+   mbxc->nslots++;
+   osal_mtx_unlock(mbxc->mtx);
+
+   return 1;
+}
+
+/** Signed value of the system time difference register.
+ * @param[in]  reg        = ECT_REG_DCSYSDIFF in host order
+ * @return local copy of system time minus received system time in ns
+ */
+int32 ecx_dcsysdiff(uint32 reg)
+{
+   if (reg & 0x80000000)
+   {
+      return -(int32)(reg & 0x7fffffff);
+   }
+   return (int32)reg;
+}
+
+/** Add sample to the DC monitor statistics of a slave.
+ * @param[in]  mon        = DC monitor
+ * @param[in]  slave      = Slave number
+ * @param[in]  valid      = FALSE if the sample was lost
+ * @param[in]  diff       = system time difference in ns
+ */
+static void ecx_dcmon_store(ec_dcmont *mon, uint16 slave, boolean valid, int32 diff)
+{
+   ec_dcmonslavet *st = &(mon->slave[slave]);
+
+   st->seq++;
+   OSAL_MEMBAR();
+   if (valid)
+   {
+      if (!st->samples || (diff < st->min))
+      {
+         st->min = diff;
+      }
+      if (!st->samples || (diff > st->max))
+      {
+         st->max = diff;
+      }
+      st->last = diff;
+      st->sum += diff;
+      st->samples++;
+      if (diff < 0)
+      {
+         diff = -diff;
+      }
+      if (diff > mon->threshold)
+      {
+         st->over++;
+         mon->over++;
+         mon->overslave = slave;
+      }
+   }
+   else
+   {
+      st->lost++;
+   }
+   OSAL_MEMBAR();
+   st->seq++;
+}
+
+/** Start sending process data of a group. DC monitor samples of the group
+ * sent earlier and never received are counted as lost.
+ * @param[in]  context    = context struct
+ * @param[in]  group      = group number
+ */
+static void ecx_dcmon_begin(ecx_contextt *context, uint8 group)
+{
+   ec_dcmont *mon = context->dcmon;
+   int i;
+
+   if (mon->n && (mon->group == group))
+   {
+      for (i = 0; i < mon->n; i++)
+      {
+         ecx_dcmon_store(mon, mon->list[i], FALSE, 0);
+      }
+      mon->n = 0;
+   }
+}
+
+/** Add system time difference reads of the next DC slaves of the group to a
+ * process data frame, as far as they fit in the frame.
+ * @param[in]  context    = context struct
+ * @param[in]  group      = group number, 0 for all slaves
+ * @param[in]  idx        = index of process data frame
+ */
+static void ecx_dcmon_attach(ecx_contextt *context, uint8 group, uint8 idx)
+{
+   ec_dcmont *mon = context->dcmon;
+   ec_slavet *sl;
+   uint32 diff = 0;
+   uint16 slave, last;
+   int step;
+
+   if (mon->n)
+   {
+      return;
+   }
+   last = (uint16)*(context->slavecount);
+   slave = mon->next;
+   for (step = 0; (step < last) && (mon->n < mon->percycle); step++)
+   {
+      if ((slave < 1) || (slave > last))
+      {
+         slave = 1;
+      }
+      sl = &(context->slavelist[slave]);
+      if (sl->hasdc && (!group || (sl->group == group)))
+      {
+         if ((context->port->txbuflength[idx] + EC_HEADERSIZE - EC_ELENGTHSIZE + sizeof(diff) + EC_WKCSIZE) > EC_MAXTXFRAME)
+         {
+            break;
+         }
+         mon->offset[mon->n] = (uint16)ecx_adddatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_FPRD, idx, FALSE,
+                                                       sl->configadr, ECT_REG_DCSYSDIFF, sizeof(diff), &diff);
+         mon->list[mon->n++] = slave;
+      }
+      slave++;
+   }
+   mon->next = slave;
+   mon->idx = idx;
+   mon->group = group;
+}
+
+/** Collect DC monitor samples of a received process data frame.
+ * @param[in]  context    = context struct
+ * @param[in]  idx        = index of process data frame
+ * @param[in]  wkc        = result of ecx_waitinframe()
+ */
+static void ecx_dcmon_collect(ecx_contextt *context, uint8 idx, int wkc)
+{
+   ec_dcmont *mon = context->dcmon;
+   uint16 le_wkc;
+   uint32 le_diff;
+   boolean valid;
+   int i;
+
+   if (!mon->n || (mon->idx != idx))
+   {
+      return;
+   }
+   for (i = 0; i < mon->n; i++)
+   {
+      valid = FALSE;
+      le_diff = 0;
+      if (wkc > EC_NOFRAME)
+      {
+         memcpy(&le_wkc, &(context->port->rxbuf[idx][mon->offset[i] + sizeof(le_diff)]), EC_WKCSIZE);
+         if (etohs(le_wkc) > 0)
+         {
+            memcpy(&le_diff, &(context->port->rxbuf[idx][mon->offset[i]]), sizeof(le_diff));
+            valid = TRUE;
+         }
+      }
+      ecx_dcmon_store(mon, mon->list[i], valid, ecx_dcsysdiff(etohl(le_diff)));
+   }
+   mon->n = 0;
+}
+
+/** Set up DC system time difference monitor. The process data frame carrying
+ * the DC time then also reads ECT_REG_DCSYSDIFF of up to percycle DC slaves,
+ * going round all DC slaves of the group, without extra frames. Call while no
+ * process data is exchanged.
+ * @param[in]  context    = context struct
+ * @param[out] mon        = DC monitor, NULL to stop using it
+ * @param[out] slaves     = statistics table with context->maxslave entries
+ * @param[in]  percycle   = max. DC slaves sampled per cycle, 0 for EC_MAXDCMONCYCLE
+ * @param[in]  threshold  = threshold of the absolute system time difference in ns
+ * @return 1 if OK, 0 if mon is set without statistics table
+ */
+int ecx_dcmon_init(ecx_contextt *context, ec_dcmont *mon, ec_dcmonslavet *slaves, int percycle, int32 threshold)
 {
-   cnt++;
-   if (cnt > 7)
+   context->dcmon = NULL;
+   if (!mon)
    {
-      cnt = 1; /* wrap around to 1, not 0 */
+      return 1;
+   }
+   if (!slaves)
+   {
+      return 0;
+   }
+   memset(mon, 0, sizeof(*mon));
+   memset(slaves, 0, sizeof(ec_dcmonslavet) * context->maxslave);
+   mon->slave = slaves;
+   if ((percycle <= 0) || (percycle > EC_MAXDCMONCYCLE))
+   {
+      percycle = EC_MAXDCMONCYCLE;
    }
+   mon->percycle = percycle;
+   mon->threshold = threshold;
+   mon->next = 1;
+   context->dcmon = mon;
 
-   return cnt;
+   return 1;
 }
 
-/** Clear mailbox buffer.
- * @param[out] Mbx     = Mailbox buffer to clear
+/** Read consistent copy of the DC monitor statistics of a slave. Does not
+ * block the thread exchanging process data, the copy is retried when the
+ * statistics were updated while copying.
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[out] stat       = statistics of slave
+ * @return 1 if OK, 0 if the monitor is not set up or slave is out of range
  */
-void ec_clearmbx(ec_mbxbuft *Mbx)
+int ecx_dcmon_read(ecx_contextt *context, uint16 slave, ec_dcmonslavet *stat)
 {
-    memset(Mbx, 0x00, EC_MAXMBX);
+   ec_dcmont *mon = context->dcmon;
+   const ec_dcmonslavet *st;
+   uint32 seq;
+
+   if (!mon || (slave >= context->maxslave))
+   {
+      return 0;
+   }
+   st = &(mon->slave[slave]);
+   do
+   {
+      seq = st->seq;
+      OSAL_MEMBAR();
+      memcpy(stat, st, sizeof(*stat));
+      OSAL_MEMBAR();
+   } while ((seq & 1) || (seq != st->seq));
+
+   return 1;
 }
 
 /** Check if IN mailbox of slave is empty.
@@ -968,6 +2108,7 @@ int ecx_mbxempty(ecx_contextt *context, uint16 slave, int timeout)
 int ecx_mbxsend(ecx_contextt *context, uint16 slave,ec_mbxbuft *mbx, int timeout)
 {
    uint16 mbxwo,mbxl,configadr;
+   ec_mbxcyclicslott *slot;
    int wkc;
 
    wkc = 0;
@@ -975,7 +2116,12 @@ int ecx_mbxsend(ecx_contextt *context, uint16 slave,ec_mbxbuft *mbx, int timeout
    mbxl = context->slavelist[slave].mbx_l;
    if ((mbxl > 0) && (mbxl <= EC_MAXMBX))
    {
-      if (ecx_mbxempty(context, slave, timeout))
+      slot = ecx_mbxcyclic_find(context, slave);
+      if (slot)
+      {
+         wkc = ecx_mbxcyclic_send(context, slot, mbx, timeout);
+      }
+      else if (ecx_mbxempty(context, slave, timeout))
       {
          mbxwo = context->slavelist[slave].mbx_wo;
          /* write slave in mailbox */
@@ -1002,12 +2148,8 @@ int ecx_mbxreceive(ecx_contextt *context, uint16 slave, ec_mbxbuft *mbx, int tim
 {
    uint16 mbxro,mbxl,configadr;
    int wkc=0;
-   int wkc2;
    uint16 SMstat;
-   uint8 SMcontr;
-   ec_mbxheadert *mbxh;
-   ec_emcyt *EMp;
-   ec_mbxerrort *MBXEp;
+   ec_mbxcyclicslott *slot;
 
    configadr = context->slavelist[slave].configadr;
    mbxl = context->slavelist[slave].mbx_rl;
@@ -1015,6 +2157,11 @@ int ecx_mbxreceive(ecx_contextt *context, uint16 slave, ec_mbxbuft *mbx, int tim
    {
       osal_timert timer;
 
+      slot = ecx_mbxcyclic_find(context, slave);
+      if (slot)
+      {
+         return ecx_mbxcyclic_receive(context, slot, mbx, timeout);
+      }
       osal_timer_start(&timer, timeout);
       wkc = 0;
       do /* wait for read mailbox available */
@@ -1032,67 +2179,16 @@ int ecx_mbxreceive(ecx_contextt *context, uint16 slave, ec_mbxbuft *mbx, int tim
       if ((wkc > 0) && ((SMstat & 0x08) > 0)) /* read mailbox available ? */
       {
          mbxro = context->slavelist[slave].mbx_ro;
-         mbxh = (ec_mbxheadert *)mbx;
          do
          {
             wkc = ecx_FPRD(context->port, configadr, mbxro, mbxl, mbx, EC_TIMEOUTRET); /* get mailbox */
-            if ((wkc > 0) && ((mbxh->mbxtype & 0x0f) == 0x00)) /* Mailbox error response? */
-            {
-               MBXEp = (ec_mbxerrort *)mbx;
-               ecx_mbxerror(context, slave, etohs(MBXEp->Detail));
-               wkc = 0; /* prevent emergency to cascade up, it is already handled. */
-            }
-            else if ((wkc > 0) && ((mbxh->mbxtype & 0x0f) == ECT_MBXT_COE)) /* CoE response? */
-            {
-               EMp = (ec_emcyt *)mbx;
-               if ((etohs(EMp->CANOpen) >> 12) == 0x01) /* Emergency request? */
-               {
-                  ecx_mbxemergencyerror(context, slave, etohs(EMp->ErrorCode), EMp->ErrorReg,
-                          EMp->bData, etohs(EMp->w1), etohs(EMp->w2));
-                  wkc = 0; /* prevent emergency to cascade up, it is already handled. */
-               }
-            }
-            else if ((wkc > 0) && ((mbxh->mbxtype & 0x0f) == ECT_MBXT_EOE)) /* EoE response? */
+            if (wkc > 0)
             {
-               ec_EOEt * eoembx = (ec_EOEt *)mbx;
-               uint16 frameinfo1 = etohs(eoembx->frameinfo1);
-               /* All non fragment data frame types are expected to be handled by
-               * slave send/receive API if the EoE hook is set
-               */
-               if (EOE_HDR_FRAME_TYPE_GET(frameinfo1) == EOE_FRAG_DATA)
-               {
-                  if (context->EOEhook)
-                  {
-                     if (context->EOEhook(context, slave, eoembx) > 0)
-                     {
-                        /* Fragment handled by EoE hook */
-                        wkc = 0;
-                     }
-                  }
-               }
+               wkc = ecx_mbxhandle(context, slave, mbx, wkc);
             }
-            else
+            else /* read mailbox lost */
             {
-               if (wkc <= 0) /* read mailbox lost */
-               {
-                  SMstat ^= 0x0200; /* toggle repeat request */
-                  SMstat = htoes(SMstat);
-                  wkc2 = ecx_FPWR(context->port, configadr, ECT_REG_SM1STAT, sizeof(SMstat), &SMstat, EC_TIMEOUTRET);
-                  SMstat = etohs(SMstat);
-                  do /* wait for toggle ack */
-                  {
-                     wkc2 = ecx_FPRD(context->port, configadr, ECT_REG_SM1CONTR, sizeof(SMcontr), &SMcontr, EC_TIMEOUTRET);
-                   } while (((wkc2 <= 0) || ((SMcontr & 0x02) != (HI_BYTE(SMstat) & 0x02))) && (osal_timer_is_expired(&timer) == FALSE));
-                  do /* wait for read mailbox available */
-                  {
-                     wkc2 = ecx_FPRD(context->port, configadr, ECT_REG_SM1STAT, sizeof(SMstat), &SMstat, EC_TIMEOUTRET);
-                     SMstat = etohs(SMstat);
-                     if (((SMstat & 0x08) == 0) && (timeout > EC_LOCALDELAY))
-                     {
-                        osal_usleep(EC_LOCALDELAY);
-                     }
-                  } while (((wkc2 <= 0) || ((SMstat & 0x08) == 0)) && (osal_timer_is_expired(&timer) == FALSE));
-               }
+               ecx_mbxrepeat(context, slave, &SMstat, &timer, timeout);
             }
          } while ((wkc <= 0) && (osal_timer_is_expired(&timer) == FALSE)); /* if WKC<=0 repeat */
       }
@@ -1106,6 +2202,153 @@ int ecx_mbxreceive(ecx_contextt *context, uint16 slave, ec_mbxbuft *mbx, int tim
    return wkc;
 }
 
+/** Set up mailbox status poller for the slaves of a group. Slaves whose
+ * mailbox is handled in the process data frames are left out.
+ * @param[in]  context    = context struct
+ * @param[out] poll       = mailbox poller
+ * @param[out] slaves     = table of polled slaves with context->maxslave entries
+ * @param[in]  group      = group number, 0 for all slaves
+ * @return number of slaves polled
+ */
+int ecx_mbxpoll_init(ecx_contextt *context, ec_mbxpollt *poll, ec_mbxpollslavet *slaves, uint8 group)
+{
+   ec_slavet *sl;
+   uint16 slave;
+
+   memset(poll, 0, sizeof(*poll));
+   poll->slave = slaves;
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      sl = &(context->slavelist[slave]);
+      if ((sl->mbx_rl > 0) && (sl->mbx_rl <= EC_MAXMBX) &&
+          (!group || (sl->group == group)) &&
+          !ecx_mbxcyclic_find(context, slave))
+      {
+         poll->slave[poll->nslaves].slave = slave;
+         poll->slave[poll->nslaves++].SMstat = 0;
+      }
+   }
+
+   return poll->nslaves;
+}
+
+/** Read SM1 status of the polled slaves. A broadcast read first checks if
+ * the read mailbox of any slave is full, only then the status of each slave
+ * is read, with all reads batched in as few frames as possible.
+ * @param[in]  context    = context struct
+ * @param[in,out] poll    = mailbox poller, SMstat is updated
+ * @return number of slaves with full read mailbox
+ */
+int ecx_mbxpoll(ecx_contextt *context, ec_mbxpollt *poll)
+{
+   ec_multidgt dg[EC_MBXPOLLMULTI];
+   uint16 stat[EC_MBXPOLLMULTI];
+   uint16 bstat;
+   int i, k, n, wkc, cnt = 0;
+
+   poll->polls++;
+   for (i = 0; i < poll->nslaves; i++)
+   {
+      poll->slave[i].SMstat = 0;
+   }
+   if (!poll->nslaves)
+   {
+      return 0;
+   }
+   bstat = 0;
+   wkc = ecx_BRD(context->port, 0x0000, ECT_REG_SM1STAT, sizeof(bstat), &bstat, EC_TIMEOUTRET);
+   if ((wkc > 0) && ((etohs(bstat) & 0x08) == 0))
+   {
+      poll->idle++;
+      return 0;
+   }
+   for (i = 0; i < poll->nslaves; i += n)
+   {
+      n = poll->nslaves - i;
+      if (n > EC_MBXPOLLMULTI)
+      {
+         n = EC_MBXPOLLMULTI;
+      }
+      for (k = 0; k < n; k++)
+      {
+         stat[k] = 0;
+         ecx_multidg(&dg[k], EC_CMD_FPRD, context->slavelist[poll->slave[i + k].slave].configadr,
+                     ECT_REG_SM1STAT, sizeof(stat[k]), &stat[k]);
+      }
+      ecx_multirw(context->port, dg, n, EC_TIMEOUTRET);
+      for (k = 0; k < n; k++)
+      {
+         if (dg[k].wkc > 0)
+         {
+            poll->slave[i + k].SMstat = etohs(stat[k]);
+            if (poll->slave[i + k].SMstat & 0x08)
+            {
+               cnt++;
+            }
+         }
+      }
+   }
+
+   return cnt;
+}
+
+/** Poll the mailbox status and read the mailbox of the slaves that have data.
+ * Mailbox errors, emergencies and EoE fragments are handled as in
+ * ecx_mbxreceive(), other mailboxes are passed to the hook of the poller.
+ * Do not use for slaves that have a mailbox transfer running.
+ * @param[in]  context    = context struct
+ * @param[in,out] poll    = mailbox poller
+ * @return number of mailboxes read
+ */
+int ecx_mbxpoll_service(ecx_contextt *context, ec_mbxpollt *poll)
+{
+   ec_mbxbuft mbx;
+   ec_slavet *sl;
+   osal_timert timer;
+   uint16 slave;
+   int i, wkc, cnt = 0;
+
+   if (ecx_mbxpoll(context, poll) <= 0)
+   {
+      return 0;
+   }
+   for (i = 0; i < poll->nslaves; i++)
+   {
+      slave = poll->slave[i].slave;
+      if ((poll->slave[i].SMstat & 0x08) == 0)
+      {
+         continue;
+      }
+      sl = &(context->slavelist[slave]);
+      ec_clearmbx(&mbx);
+      wkc = ecx_FPRD(context->port, sl->configadr, sl->mbx_ro, sl->mbx_rl, &mbx, EC_TIMEOUTRET);
+      if (wkc <= 0) /* read mailbox lost */
+      {
+         osal_timer_start(&timer, EC_TIMEOUTRET3);
+         ecx_mbxrepeat(context, slave, &(poll->slave[i].SMstat), &timer, EC_TIMEOUTRET3);
+         if (poll->slave[i].SMstat & 0x08)
+         {
+            wkc = ecx_FPRD(context->port, sl->configadr, sl->mbx_ro, sl->mbx_rl, &mbx, EC_TIMEOUTRET);
+         }
+      }
+      if (wkc > 0)
+      {
+         poll->slave[i].SMstat &= ~0x08;
+         poll->received++;
+         cnt++;
+         if (ecx_mbxhandle(context, slave, &mbx, wkc) > 0)
+         {
+            if (!poll->hook || (poll->hook(context, slave, &mbx) <= 0))
+            {
+               poll->dropped++;
+            }
+         }
+      }
+   }
+
+   return cnt;
+}
+
 /** Dump complete EEPROM data from slave in buffer.
  * @param[in]  context  = context struct
  * @param[in]  slave    = Slave number
@@ -1178,6 +2421,7 @@ int ecx_writeeeprom(ecx_contextt *context, uint16 slave, uint16 eeproma, uint16
 
    ecx_eeprom2master(context, slave); /* set eeprom control to master */
    configadr = context->slavelist[slave].configadr;
+   ecx_siiflush(context, slave);
    return (ecx_writeeepromFP(context, configadr, eeproma, data, timeout));
 }
 
@@ -1636,19 +2880,192 @@ uint32 ecx_readeeprom2(ecx_contextt *context, uint16 slave, int timeout)
    return edat;
 }
 
+/** states of a slave in a pipelined EEPROM read */
+enum
+{
+   EC_EEPM_IDLE,
+   EC_EEPM_CLEAR,
+   EC_EEPM_CMD,
+   EC_EEPM_BUSY,
+   EC_EEPM_DATA,
+   EC_EEPM_DONE,
+   EC_EEPM_FAIL
+};
+
+/** Read EEPROM of many slaves bypassing cache.
+ * All slaves go through the same steps as ecx_readeeprom1() and ecx_readeeprom2(),
+ * each step is done for all slaves at once with the datagrams of the slaves
+ * packed in frames. The scan time then depends on the number of frames
+ * instead of the number of slaves.
+ * @param[in]  context  = context struct
+ * @param[in]  n        = number of slaves
+ * @param[in]  slave    = list of slave numbers
+ * @param[in]  eeproma  = (WORD) Address in the EEPROM
+ * @param[out] data     = list of EEPROM data 32bit, 0 if read failed
+ * @param[in]  timeout  = Timeout in us.
+ * @return number of slaves read
+ */
+int ecx_readeeprom_multi(ecx_contextt *context, int n, const uint16 *slave, uint16 eeproma, uint32 *data, int timeout)
+{
+   ec_multidgt dg[EC_EEPMULTI];
+   uint16 estat[EC_EEPMULTI];
+   uint8 state[EC_EEPMULTI], retry[EC_EEPMULTI];
+   int fs, m, i, k, active, busy, cnt = 0;
+   uint16 configadr, nop;
+   ec_eepromt ed;
+   osal_timert timer;
+
+   nop = htoes(EC_ECMD_NOP);
+   ed.comm = htoes(EC_ECMD_READ);
+   ed.addr = htoes(eeproma);
+   ed.d2   = 0x0000;
+   for (fs = 0; fs < n; fs += EC_EEPMULTI)
+   {
+      m = ((n - fs) > EC_EEPMULTI) ? EC_EEPMULTI : (n - fs);
+      for (i = 0; i < m; i++)
+      {
+         ecx_eeprom2master(context, slave[fs + i]); /* set eeprom control to master */
+         data[fs + i] = 0;
+         state[i] = EC_EEPM_IDLE;
+         retry[i] = 0;
+      }
+      osal_timer_start(&timer, timeout);
+      do
+      {
+         /* one datagram per slave for its current step */
+         k = 0;
+         for (i = 0; i < m; i++)
+         {
+            configadr = context->slavelist[slave[fs + i]].configadr;
+            dg[k].adp = configadr;
+            switch (state[i])
+            {
+               case EC_EEPM_IDLE:
+               case EC_EEPM_BUSY:
+                  estat[i] = 0;
+                  dg[k].cmd = EC_CMD_FPRD;
+                  dg[k].ado = ECT_REG_EEPSTAT;
+                  dg[k].length = sizeof(estat[i]);
+                  dg[k].data = &estat[i];
+                  break;
+               case EC_EEPM_CLEAR:
+                  dg[k].cmd = EC_CMD_FPWR;
+                  dg[k].ado = ECT_REG_EEPCTL;
+                  dg[k].length = sizeof(nop);
+                  dg[k].data = &nop;
+                  break;
+               case EC_EEPM_CMD:
+                  dg[k].cmd = EC_CMD_FPWR;
+                  dg[k].ado = ECT_REG_EEPCTL;
+                  dg[k].length = sizeof(ed);
+                  dg[k].data = &ed;
+                  break;
+               case EC_EEPM_DATA:
+                  dg[k].cmd = EC_CMD_FPRD;
+                  dg[k].ado = ECT_REG_EEPDAT;
+                  dg[k].length = sizeof(data[fs + i]);
+                  dg[k].data = &data[fs + i];
+                  break;
+               default:
+                  continue;
+            }
+            k++;
+         }
+         ecx_multirw(context->port, dg, k, EC_TIMEOUTRET);
+         /* advance slaves according to the replies */
+         k = 0;
+         active = 0;
+         busy = 0;
+         for (i = 0; i < m; i++)
+         {
+            if ((state[i] == EC_EEPM_DONE) || (state[i] == EC_EEPM_FAIL))
+            {
+               continue;
+            }
+            switch (state[i])
+            {
+               case EC_EEPM_IDLE:
+               case EC_EEPM_BUSY:
+                  estat[i] = etohs(estat[i]);
+                  if ((dg[k].wkc <= 0) || (estat[i] & EC_ESTAT_BUSY))
+                  {
+                     busy = 1;
+                  }
+                  else if (state[i] == EC_EEPM_IDLE)
+                  {
+                     state[i] = (estat[i] & EC_ESTAT_EMASK) ? EC_EEPM_CLEAR : EC_EEPM_CMD;
+                  }
+                  else if ((estat[i] & EC_ESTAT_NACK) && (retry[i]++ < EC_DEFAULTRETRIES))
+                  {
+                     /* repeat read command */
+                     state[i] = EC_EEPM_CMD;
+                  }
+                  else
+                  {
+                     retry[i] = 0;
+                     state[i] = EC_EEPM_DATA;
+                  }
+                  break;
+               case EC_EEPM_CLEAR:
+                  state[i] = EC_EEPM_CMD;
+                  break;
+               case EC_EEPM_CMD:
+               case EC_EEPM_DATA:
+                  if (dg[k].wkc > 0)
+                  {
+                     state[i]++;
+                     retry[i] = 0;
+                  }
+                  else if (retry[i]++ >= EC_DEFAULTRETRIES)
+                  {
+                     state[i] = EC_EEPM_FAIL;
+                  }
+                  break;
+               default:
+                  break;
+            }
+            if (state[i] == EC_EEPM_DONE)
+            {
+               cnt++;
+            }
+            else if (state[i] != EC_EEPM_FAIL)
+            {
+               active++;
+            }
+            k++;
+         }
+         if (busy)
+         {
+            osal_usleep(EC_LOCALDELAY);
+         }
+      } while (active && (osal_timer_is_expired(&timer) == FALSE));
+      for (i = 0; i < m; i++)
+      {
+         if (state[i] != EC_EEPM_DONE)
+         {
+            data[fs + i] = 0;
+         }
+      }
+   }
+
+   return cnt;
+}
+
 /** Push index of segmented LRD/LWR/LRW combination.
  * @param[in]  context        = context struct
  * @param[in] idx         = Used datagram index.
  * @param[in] data        = Pointer to process data segment.
  * @param[in] length      = Length of data segment in bytes.
+ * @param[in] direct      = TRUE if the driver receives the data in place.
  */
-static void ecx_pushindex(ecx_contextt *context, uint8 idx, void *data, uint16 length)
+static void ecx_pushindex(ecx_contextt *context, uint8 idx, void *data, uint16 length, boolean direct)
 {
    if(context->idxstack->pushed < EC_MAXBUF)
    {
       context->idxstack->idx[context->idxstack->pushed] = idx;
       context->idxstack->data[context->idxstack->pushed] = data;
       context->idxstack->length[context->idxstack->pushed] = length;
+      context->idxstack->direct[context->idxstack->pushed] = direct;
       context->idxstack->pushed++;
    }
 }
@@ -1681,6 +3098,25 @@ static void ecx_clearindex(ecx_contextt *context)  {
 
 }
 
+/** Fill data of a process data datagram set up without data. The outputs at
+ * the start are sent straight from the IOmap if the driver can, everything
+ * else is copied into the transmit buffer.
+ * @param[in]  context        = context struct
+ * @param[in]  idx            = index of frame
+ * @param[in]  data           = IOmap part of datagram
+ * @param[in]  length         = data length of datagram
+ * @param[in]  olength        = number of output bytes at the start of data
+ */
+static void ecx_pdtxdata(ecx_contextt *context, uint8 idx, uint8 *data, int length, int olength)
+{
+   if (!olength || !ecx_settxdirect(context->port, idx, data, olength))
+   {
+      olength = 0;
+   }
+   memcpy(&(context->port->txbuf[idx][ETH_HEADERSIZE + EC_HEADERSIZE + olength]),
+          data + olength, length - olength);
+}
+
 /** Transmit processdata to slaves.
  * Uses LRW, or LRD/LWR if LRW is not allowed (blockLRW).
  * Both the input and output processdata are transmitted.
@@ -1688,6 +3124,7 @@ static void ecx_clearindex(ecx_contextt *context)  {
  * The inputs are gathered with the receive processdata function.
  * In contrast to the base LRW function this function is non-blocking.
  * If the processdata does not fit in one datagram, multiple are used.
+ * All frames of the cycle are queued and transmitted together.
  * In order to recombine the slave response, a stack is used.
  * @param[in]  context        = context struct
  * @param[in]  group          = group number
@@ -1698,11 +3135,12 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
 {
    uint32 LogAdr;
    uint16 w1, w2;
-   int length, sublength;
+   int length, sublength, olength;
    uint8 idx;
    int wkc;
    uint8* data;
    boolean first=FALSE;
+   boolean direct;
    uint16 currentsegment = 0;
    uint32 iomapinputoffset;
 
@@ -1732,6 +3170,14 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
    {
 
       wkc = 1;
+      if (context->mbxcyclic)
+      {
+         ecx_mbxcyclic_begin(context, group);
+      }
+      if (context->dcmon)
+      {
+         ecx_dcmon_begin(context, group);
+      }
       /* LRW blocked by one or more slaves ? */
       if(context->grouplist[group].blockLRW)
       {
@@ -1765,12 +3211,23 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                   context->DCtO = ecx_adddatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_FRMW, idx, FALSE,
                                            context->slavelist[context->grouplist[group].DCnext].configadr,
                                            ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
+                  /* sample system time difference of the next DC slaves */
+                  if (context->dcmon)
+                  {
+                     ecx_dcmon_attach(context, group, idx);
+                  }
                   first = FALSE;
                }
-               /* send frame */
-               ecx_outframe_red(context->port, idx);
-               /* push index and data pointer on stack */
-               ecx_pushindex(context, idx, data, sublength);
+               /* append cyclic mailbox datagrams where the frame has room */
+               if (context->mbxcyclic)
+               {
+                  ecx_mbxcyclic_attach(context, group, idx);
+               }
+               /* queue frame, all frames of the cycle are sent at once */
+               ecx_queueframe_red(context->port, idx);
+               /* push index and data pointer on stack, LRD sends no data so
+                * the driver can not receive it in place */
+               ecx_pushindex(context, idx, data, sublength, FALSE);
                length -= sublength;
                LogAdr += sublength;
                data += sublength;
@@ -1795,7 +3252,8 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                idx = ecx_getindex(context->port);
                w1 = LO_WORD(LogAdr);
                w2 = HI_WORD(LogAdr);
-               ecx_setupdatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_LWR, idx, w1, w2, sublength, data);
+               ecx_setupdatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_LWR, idx, w1, w2, sublength, NULL);
+               ecx_pdtxdata(context, idx, data, sublength, sublength);
                if(first)
                {
                   context->DCl = sublength;
@@ -1803,12 +3261,22 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                   context->DCtO = ecx_adddatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_FRMW, idx, FALSE,
                                            context->slavelist[context->grouplist[group].DCnext].configadr,
                                            ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
+                  /* sample system time difference of the next DC slaves */
+                  if (context->dcmon)
+                  {
+                     ecx_dcmon_attach(context, group, idx);
+                  }
                   first = FALSE;
                }
-               /* send frame */
-               ecx_outframe_red(context->port, idx);
+               /* append cyclic mailbox datagrams where the frame has room */
+               if (context->mbxcyclic)
+               {
+                  ecx_mbxcyclic_attach(context, group, idx);
+               }
+               /* queue frame, all frames of the cycle are sent at once */
+               ecx_queueframe_red(context->port, idx);
                /* push index and data pointer on stack */
-               ecx_pushindex(context, idx, data, sublength);
+               ecx_pushindex(context, idx, data, sublength, FALSE);
                length -= sublength;
                LogAdr += sublength;
                data += sublength;
@@ -1836,7 +3304,19 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
             idx = ecx_getindex(context->port);
             w1 = LO_WORD(LogAdr);
             w2 = HI_WORD(LogAdr);
-            ecx_setupdatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_LRW, idx, w1, w2, sublength, data);
+            ecx_setupdatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_LRW, idx, w1, w2, sublength, NULL);
+            /* outputs part of segment */
+            olength = 0;
+            if (context->grouplist[group].Obytes &&
+                ((uint32)(data - context->grouplist[group].outputs) < context->grouplist[group].Obytes))
+            {
+               olength = context->grouplist[group].Obytes - (uint32)(data - context->grouplist[group].outputs);
+               if (olength > sublength)
+               {
+                  olength = sublength;
+               }
+            }
+            ecx_pdtxdata(context, idx, data, sublength, olength);
             if(first)
             {
                context->DCl = sublength;
@@ -1844,21 +3324,42 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                context->DCtO = ecx_adddatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_FRMW, idx, FALSE,
                                         context->slavelist[context->grouplist[group].DCnext].configadr,
                                         ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
+               /* sample system time difference of the next DC slaves */
+               if (context->dcmon)
+               {
+                  ecx_dcmon_attach(context, group, idx);
+               }
                first = FALSE;
             }
-            /* send frame */
-            ecx_outframe_red(context->port, idx);
+            /* append cyclic mailbox datagrams where the frame has room */
+            if (context->mbxcyclic)
+            {
+               ecx_mbxcyclic_attach(context, group, idx);
+            }
+            /* with a regular IOmap the inputs of the answer are received
+             * straight into the IOmap if the driver can, the returned outputs
+             * are the ones sent and stay in the rx buffer */
+            direct = FALSE;
+            if (!iomapinputoffset)
+            {
+               direct = (boolean)ecx_setrxdirect(context->port, idx, olength, data + olength,
+                                                 sublength - olength);
+            }
+            /* queue frame, all frames of the cycle are sent at once */
+            ecx_queueframe_red(context->port, idx);
             /* push index and data pointer on stack.
              * the iomapinputoffset compensate for where the inputs are stored 
              * in the IOmap if we use an overlapping IOmap. If a regular IOmap
              * is used it should always be 0.
              */
-            ecx_pushindex(context, idx, (data + iomapinputoffset), sublength);      
+            ecx_pushindex(context, idx, (data + iomapinputoffset), sublength, direct);
             length -= sublength;
             LogAdr += sublength;
             data += sublength;
          } while (length && (currentsegment < context->grouplist[group].nsegments));
       }
+      /* send all frames */
+      ecx_flushframes(context->port);
    }
 
    return wkc;
@@ -1920,6 +3421,13 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
    {
       first = TRUE;
    }
+   /* collect all frames in one go if the driver supports it,
+    * the per frame waits below then find them in the buffers */
+   if (ecx_waitinframes(context->port, &(context->idxstack->idx[context->idxstack->pulled]),
+                        context->idxstack->pushed - context->idxstack->pulled, timeout) >= 0)
+   {
+      timeout = 0;
+   }
    /* get first index */
    pos = ecx_pullindex(context);
    /* read the same number of frames as send */
@@ -1927,6 +3435,17 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
    {
       idx = context->idxstack->idx[pos];
       wkc2 = ecx_waitinframe(context->port, context->idxstack->idx[pos], timeout);
+      if (context->dcmon)
+      {
+         ecx_dcmon_collect(context, (uint8)idx, wkc2);
+      }
+      /* with cyclic mailbox datagrams appended the frame workcounter is the one
+       * of the last datagram, take the one of the process data datagram */
+      if (context->mbxcyclic && (ecx_mbxcyclic_collect(context, (uint8)idx, wkc2) > 0) && (wkc2 > EC_NOFRAME))
+      {
+         memcpy(&le_wkc, &(context->port->rxbuf[idx][EC_HEADERSIZE + context->idxstack->length[pos]]), EC_WKCSIZE);
+         wkc2 = etohs(le_wkc);
+      }
       /* check if there is input data in frame */
       if (wkc2 > EC_NOFRAME)
       {
@@ -1934,7 +3453,10 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
          {
             if(first)
             {
-               memcpy(context->idxstack->data[pos], &(context->port->rxbuf[idx][EC_HEADERSIZE]), context->DCl);
+               if (!context->idxstack->direct[pos])
+               {
+                  memcpy(context->idxstack->data[pos], &(context->port->rxbuf[idx][EC_HEADERSIZE]), context->DCl);
+               }
                memcpy(&le_wkc, &(context->port->rxbuf[idx][EC_HEADERSIZE + context->DCl]), EC_WKCSIZE);
                wkc = etohs(le_wkc);
                memcpy(&le_DCtime, &(context->port->rxbuf[idx][context->DCtO]), sizeof(le_DCtime));
@@ -1943,8 +3465,12 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
             }
             else
             {
-               /* copy input data back to process data buffer */
-               memcpy(context->idxstack->data[pos], &(context->port->rxbuf[idx][EC_HEADERSIZE]), context->idxstack->length[pos]);
+               /* copy input data back to process data buffer, unless the
+                * driver received it in place */
+               if (!context->idxstack->direct[pos])
+               {
+                  memcpy(context->idxstack->data[pos], &(context->port->rxbuf[idx][EC_HEADERSIZE]), context->idxstack->length[pos]);
+               }
                wkc += wkc2;
             }
             valid_wkc = 1;
@@ -2063,6 +3589,34 @@ uint8 ec_siigetbyte(uint16 slave, uint16 address)
    return ecx_siigetbyte (&ecx_context, slave, address);
 }
 
+/** Attach SII image cache.
+ *  @param[in] cache   = SII image cache, NULL to stop using it
+ *  @return number of slave types in cache
+ *  @see ecx_siicache_init
+ */
+int ec_siicache_init(ec_siicachet *cache)
+{
+   return ecx_siicache_init(&ecx_context, cache);
+}
+
+/** Drop cached SII content.
+ *  @param[in] slave   = slave number, 0 for all slaves
+ *  @see ecx_siiflush
+ */
+void ec_siiflush(uint16 slave)
+{
+   ecx_siiflush(&ecx_context, slave);
+}
+
+/** Have the SII checksum of slaves with cached lines probed again.
+ *  @param[in] slave   = slave number, 0 for all slaves
+ *  @see ecx_siirecheck
+ */
+void ec_siirecheck(uint16 slave)
+{
+   ecx_siirecheck(&ecx_context, slave);
+}
+
 /** Find SII section header in slave EEPROM.
  *  @param[in] slave   = slave number
  *  @param[in] cat     = section category
@@ -2200,6 +3754,83 @@ int ec_mbxreceive(uint16 slave, ec_mbxbuft *mbx, int timeout)
    return ecx_mbxreceive (&ecx_context, slave, mbx, timeout);
 }
 
+/** Set up mailbox handling in the process data frames.
+ * @param[out] mbxc       = cyclic mailbox struct, NULL to stop using it
+ * @param[in]  percycle   = max. mailbox datagrams per send of process data
+ * @return 1 if OK, 0 on failure
+ * @see ecx_mbxcyclic_init
+ */
+int ec_mbxcyclic_init(ec_mbxcyclict *mbxc, int percycle)
+{
+   return ecx_mbxcyclic_init(&ecx_context, mbxc, percycle);
+}
+
+/** Handle mailbox of slave in the process data frames.
+ * @param[in]  slave      = Slave number
+ * @return 1 if OK
+ * @see ecx_mbxcyclic_add
+ */
+int ec_mbxcyclic_add(uint16 slave)
+{
+   return ecx_mbxcyclic_add(&ecx_context, slave);
+}
+
+/** Set up DC system time difference monitor.
+ * @param[out] mon        = DC monitor, NULL to stop using it
+ * @param[out] slaves     = statistics table with EC_MAXSLAVE entries
+ * @param[in]  percycle   = max. DC slaves sampled per cycle, 0 for EC_MAXDCMONCYCLE
+ * @param[in]  threshold  = threshold of the absolute system time difference in ns
+ * @return 1 if OK
+ * @see ecx_dcmon_init
+ */
+int ec_dcmon_init(ec_dcmont *mon, ec_dcmonslavet *slaves, int percycle, int32 threshold)
+{
+   return ecx_dcmon_init(&ecx_context, mon, slaves, percycle, threshold);
+}
+
+/** Read consistent copy of the DC monitor statistics of a slave.
+ * @param[in]  slave      = Slave number
+ * @param[out] stat       = statistics of slave
+ * @return 1 if OK
+ * @see ecx_dcmon_read
+ */
+int ec_dcmon_read(uint16 slave, ec_dcmonslavet *stat)
+{
+   return ecx_dcmon_read(&ecx_context, slave, stat);
+}
+
+/** Set up mailbox status poller for the slaves of a group.
+ * @param[out] poll       = mailbox poller
+ * @param[out] slaves     = table of polled slaves with EC_MAXSLAVE entries
+ * @param[in]  group      = group number, 0 for all slaves
+ * @return number of slaves polled
+ * @see ecx_mbxpoll_init
+ */
+int ec_mbxpoll_init(ec_mbxpollt *poll, ec_mbxpollslavet *slaves, uint8 group)
+{
+   return ecx_mbxpoll_init(&ecx_context, poll, slaves, group);
+}
+
+/** Read SM1 status of the polled slaves.
+ * @param[in,out] poll    = mailbox poller
+ * @return number of slaves with full read mailbox
+ * @see ecx_mbxpoll
+ */
+int ec_mbxpoll(ec_mbxpollt *poll)
+{
+   return ecx_mbxpoll(&ecx_context, poll);
+}
+
+/** Poll the mailbox status and read the mailbox of the slaves that have data.
+ * @param[in,out] poll    = mailbox poller
+ * @return number of mailboxes read
+ * @see ecx_mbxpoll_service
+ */
+int ec_mbxpoll_service(ec_mbxpollt *poll)
+{
+   return ecx_mbxpoll_service(&ecx_context, poll);
+}
+
 /** Dump complete EEPROM data from slave in buffer.
  * @param[in]  slave    = Slave number
  * @param[out] esibuf   = EEPROM data buffer, make sure it is big enough.
@@ -2332,6 +3963,20 @@ uint32 ec_readeeprom2(uint16 slave, int timeout)
    return ecx_readeeprom2 (&ecx_context, slave, timeout);
 }
 
+/** Read EEPROM of many slaves bypassing cache.
+ * @param[in]  n        = number of slaves
+ * @param[in]  slave    = list of slave numbers
+ * @param[in]  eeproma  = (WORD) Address in the EEPROM
+ * @param[out] data     = list of EEPROM data 32bit, 0 if read failed
+ * @param[in]  timeout  = Timeout in us.
+ * @return number of slaves read
+ * @see ecx_readeeprom_multi
+ */
+int ec_readeeprom_multi(int n, const uint16 *slave, uint16 eeproma, uint32 *data, int timeout)
+{
+   return ecx_readeeprom_multi(&ecx_context, n, slave, eeproma, data, timeout);
+}
+
 /** Transmit processdata to slaves.
  * Uses LRW, or LRD/LWR if LRW is not allowed (blockLRW).
  * Both the input and output processdata are transmitted.
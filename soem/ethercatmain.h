@@ -21,8 +21,11 @@ extern "C"
 #define EC_MAXELIST       64
 /** max. length of readable name in slavelist and Object Description List */
 #define EC_MAXNAME        40
-/** max. number of slaves in array */
+/** max. number of slaves in the EC_VER1 slave array and per slave tables, the
+ * ecx_ functions use context->maxslave */
+#ifndef EC_MAXSLAVE
 #define EC_MAXSLAVE       200
+#endif
 /** max. number of groups */
 #define EC_MAXGROUP       2
 /** max. number of IO segments per group */
@@ -38,7 +41,55 @@ extern "C"
 /** max. Adapter */
 #define EC_MAXLEN_ADAPTERNAME    128
 /** define maximum number of concurrent threads in mapping */
+#ifndef EC_MAX_MAPT
 #define EC_MAX_MAPT           1
+#endif
+/** max. number of slaves in one pipelined EEPROM read step */
+#ifndef EC_EEPMULTI
+#define EC_EEPMULTI       128
+#endif
+/** max. number of slaves in one batched register access step of configuration */
+#ifndef EC_CONFIGMULTI
+#define EC_CONFIGMULTI    32
+#endif
+/** size in bytes of one line of the per slave SII cache */
+#define EC_SIILINESIZE    32
+/** number of lines of the per slave SII cache, sets its memory budget */
+#ifndef EC_MAXSIILINES
+#define EC_MAXSIILINES    512
+#endif
+/** number of hash buckets of the per slave SII cache, power of 2 */
+#define EC_SIIBUCKETS     128
+/** max. number of slave types in the SII image cache */
+#ifndef EC_MAXSIICACHE
+#define EC_MAXSIICACHE    16
+#endif
+/** max. number of SII categories probed before a cached image is used */
+#ifndef EC_MAXSIICAT
+#define EC_MAXSIICAT      64
+#endif
+/** SII image cache magic "ECSI" and layout version */
+#define EC_SIICACHE_MAGIC    0x49534345
+#define EC_SIICACHE_VERSION  2
+/** mapping snapshot identification */
+#define EC_MAPSNAP_MAGIC     0x50414d45
+#define EC_MAPSNAP_VERSION   2
+/** max. number of PDOs per SM assign list kept in a mapping snapshot */
+#ifndef EC_MAXMAPASSIGN
+#define EC_MAXMAPASSIGN   16
+#endif
+/** max. number of slaves with mailbox handled in the process data frames */
+#ifndef EC_MAXMBXCYCLIC
+#define EC_MAXMBXCYCLIC   16
+#endif
+/** max. number of status reads the mailbox poller hands to ecx_multirw() at once */
+#ifndef EC_MBXPOLLMULTI
+#define EC_MBXPOLLMULTI   64
+#endif
+/** max. number of DC slaves the DC monitor samples per process data cycle */
+#ifndef EC_MAXDCMONCYCLE
+#define EC_MAXDCMONCYCLE  8
+#endif
 
 typedef struct ec_adapter ec_adaptert;
 struct ec_adapter
@@ -340,8 +391,300 @@ typedef struct ec_idxstack
    uint8   idx[EC_MAXBUF];
    void    *data[EC_MAXBUF];
    uint16  length[EC_MAXBUF];
+   /** TRUE if the driver places the received data in data itself */
+   uint8   direct[EC_MAXBUF];
 } ec_idxstackT;
 
+/** One line of SII content of a slave */
+typedef struct ec_siiline
+{
+   /** slave number, 0 if line is unused */
+   uint16         slave;
+   /** SII byte address / EC_SIILINESIZE */
+   uint16         block;
+   /** next line in hash bucket + 1, 0 for end of chain */
+   uint16         next;
+   /** bitmap of valid bytes in data */
+   uint32         valid;
+   /** use stamp for LRU eviction */
+   uint32         stamp;
+   uint8          data[EC_SIILINESIZE];
+} ec_siilinet;
+
+/** Identity of the slave the cached lines belong to */
+typedef struct ec_siislave
+{
+   uint32         eep_man;
+   uint32         eep_id;
+   uint32         eep_rev;
+   /** SII image cache entry + 1, 0 if not looked up, -1 if none */
+   int16          image;
+   /** raw SII checksum word the cached lines were read with */
+   uint16         checksum;
+   /** checksum probed since the last scan */
+   uint8          checked;
+} ec_siislavet;
+
+/** Per slave SII cache. Lines are filled on demand and the least recently
+ * used line is evicted when all are in use. Cached lines of a slave stay
+ * valid over a new configuration as long as the slave identity and the SII
+ * checksum, probed once after each scan, are the same. The identity of each
+ * slave is kept in the siislave table of the context.
+ * A zero filled struct is an empty cache.
+ */
+typedef struct ec_siipool
+{
+   ec_siilinet    line[EC_MAXSIILINES];
+   /** first line in hash bucket + 1, 0 for empty bucket */
+   uint16         bucket[EC_SIIBUCKETS];
+   /** use counter for LRU */
+   uint32         stamp;
+   uint32         hits;
+   uint32         misses;
+   uint32         evictions;
+} ec_siipoolt;
+
+/** Cached SII content of one slave type */
+typedef struct ec_siiimage
+{
+   uint32         eep_man;
+   uint32         eep_id;
+   uint32         eep_rev;
+   /** raw SII checksum word of the slave the image was read from */
+   uint16         checksum;
+   uint16         nu1;
+   /** hash of the header and size words of the SII categories */
+   uint32         catsum;
+   /** bitmap of valid bytes in buf */
+   uint32         map[EC_MAXEEPBITMAP];
+   uint8          buf[EC_MAXEEPBUF];
+} ec_siiimaget;
+
+/** SII image cache, keyed by manufacturer, ID, revision and SII checksum of
+ * the slaves.
+ * The struct is flat and holds no pointers, so it can be saved to persistent
+ * storage as one block and mapped or loaded back at the next start.
+ */
+typedef struct ec_siicache
+{
+   uint32         magic;
+   uint16         version;
+   uint16         nimage;
+   ec_siiimaget   image[EC_MAXSIICACHE];
+} ec_siicachet;
+
+/** Mapping result of one slave in a mapping snapshot */
+typedef struct ec_mapslave
+{
+   /** entry holds a mapping */
+   uint8          valid;
+   /** topology of the slave when the mapping was taken */
+   uint8          topology;
+   uint8          activeports;
+   /** bit n set if the PDO assign list of SMn is held */
+   uint8          assignmask;
+   uint16         parent;
+   uint16         nu2;
+   uint32         eep_man;
+   uint32         eep_id;
+   uint32         eep_rev;
+   uint16         Obits;
+   uint16         Ibits;
+   ec_smt         SM[EC_MAXSM];
+   uint8          SMtype[EC_MAXSM];
+   uint8          FMMUfunc[4];
+   /** CoE PDO assign lists (0x1C10 + SM) found by mapping */
+   uint8          nassign[EC_MAXSM];
+   uint16         assign[EC_MAXSM][EC_MAXMAPASSIGN];
+} ec_mapslavet;
+
+/** Mapping snapshot, the SM layout, bit sizes and FMMU functions found by
+ * mapping, per slave position. An entry is only used when identity and
+ * topology of the slave at that position are unchanged and, for CoE slaves,
+ * the PDO assign lists read from the slave equal the stored ones. The header
+ * and the slave table are flat and can be saved as two blocks.
+ */
+typedef struct ec_mapsnap
+{
+   uint32         magic;
+   uint16         version;
+   /** number of entries in the slave table */
+   uint16         nslave;
+   /** slave table, set by ecx_mapsnap_init() */
+   ec_mapslavet   *slave;
+} ec_mapsnapt;
+
+/** DC setup result of one DC slave */
+typedef struct ec_dcdelay
+{
+   uint16         slave;
+   /** DC parent, 0 for the reference clock */
+   uint16         parent;
+   uint8          entryport;
+   /** port on the DC parent the slave is connected to */
+   uint8          parentport;
+   uint16         nu1;
+   /** latched receive time of port 0 to 3 */
+   int32          porttime[4];
+   /** propagation delay from the reference clock in ns */
+   int32          pdelay;
+   /** system time offset in ns */
+   int64          offset;
+   /** work counter of reading the latched times, writing offset and writing
+    * delay, EC_NOFRAME if the frame was lost, 0 if not written */
+   int            rdwkc;
+   int            offwkc;
+   int            delaywkc;
+   /** system time difference in ns read by ecx_dcdrift() */
+   int32          sysdiff;
+} ec_dcdelayt;
+
+/** DC setup report filled by ecx_configdc(), one entry per DC slave in DC order */
+typedef struct ec_dcreport
+{
+   /** number of entries */
+   uint16         ndc;
+   /** first DC slave, the reference clock */
+   uint16         refclock;
+   /** number of DC slaves with a failed register access */
+   uint16         nfail;
+   uint16         nu1;
+   /** largest propagation delay in ns */
+   int32          maxdelay;
+   /** number of batched register accesses */
+   int32          nmulti;
+   /** duration of the DC setup in ns */
+   int64          duration;
+   /** entries, table set by ecx_dcreport_init() */
+   ec_dcdelayt    *dc;
+} ec_dcreportt;
+
+/** States of mailboxes handled in the process data frames */
+enum
+{
+   EC_MBXC_IDLE,
+   EC_MBXC_PEND,
+   EC_MBXC_DONE,
+   EC_MBXC_FULL,
+   EC_MBXC_LOST
+};
+
+/** Mailbox of one slave handled in the process data frames */
+typedef struct ec_mbxcyclicslot
+{
+   uint16         slave;
+   /** outbox state, EC_MBXC_IDLE, EC_MBXC_PEND or EC_MBXC_DONE */
+   int            txstate;
+   /** workcounter of the outbox write */
+   int            txwkc;
+   ec_mbxbuft     outbox;
+   /** inbox state, EC_MBXC_IDLE, EC_MBXC_FULL or EC_MBXC_LOST */
+   int            rxstate;
+   ec_mbxbuft     inbox;
+   /** slave read mailbox full according to last status read */
+   boolean        full;
+   /** last read SM1 status */
+   uint16         SMstat;
+   /** internal, frame index of datagram in flight, -1 if none */
+   int            idx;
+   /** internal, group of the frame in flight */
+   uint8          group;
+   /** internal, datagram type, offset and length in the frame in flight */
+   uint8          op;
+   uint16         offset;
+   uint16         length;
+   /** internal, posted when outbox or inbox state changed by a received frame */
+   osal_sem_t     *sem;
+} ec_mbxcyclicslott;
+
+/** Mailbox datagrams carried in the process data frames, set up by ecx_mbxcyclic_init() */
+typedef struct ec_mbxcyclic
+{
+   ec_mbxcyclicslott slot[EC_MAXMBXCYCLIC];
+   int            nslots;
+   /** max. mailbox datagrams added per send of process data */
+   int            percycle;
+   /** internal, datagrams added in current send */
+   int            added;
+   /** internal, round robin start slot and last served slot */
+   int            next;
+   int            last;
+   osal_mutex_t   *mtx;
+} ec_mbxcyclict;
+
+/** System time difference statistics of one slave. Written only by the thread
+ * exchanging process data, read a consistent copy with ecx_dcmon_read().
+ */
+typedef struct ec_dcmonslave
+{
+   /** update counter, odd while the entry is written */
+   volatile uint32 seq;
+   /** number of samples */
+   uint32         samples;
+   /** samples lost with their frame */
+   uint32         lost;
+   /** samples with an absolute difference above the threshold */
+   uint32         over;
+   /** last, smallest and largest system time difference in ns */
+   int32          last;
+   int32          min;
+   int32          max;
+   /** sum of samples, the mean is sum / samples */
+   int64          sum;
+} ec_dcmonslavet;
+
+/** DC system time difference monitor, set up by ecx_dcmon_init(). Reads
+ * ECT_REG_DCSYSDIFF of a few DC slaves per cycle in the process data frame
+ * that carries the DC time, going round all DC slaves of the group.
+ */
+typedef struct ec_dcmon
+{
+   /** max. DC slaves sampled per send of process data */
+   int            percycle;
+   /** threshold of the absolute system time difference in ns */
+   int32          threshold;
+   /** samples above the threshold of all slaves */
+   volatile uint32 over;
+   /** slave of the last sample above the threshold */
+   volatile uint16 overslave;
+   /** statistics per slave number, table set by ecx_dcmon_init() */
+   ec_dcmonslavet *slave;
+   /** internal, next slave to sample */
+   uint16         next;
+   /** internal, number of datagrams in flight, their frame index and group */
+   int            n;
+   int            idx;
+   uint8          group;
+   /** internal, slave and offset in the frame of the datagrams in flight */
+   uint16         list[EC_MAXDCMONCYCLE];
+   uint16         offset[EC_MAXDCMONCYCLE];
+} ec_dcmont;
+
+/** Slave polled by the mailbox status poller */
+typedef struct ec_mbxpollslave
+{
+   uint16         slave;
+   /** SM1 status at the last poll, 0x08 is read mailbox full */
+   uint16         SMstat;
+} ec_mbxpollslavet;
+
+/** Mailbox status poller, set up by ecx_mbxpoll_init() */
+typedef struct ec_mbxpoll
+{
+   /** slaves polled, table set by ecx_mbxpoll_init() */
+   ec_mbxpollslavet *slave;
+   int            nslaves;
+   /** called by ecx_mbxpoll_service() for mailboxes not handled by the master, NULL to drop them */
+   int            (*hook)(ecx_contextt *context, uint16 slave, ec_mbxbuft *mbx);
+   /** number of polls */
+   uint32         polls;
+   /** polls answered by the broadcast read alone */
+   uint32         idle;
+   /** mailboxes read and mailboxes dropped by ecx_mbxpoll_service() */
+   uint32         received;
+   uint32         dropped;
+} ec_mbxpollt;
+
 /** ringbuf for error storage */
 typedef struct ec_ering
 {
@@ -429,6 +772,24 @@ struct ecx_context
    int            (*EOEhook)(ecx_contextt * context, uint16 slave, void * eoembx);
    /** flag to control legacy automatic state change or manual state change */
    int            manualstatechange;
+   /** mailboxes handled in the process data frames, NULL if not used */
+   ec_mbxcyclict  *mbxcyclic;
+   /** SII image cache, NULL if not used */
+   ec_siicachet   *siicache;
+   /** internal, SII image of current slave for eeprom cache */
+   ec_siiimaget   *siiimage;
+   /** per slave SII cache, NULL to cache one slave at a time in esibuf */
+   ec_siipoolt    *siipool;
+   /** identity of the slaves in siipool, table with maxslave entries */
+   ec_siislavet   *siislave;
+   /** mapping snapshot, NULL if not used */
+   ec_mapsnapt    *mapsnap;
+   /** DC setup report, NULL if not used */
+   ec_dcreportt   *dcreport;
+   /** DC system time difference monitor, NULL if not used */
+   ec_dcmont      *dcmon;
+   /** internal, lock of the error list, created by ecx_init() */
+   osal_mutex_t   *elistmtx;
 };
 
 #ifdef EC_VER1
@@ -451,6 +812,9 @@ int ec_init(const char * ifname);
 int ec_init_redundant(const char *ifname, char *if2name);
 void ec_close(void);
 uint8 ec_siigetbyte(uint16 slave, uint16 address);
+int ec_siicache_init(ec_siicachet *cache);
+void ec_siiflush(uint16 slave);
+void ec_siirecheck(uint16 slave);
 int16 ec_siifind(uint16 slave, uint16 cat);
 void ec_siistring(char *str, uint16 slave, uint16 Sn);
 uint16 ec_siiFMMU(uint16 slave, ec_eepromFMMUt* FMMU);
@@ -463,6 +827,13 @@ uint16 ec_statecheck(uint16 slave, uint16 reqstate, int timeout);
 int ec_mbxempty(uint16 slave, int timeout);
 int ec_mbxsend(uint16 slave,ec_mbxbuft *mbx, int timeout);
 int ec_mbxreceive(uint16 slave, ec_mbxbuft *mbx, int timeout);
+int ec_mbxcyclic_init(ec_mbxcyclict *mbxc, int percycle);
+int ec_mbxcyclic_add(uint16 slave);
+int ec_dcmon_init(ec_dcmont *mon, ec_dcmonslavet *slaves, int percycle, int32 threshold);
+int ec_dcmon_read(uint16 slave, ec_dcmonslavet *stat);
+int ec_mbxpoll_init(ec_mbxpollt *poll, ec_mbxpollslavet *slaves, uint8 group);
+int ec_mbxpoll(ec_mbxpollt *poll);
+int ec_mbxpoll_service(ec_mbxpollt *poll);
 void ec_esidump(uint16 slave, uint8 *esibuf);
 uint32 ec_readeeprom(uint16 slave, uint16 eeproma, int timeout);
 int ec_writeeeprom(uint16 slave, uint16 eeproma, uint16 data, int timeout);
@@ -474,6 +845,7 @@ uint64 ec_readeepromFP(uint16 configadr, uint16 eeproma, int timeout);
 int ec_writeeepromFP(uint16 configadr, uint16 eeproma, uint16 data, int timeout);
 void ec_readeeprom1(uint16 slave, uint16 eeproma);
 uint32 ec_readeeprom2(uint16 slave, int timeout);
+int ec_readeeprom_multi(int n, const uint16 *slave, uint16 eeproma, uint32 *data, int timeout);
 int ec_send_processdata_group(uint8 group);
 int ec_send_overlap_processdata_group(uint8 group);
 int ec_receive_processdata_group(uint8 group, int timeout);
@@ -494,6 +866,9 @@ int ecx_init(ecx_contextt *context, const char * ifname);
 int ecx_init_redundant(ecx_contextt *context, ecx_redportt *redport, const char *ifname, char *if2name);
 void ecx_close(ecx_contextt *context);
 uint8 ecx_siigetbyte(ecx_contextt *context, uint16 slave, uint16 address);
+int ecx_siicache_init(ecx_contextt *context, ec_siicachet *cache);
+void ecx_siiflush(ecx_contextt *context, uint16 slave);
+void ecx_siirecheck(ecx_contextt *context, uint16 slave);
 int16 ecx_siifind(ecx_contextt *context, uint16 slave, uint16 cat);
 void ecx_siistring(ecx_contextt *context, char *str, uint16 slave, uint16 Sn);
 uint16 ecx_siiFMMU(ecx_contextt *context, uint16 slave, ec_eepromFMMUt* FMMU);
@@ -506,6 +881,14 @@ uint16 ecx_statecheck(ecx_contextt *context, uint16 slave, uint16 reqstate, int
 int ecx_mbxempty(ecx_contextt *context, uint16 slave, int timeout);
 int ecx_mbxsend(ecx_contextt *context, uint16 slave,ec_mbxbuft *mbx, int timeout);
 int ecx_mbxreceive(ecx_contextt *context, uint16 slave, ec_mbxbuft *mbx, int timeout);
+int ecx_mbxcyclic_init(ecx_contextt *context, ec_mbxcyclict *mbxc, int percycle);
+int ecx_mbxcyclic_add(ecx_contextt *context, uint16 slave);
+int ecx_dcmon_init(ecx_contextt *context, ec_dcmont *mon, ec_dcmonslavet *slaves, int percycle, int32 threshold);
+int ecx_dcmon_read(ecx_contextt *context, uint16 slave, ec_dcmonslavet *stat);
+int32 ecx_dcsysdiff(uint32 reg);
+int ecx_mbxpoll_init(ecx_contextt *context, ec_mbxpollt *poll, ec_mbxpollslavet *slaves, uint8 group);
+int ecx_mbxpoll(ecx_contextt *context, ec_mbxpollt *poll);
+int ecx_mbxpoll_service(ecx_contextt *context, ec_mbxpollt *poll);
 void ecx_esidump(ecx_contextt *context, uint16 slave, uint8 *esibuf);
 uint32 ecx_readeeprom(ecx_contextt *context, uint16 slave, uint16 eeproma, int timeout);
 int ecx_writeeeprom(ecx_contextt *context, uint16 slave, uint16 eeproma, uint16 data, int timeout);
@@ -517,6 +900,7 @@ uint64 ecx_readeepromFP(ecx_contextt *context, uint16 configadr, uint16 eeproma,
 int ecx_writeeepromFP(ecx_contextt *context, uint16 configadr, uint16 eeproma, uint16 data, int timeout);
 void ecx_readeeprom1(ecx_contextt *context, uint16 slave, uint16 eeproma);
 uint32 ecx_readeeprom2(ecx_contextt *context, uint16 slave, int timeout);
+int ecx_readeeprom_multi(ecx_contextt *context, int n, const uint16 *slave, uint16 eeproma, uint32 *data, int timeout);
 int ecx_send_overlap_processdata_group(ecx_contextt *context, uint8 group);
 int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeout);
 int ecx_send_processdata(ecx_contextt *context);
@@ -49,6 +49,8 @@ extern "C"
 #define EC_TIMEOUT            -5
 /** maximum EtherCAT frame length in bytes */
 #define EC_MAXECATFRAME    1518
+/** maximum length of frame in tx buffer, ethernet CRC excluded */
+#define EC_MAXTXFRAME      (EC_MAXECATFRAME - 4)
 /** maximum EtherCAT LRW frame length in bytes */
 /* MTU - Ethernet header - length - datagram header - WCK - FCS */
 #define EC_MAXLRWDATA      (EC_MAXECATFRAME - 14 - 2 - 10 - 2 - 4)
@@ -58,8 +60,14 @@ extern "C"
 #define EC_BUFSIZE         EC_MAXECATFRAME
 /** datagram type EtherCAT */
 #define EC_ECATTYPE        0x1000
-/** number of frame buffers per channel (tx, rx1 rx2) */
+/** number of frame buffers per channel (tx, rx1 rx2). Frame index is
+ * 8 bit, so the pool can be raised up to 256 frames in flight */
+#ifndef EC_MAXBUF
 #define EC_MAXBUF          16
+#endif
+#if EC_MAXBUF > 256
+#error "EC_MAXBUF can not exceed the 8 bit frame index range"
+#endif
 /** timeout value in us for tx frame to return to rx */
 #define EC_TIMEOUTRET      2000
 /** timeout value in us for safe data transfer, max. triple retry */
@@ -298,6 +306,7 @@ enum
 /** Item offsets in SII general section */
 enum
 {
+   ECT_SII_CHECKSUM    = 0x0007,
    ECT_SII_MANUF       = 0x0008,
    ECT_SII_ID          = 0x000a,
    ECT_SII_REV         = 0x000c,
@@ -20,11 +20,11 @@
 
 /********************** Define Standard EtherCAT Master instance *********************/
 char IOmap[4096];
-ec_slavet   ec_slave[EC_MAXSLAVE];
+static ec_slavet   fsoe_slave[EC_MAXSLAVE];
 /** number of slaves found on the network */
-int         ec_slavecount;
+static int         fsoe_slavecount;
 /** slave group structure */
-ec_groupt   ec_groups[EC_MAXGROUP];
+static ec_groupt   ec_groups[EC_MAXGROUP];
 
 /** cache for EEPROM read functions */
 static uint8        esibuf[EC_MAXEEPBUF];
@@ -45,13 +45,13 @@ static ec_eepromSMt ec_SM;
 static ec_eepromFMMUt ec_FMMU;
 /** Global variable TRUE if error available in error stack */
 static boolean    AppEcatError = FALSE;
-int64         ec_DCtime;
+static int64         fsoe_DCtime;
 static ecx_portt      ecx_port_fsoe;
 
 static ecx_contextt ctx = {
    &ecx_port_fsoe,
-   &ec_slave[0],
-   &ec_slavecount,
+   &fsoe_slave[0],
+   &fsoe_slavecount,
    EC_MAXSLAVE,
    &ec_groups[0],
    EC_MAXGROUP,
@@ -63,7 +63,7 @@ static ecx_contextt ctx = {
    &AppEcatError,
    0,
    0,
-   &ec_DCtime,
+   &fsoe_DCtime,
    &ec_SMcommtype,
    &ec_PDOassign,
    &ec_PDOdesc,
@@ -71,7 +71,16 @@ static ecx_contextt ctx = {
    &ec_FMMU,
    NULL,
    NULL,
-   0
+   0,
+   NULL,
+   NULL,
+   NULL,
+   NULL,
+   NULL,
+   NULL,
+   NULL,
+   NULL,
+   NULL
 };
 
 /******************************* Local FSoE Master variables ********************************/
@@ -354,10 +363,36 @@ void safety_setup(void)
    }
 }
 
+static int oloop, iloop, expectedWKC;
+
+/* Cyclic executor hook, called every cycle after process data exchange */
+static void fsoe_cycle(ec_cyclict *cyclic, int wkc)
+{
+   int j;
+
+   /* Call the safety application */
+   safety_app();
+
+   if (wkc >= expectedWKC)
+   {
+      printf("Processdata cycle %4d, WKC %d , O:", cyclic->stat.cycles + 1, wkc);
+      for (j = 0; j < oloop; j++)
+      {
+         printf(" %2.2x", *(ctx.slavelist[0].outputs + j));
+      }
+      printf(" I:");
+      for (j = 0; j < iloop; j++)
+      {
+         printf(" %2.2x", *(ctx.slavelist[0].inputs + j));
+      }
+      printf("\r");
+   }
+}
+
 void fsoemaster(char *ifname)
 {
-   int i, j, oloop, iloop, expectedWKC, chk;
-   volatile int wkc;
+   int i, chk;
+   ec_cyclict cyclic;
 
    printf("Starting FSoE Master\n");
 
@@ -371,7 +406,7 @@ void fsoemaster(char *ifname)
       /* find and auto-config slaves */
       if (ecx_config_init(&ctx, FALSE) > 0)
       {
-         printf("%d slaves found and configured.\n", ec_slavecount);
+         printf("%d slaves found and configured.\n", *ctx.slavecount);
          ecx_config_map_group(&ctx, &IOmap, 0);
          memset(IOmap, 0, sizeof(IOmap));
          /* read individual slave state and store in ec_slave[] */
@@ -405,35 +440,22 @@ void fsoemaster(char *ifname)
             ecx_send_processdata(&ctx);
             ecx_receive_processdata(&ctx, EC_TIMEOUTRET3/*EC_TIMEOUTRET*/);
             ecx_statecheck(&ctx, 0, EC_STATE_OPERATIONAL, 50000);
-         } while (chk-- && (ec_slave[0].state != EC_STATE_OPERATIONAL));
-         if (ec_slave[0].state == EC_STATE_OPERATIONAL)
+         } while (chk-- && (ctx.slavelist[0].state != EC_STATE_OPERATIONAL));
+         if (ctx.slavelist[0].state == EC_STATE_OPERATIONAL)
          {
             printf("Operational state reached for all slaves.\n");
-            /* cyclic loop */
-            for (i = 1; i <= 100000; i++)
+            /* cyclic loop, 2ms cycle */
+            ecx_cyclic_init(&cyclic, &ctx, 0, 2000000, fsoe_cycle, NULL);
+            cyclic.timeout = EC_TIMEOUTRET * 10;
+            ecx_cyclic_run(&cyclic, 100000);
+            printf("\nCycles %u, overruns %u, jitter min %" PRId64 " max %" PRId64 " mean %" PRId64 " ns\n",
+               cyclic.stat.cycles, cyclic.stat.overruns, cyclic.stat.minjitter,
+               cyclic.stat.maxjitter, cyclic.stat.sumjitter / (int64)cyclic.stat.cycles);
+            for (i = 0; i < EC_CYCLIC_HISTBINS - 1; i++)
             {
-               ecx_send_processdata(&ctx);
-               wkc = ecx_receive_processdata(&ctx, EC_TIMEOUTRET * 10);
-
-               /* Call the safety application */
-               safety_app();
-
-               if (wkc >= expectedWKC)
-               {
-                  printf("Processdata cycle %4d, WKC %d , O:", i, wkc);
-                  for (j = 0; j < oloop; j++)
-                  {
-                     printf(" %2.2x", *(ctx.slavelist[0].outputs + j));
-                  }
-                  printf(" I:");
-                  for (j = 0; j < iloop; j++)
-                  {
-                     printf(" %2.2x", *(ctx.slavelist[0].inputs + j));
-                  }
-                  printf("\r");
-               }
-               osal_usleep(2000);
+               printf("  < %4d us: %u\n", (i + 1) * EC_CYCLIC_HISTWIDTH / 1000, cyclic.stat.hist[i]);
             }
+            printf(" >= %4d us: %u\n", i * EC_CYCLIC_HISTWIDTH / 1000, cyclic.stat.hist[i]);
          }
          else
          {
@@ -1,10 +1,11 @@
 /** \file
  * \brief Example code for Simple Open EtherCAT master
  *
- * Usage : slaveinfo [ifname] [-sdo] [-map]
+ * Usage : slaveinfo [ifname] [-sdo] [-map] [-sii file]
  * Ifname is NIC interface, f.e. eth0.
  * Optional -sdo to display CoE object dictionary.
  * Optional -map to display slave PDO mapping
+ * Optional -sii to keep an SII image cache in file
  *
  * This shows the configured slave data.
  *
@@ -14,6 +15,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "ethercat.h"
 
@@ -24,6 +29,9 @@ boolean printSDO = FALSE;
 boolean printMAP = FALSE;
 char usdo[128];
 char hstr[1024];
+char *siifile = NULL;
+ec_siicachet siicachebuf;
+ec_siicachet *siicache = NULL;
 
 char* dtype2string(uint16 dtype)
 {
@@ -505,6 +513,52 @@ void si_sdo(int cnt)
     }
 }
 
+/* map SII cache file copy on write, the file itself is only replaced by siicache_save() */
+void siicache_load(void)
+{
+   struct stat st;
+   void *p = MAP_FAILED;
+   int fd;
+
+   fd = open(siifile, O_RDONLY);
+   if (fd >= 0)
+   {
+      if ((fstat(fd, &st) == 0) && (st.st_size == sizeof(ec_siicachet)))
+      {
+         p = mmap(NULL, sizeof(ec_siicachet), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      }
+      close(fd);
+   }
+   siicache = (p != MAP_FAILED) ? (ec_siicachet *)p : &siicachebuf;
+   printf("SII cache %s : %d slave types\n", siifile, ec_siicache_init(siicache));
+}
+
+void siicache_save(void)
+{
+   char tmpname[1024];
+   FILE *f;
+
+   ec_siicache_init(NULL);
+   snprintf(tmpname, sizeof(tmpname), "%s.tmp", siifile);
+   f = fopen(tmpname, "wb");
+   if (f)
+   {
+      if ((fwrite(siicache, sizeof(ec_siicachet), 1, f) == 1) && (fclose(f) == 0))
+      {
+         rename(tmpname, siifile);
+      }
+      else
+      {
+         remove(tmpname);
+      }
+   }
+   if (siicache != &siicachebuf)
+   {
+      munmap(siicache, sizeof(ec_siicachet));
+   }
+   siicache = NULL;
+}
+
 void slaveinfo(char *ifname)
 {
    int cnt, i, j, nSM;
@@ -517,6 +571,10 @@ void slaveinfo(char *ifname)
    if (ec_init(ifname))
    {
       printf("ec_init on %s succeeded.\n",ifname);
+      if (siifile)
+      {
+         siicache_load();
+      }
       /* find and auto-config slaves */
       if ( ec_config(FALSE, &IOmap) > 0 )
       {
@@ -607,6 +665,10 @@ void slaveinfo(char *ifname)
       {
          printf("No slaves found!\n");
       }
+      if (siicache)
+      {
+         siicache_save();
+      }
       printf("End slaveinfo, close socket\n");
       /* stop SOEM, close socket */
       ec_close();
@@ -626,15 +688,21 @@ int main(int argc, char *argv[])
 
    if (argc > 1)
    {
+      int i;
+
       if ((argc > 2) && (strncmp(argv[2], "-sdo", sizeof("-sdo")) == 0)) printSDO = TRUE;
       if ((argc > 2) && (strncmp(argv[2], "-map", sizeof("-map")) == 0)) printMAP = TRUE;
+      for (i = 2; i < (argc - 1); i++)
+      {
+         if (strncmp(argv[i], "-sii", sizeof("-sii")) == 0) siifile = argv[i + 1];
+      }
       /* start slaveinfo */
       strcpy(ifbuf, argv[1]);
       slaveinfo(ifbuf);
    }
    else
    {
-      printf("Usage: slaveinfo ifname [options]\nifname = eth0 for example\nOptions :\n -sdo : print SDO info\n -map : print mapping\n");
+      printf("Usage: slaveinfo ifname [options]\nifname = eth0 for example\nOptions :\n -sdo : print SDO info\n -map : print mapping\n -sii file : keep SII image cache in file\n");
 
       printf ("Available adapters\n");
       adapter = ec_find_adapters ();